@@ -0,0 +1,349 @@
+// hc_benchmark_kernels.cxx
+// Standard libraries :
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <new>
+#include <vector>
+
+// Third party:
+// - Boost:
+#include <boost/program_options.hpp>
+
+// - Bayeux/datatools:
+#include <datatools/utils.h>
+#include <datatools/properties.h>
+#include <datatools/clhep_units.h>
+// - Bayeux/geomtools:
+#include <bayeux/geomtools/id_mgr.h>
+#include <bayeux/geomtools/id_selector.h>
+// - Bayeux/mctools:
+#include <mctools/simulated_data.h>
+
+// Falaise:
+#include <falaise/falaise.h>
+
+// This project :
+#include "calo_hit_accumulator.hpp"
+#include "compiled_id_selector.hpp"
+#include "data_statistics_simu.hpp"
+#include "event_analyzer.hpp"
+#include "event_sorter.hpp"
+#include "geometry_context.hpp"
+#include "geiger_cell_table.hpp"
+#include "hc_constants.hpp"
+#include "processing_statistics.hpp"
+#include "synthetic_event_generator.hpp"
+
+// Every heap allocation of the program is counted :
+namespace {
+  std::atomic<uint64_t> number_of_allocations(0);
+}
+
+void * operator new(std::size_t size_)
+{
+  number_of_allocations++;
+  void * pointer = std::malloc(size_ == 0 ? 1 : size_);
+  if (pointer == nullptr) throw std::bad_alloc();
+  return pointer;
+}
+
+void operator delete(void * pointer_) noexcept
+{
+  std::free(pointer_);
+}
+
+/// Time and allocations of a kernel over all the events of all passes
+struct kernel_result
+{
+  std::string name;
+  uint64_t events = 0;
+  uint64_t wall_ns = 0;
+  uint64_t allocations = 0;
+};
+
+/// Compile the mapping rules of a file, or select the whole category without file
+void initialize_selector(compiled_id_selector & selector_,
+			 const std::string & mapping_config_,
+			 const geomtools::id_mgr & id_mgr_,
+			 const std::string & category_,
+			 const std::string & default_rules_);
+
+int main( int  argc_ , char **argv_  )
+{
+  falaise::initialize(argc_, argv_);
+  int error_code = EXIT_SUCCESS;
+  datatools::logger::priority logging = datatools::logger::PRIO_FATAL;
+
+  try {
+
+    std::size_t number_of_events = 1000;
+    std::size_t number_of_passes = 10;
+    uint64_t    seed = 1;
+    std::string calo_mapping_config = "";
+    std::string tracker_mapping_config = "";
+    double      calo_threshold_kev  = 0;
+    double      geiger_dead_time_us = 0;
+    synthetic_event_generator generator;
+
+    // Parse options:
+    namespace po = boost::program_options;
+    po::options_description opts("Allowed options");
+    opts.add_options()
+      ("help,h", "produce help message")
+      ("number_events,n",
+       po::value<std::size_t>(& number_of_events)->default_value(1000),
+       "set the number of synthetic events, generated once and kept in memory")
+      ("passes,p",
+       po::value<std::size_t>(& number_of_passes)->default_value(10),
+       "set the number of timed passes on the events of each kernel (after one warm-up pass)")
+      ("seed",
+       po::value<uint64_t>(& seed)->default_value(1),
+       "set the seed of the synthetic event generator")
+      ("calo-oms",
+       po::value<double>(& generator.mean_calo_oms)->default_value(2),
+       "set the mean number of OMs hit per event")
+      ("calo-steps",
+       po::value<double>(& generator.mean_calo_steps_per_om)->default_value(10),
+       "set the mean number of calo step hits per OM")
+      ("geiger-cells",
+       po::value<double>(& generator.mean_geiger_cells)->default_value(20),
+       "set the mean number of Geiger cells hit per event")
+      ("geiger-steps",
+       po::value<double>(& generator.mean_geiger_steps_per_cell)->default_value(3),
+       "set the mean number of Geiger step hits per cell")
+      ("calo-threshold,c",
+       po::value<double>(& calo_threshold_kev)->default_value(hc_constants::CALO_COMMISSIONING_HIGH_THRESHOLD_KEV),
+       "set the calorimeter threshold in keV")
+      ("geiger-dead-time",
+       po::value<double>(& geiger_dead_time_us),
+       "set the Geiger cell dead time in microseconds (default : a cell fires only once per event)")
+      ("calo_mapping,C",
+       po::value<std::string>(& calo_mapping_config),
+       "set the calorimeter mapping configuration from a datatools::properties ASCII file (default : all OMs)")
+      ("tracker_mapping,T",
+       po::value<std::string>(& tracker_mapping_config),
+       "set the tracker mapping configuration from a datatools::properties ASCII file (default : all cells)")
+      ; // end of options description
+
+    // Describe command line arguments :
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc_, argv_)
+	      .options(opts)
+	      .run(), vm);
+    po::notify(vm);
+
+    // Use command line arguments :
+    if (vm.count("help")) {
+      std::cout << "Usage : " << std::endl;
+      std::cout << opts << std::endl;
+      return(1);
+    }
+
+    DT_THROW_IF(number_of_events == 0 || number_of_passes == 0, std::logic_error, "No event or no pass to benchmark !");
+
+    std::clog << "INFO : Micro-benchmarks of the analysis kernels on synthetic events" << std::endl;
+
+    // Only the geom ID categories are needed, the geometry is not built :
+    geometry_context my_geometry;
+    my_geometry.initialize(false);
+    const geomtools::id_mgr & my_id_mgr = my_geometry.get_id_mgr();
+
+    compiled_id_selector calo_selector;
+    initialize_selector(calo_selector, calo_mapping_config, my_id_mgr, compiled_id_selector::calo_category(),
+			"category='calorimeter_block' module={*} side={*} column={*} row={*}");
+    compiled_id_selector geiger_selector;
+    initialize_selector(geiger_selector, tracker_mapping_config, my_id_mgr, compiled_id_selector::geiger_category(),
+			"category='drift_cell_core' module={*} side={*} layer={*} row={*}");
+
+    // Synthetic events, generated once :
+    generator.calo_type = my_id_mgr.get_category_info(compiled_id_selector::calo_category()).get_type();
+    generator.geiger_type = my_id_mgr.get_category_info(compiled_id_selector::geiger_category()).get_type();
+    generator.engine.seed(seed);
+    std::vector<mctools::simulated_data> events(number_of_events);
+    uint64_t number_of_calo_steps = 0;
+    uint64_t number_of_geiger_steps = 0;
+    for (std::size_t ievent = 0; ievent < events.size(); ievent++) {
+      generator.generate(events[ievent]);
+      if (events[ievent].has_step_hits("calo")) number_of_calo_steps += events[ievent].get_number_of_step_hits("calo");
+      if (events[ievent].has_step_hits("gg")) number_of_geiger_steps += events[ievent].get_number_of_step_hits("gg");
+    }
+    std::clog << "INFO : " << events.size() << " events, "
+	      << double(number_of_calo_steps) / events.size() << " calo step hits and "
+	      << double(number_of_geiger_steps) / events.size() << " Geiger step hits per event" << std::endl;
+
+    double geiger_dead_time;
+    datatools::invalidate(geiger_dead_time);
+    if (vm.count("geiger-dead-time")) geiger_dead_time = geiger_dead_time_us * CLHEP::microsecond;
+
+    // Run a kernel on all events, one warm-up pass then the timed passes :
+    std::vector<kernel_result> results;
+    auto run_kernel = [&] (const std::string & name_, const std::function<void(const mctools::simulated_data &)> & kernel_)
+      {
+	for (std::size_t ievent = 0; ievent < events.size(); ievent++) kernel_(events[ievent]);
+	kernel_result result;
+	result.name = name_;
+	const uint64_t allocations_start = number_of_allocations;
+	const uint64_t wall_start_ns = processing_statistics::wall_clock_ns();
+	for (std::size_t ipass = 0; ipass < number_of_passes; ipass++) {
+	  for (std::size_t ievent = 0; ievent < events.size(); ievent++) kernel_(events[ievent]);
+	}
+	result.wall_ns = processing_statistics::wall_clock_ns() - wall_start_ns;
+	result.allocations = number_of_allocations - allocations_start;
+	result.events = number_of_passes * events.size();
+	results.push_back(result);
+      };
+
+    // Calo merging : step hits summed by OM, then threshold and selector cuts
+    calo_hit_accumulator calo_oms;
+    std::vector<calo_hit_summary> calo_hits;
+    run_kernel("calo_merge", [&] (const mctools::simulated_data & SD_)
+	       {
+		 calo_oms.reset();
+		 calo_hits.clear();
+		 if (!SD_.has_step_hits("calo")) return;
+		 const mctools::simulated_data::hit_handle_collection_type & BSHC = SD_.get_step_hits("calo");
+		 for (std::size_t ihit = 0; ihit < BSHC.size(); ihit++) calo_oms.add(BSHC[ihit].get());
+		 calo_oms.extract(calo_selector, calo_threshold_kev, calo_hits);
+	       });
+
+    // Geiger re-hit flagging : fires of each cell, then re-hits
+    geiger_cell_table geiger_cells;
+    std::vector<std::size_t> geiger_hit_cells;
+    volatile std::size_t number_of_fired = 0;
+    run_kernel("geiger_flag", [&] (const mctools::simulated_data & SD_)
+	       {
+		 if (!SD_.has_step_hits("gg")) return;
+		 const mctools::simulated_data::hit_handle_collection_type & BSHC_gg = SD_.get_step_hits("gg");
+		 geiger_cells.reset();
+		 geiger_hit_cells.resize(BSHC_gg.size());
+		 for (std::size_t ihit = 0; ihit < BSHC_gg.size(); ihit++) {
+		   const mctools::base_step_hit & BSH = BSHC_gg[ihit].get();
+		   const std::size_t cell = geiger_cell_table::cell_index(BSH.get_geom_id());
+		   geiger_hit_cells[ihit] = cell;
+		   if (cell != geiger_cell_table::INVALID_CELL) geiger_cells.add_hit(cell, ihit, BSH.get_time_start());
+		 }
+		 geiger_cells.select_fires(geiger_dead_time);
+		 std::size_t fired = 0;
+		 for (std::size_t ihit = 0; ihit < BSHC_gg.size(); ihit++) {
+		   const std::size_t cell = geiger_hit_cells[ihit];
+		   if (cell == geiger_cell_table::INVALID_CELL) continue;
+		   if (!geiger_cells.is_rehit(ihit)) fired++;
+		 }
+		 number_of_fired = number_of_fired + fired;
+	       });
+
+    // Selector matching : every calo and Geiger step hit geom ID
+    volatile std::size_t number_of_matches = 0;
+    run_kernel("selector_match", [&] (const mctools::simulated_data & SD_)
+	       {
+		 std::size_t matches = 0;
+		 if (SD_.has_step_hits("calo")) {
+		   const mctools::simulated_data::hit_handle_collection_type & BSHC = SD_.get_step_hits("calo");
+		   for (std::size_t ihit = 0; ihit < BSHC.size(); ihit++) matches += calo_selector.match(BSHC[ihit].get().get_geom_id());
+		 }
+		 if (SD_.has_step_hits("gg")) {
+		   const mctools::simulated_data::hit_handle_collection_type & BSHC_gg = SD_.get_step_hits("gg");
+		   for (std::size_t ihit = 0; ihit < BSHC_gg.size(); ihit++) matches += geiger_selector.match(BSHC_gg[ihit].get().get_geom_id());
+		 }
+		 number_of_matches = number_of_matches + matches;
+	       });
+
+    event_analyzer analyzer;
+    analyzer.calo_selector = &calo_selector;
+    analyzer.geiger_selector = &geiger_selector;
+    analyzer.calo_threshold_kev = calo_threshold_kev;
+    analyzer.geiger_dead_time = geiger_dead_time;
+    analyzer.logging = logging;
+
+    // Histogram filling : the products of each event are built out of the
+    // timed region, the clock overhead of the per event timing is removed
+    data_statistics_simu fill_dss;
+    fill_dss.initialize();
+    uint64_t clock_overhead_ns = 0;
+    {
+      const std::size_t number_of_probes = 100000;
+      const uint64_t start_ns = processing_statistics::wall_clock_ns();
+      for (std::size_t iprobe = 0; iprobe < number_of_probes; iprobe++) processing_statistics::wall_clock_ns();
+      clock_overhead_ns = (processing_statistics::wall_clock_ns() - start_ns) / number_of_probes;
+    }
+    {
+      kernel_result result;
+      result.name = "histogram_fill";
+      for (std::size_t ipass = 0; ipass <= number_of_passes; ipass++) {
+	for (std::size_t ievent = 0; ievent < events.size(); ievent++) {
+	  analyzer.process(events[ievent]);
+	  const uint64_t allocations_start = number_of_allocations;
+	  const uint64_t wall_start_ns = processing_statistics::wall_clock_ns();
+	  analyzer.fill(fill_dss);
+	  const uint64_t wall_ns = processing_statistics::wall_clock_ns() - wall_start_ns;
+	  const uint64_t allocations = number_of_allocations - allocations_start;
+	  // The first pass is the warm-up :
+	  if (ipass == 0) continue;
+	  result.wall_ns += wall_ns > clock_overhead_ns ? wall_ns - clock_overhead_ns : 0;
+	  result.allocations += allocations;
+	  result.events++;
+	}
+      }
+      results.push_back(result);
+    }
+
+    // Full per event loop : sorting rules, analysis and histograms
+    event_sorter sorter;
+    sorter.calo_selector = &calo_selector;
+    sorter.geiger_selector = &geiger_selector;
+    sorter.logging = logging;
+    data_statistics_simu full_dss;
+    full_dss.initialize();
+    run_kernel("full_event", [&] (const mctools::simulated_data & SD_)
+	       {
+		 sorter.process(SD_);
+		 analyzer.process(SD_);
+		 analyzer.fill(full_dss);
+	       });
+
+    std::cout << std::left << std::setw(18) << "kernel"
+	      << std::right << std::setw(12) << "events"
+	      << std::setw(14) << "ns/event"
+	      << std::setw(16) << "allocs/event" << std::endl;
+    for (std::size_t iresult = 0; iresult < results.size(); iresult++) {
+      const kernel_result & result = results[iresult];
+      std::cout << std::left << std::setw(18) << result.name
+		<< std::right << std::setw(12) << result.events
+		<< std::setw(14) << std::fixed << std::setprecision(1) << double(result.wall_ns) / result.events
+		<< std::setw(16) << std::setprecision(3) << double(result.allocations) / result.events << std::endl;
+    }
+
+    std::clog << "The end." << std::endl;
+  } // end of try
+
+  catch (std::exception & error) {
+    DT_LOG_FATAL(logging, error.what());
+    error_code = EXIT_FAILURE;
+  }
+
+  catch (...) {
+    DT_LOG_FATAL(logging, "Unexpected error!");
+    error_code = EXIT_FAILURE;
+  }
+
+  falaise::terminate();
+  return error_code;
+}
+
+void initialize_selector(compiled_id_selector & selector_,
+			 const std::string & mapping_config_,
+			 const geomtools::id_mgr & id_mgr_,
+			 const std::string & category_,
+			 const std::string & default_rules_)
+{
+  if (!mapping_config_.empty()) {
+    selector_.initialize(mapping_config_, id_mgr_, category_);
+    return;
+  }
+  geomtools::id_selector selector(id_mgr_);
+  selector.initialize(default_rules_);
+  selector_.initialize(selector, id_mgr_, category_);
+  return;
+}
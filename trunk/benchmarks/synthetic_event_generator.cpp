@@ -0,0 +1,82 @@
+//! \file synthetic_event_generator.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/clhep_units.h>
+
+// Ourselves:
+#include <synthetic_event_generator.hpp>
+
+// This project :
+#include "hc_constants.hpp"
+
+void synthetic_event_generator::generate(mctools::simulated_data & SD_)
+{
+  SD_.reset();
+  std::uniform_int_distribution<uint32_t> side_distribution(0, hc_constants::NUMBER_OF_SIDES - 1);
+  std::uniform_real_distribution<double> unit_distribution(0, 1);
+  std::exponential_distribution<double> step_energy_distribution(1. / (50 * CLHEP::keV));
+  int hit_id = 0;
+
+  // Calorimeter : a few OMs with several steps each, around the same time
+  std::poisson_distribution<uint32_t> calo_oms_distribution(mean_calo_oms);
+  std::poisson_distribution<uint32_t> calo_steps_distribution(mean_calo_steps_per_om);
+  std::uniform_int_distribution<uint32_t> column_distribution(0, hc_constants::NUMBER_OF_CALO_COLUMNS - 1);
+  std::uniform_int_distribution<uint32_t> calo_row_distribution(0, hc_constants::NUMBER_OF_CALO_PER_COLUMN - 1);
+  std::uniform_int_distribution<uint32_t> part_distribution(0, 1);
+  const uint32_t number_of_oms = calo_oms_distribution(engine);
+  for (uint32_t iom = 0; iom < number_of_oms; iom++)
+    {
+      const uint32_t side = side_distribution(engine);
+      const uint32_t column = column_distribution(engine);
+      const uint32_t row = calo_row_distribution(engine);
+      const double om_time = 50 * CLHEP::ns * unit_distribution(engine);
+      const uint32_t number_of_steps = 1 + calo_steps_distribution(engine);
+      for (uint32_t istep = 0; istep < number_of_steps; istep++)
+	{
+	  mctools::base_step_hit & BSH = SD_.add_step_hit("calo");
+	  BSH.set_hit_id(hit_id++);
+	  BSH.set_geom_id(geomtools::geom_id(calo_type, 0, side, column, row, part_distribution(engine)));
+	  BSH.set_energy_deposit(step_energy_distribution(engine));
+	  BSH.set_time_start(om_time + 2 * CLHEP::ns * unit_distribution(engine));
+	  BSH.set_time_stop(BSH.get_time_start() + 0.1 * CLHEP::ns);
+	  const geomtools::vector_3d position((side == 0 ? -1 : 1) * 435 * CLHEP::mm,
+					      (column - 9.5) * 259 * CLHEP::mm + 100 * CLHEP::mm * (unit_distribution(engine) - 0.5),
+					      (row - 6.) * 259 * CLHEP::mm + 100 * CLHEP::mm * (unit_distribution(engine) - 0.5));
+	  BSH.set_position_start(position);
+	  BSH.set_position_stop(position);
+	}
+    }
+
+  // Tracker : a few cells, each one hit again later by some steps
+  std::poisson_distribution<uint32_t> geiger_cells_distribution(mean_geiger_cells);
+  std::poisson_distribution<uint32_t> geiger_steps_distribution(mean_geiger_steps_per_cell);
+  std::uniform_int_distribution<uint32_t> layer_distribution(0, hc_constants::NUMBER_OF_GEIGER_LAYERS - 1);
+  std::uniform_int_distribution<uint32_t> geiger_row_distribution(0, hc_constants::NUMBER_OF_GEIGER_ROWS - 1);
+  const uint32_t number_of_cells = geiger_cells_distribution(engine);
+  for (uint32_t icell = 0; icell < number_of_cells; icell++)
+    {
+      const uint32_t side = side_distribution(engine);
+      const uint32_t layer = layer_distribution(engine);
+      const uint32_t row = geiger_row_distribution(engine);
+      const uint32_t number_of_steps = 1 + geiger_steps_distribution(engine);
+      for (uint32_t istep = 0; istep < number_of_steps; istep++)
+	{
+	  mctools::base_step_hit & BSH = SD_.add_step_hit("gg");
+	  BSH.set_hit_id(hit_id++);
+	  BSH.set_geom_id(geomtools::geom_id(geiger_type, 0, side, layer, row));
+	  BSH.set_energy_deposit(step_energy_distribution(engine) * 0.01);
+	  BSH.set_time_start(10 * CLHEP::microsecond * unit_distribution(engine));
+	  BSH.set_time_stop(BSH.get_time_start() + 0.1 * CLHEP::ns);
+	  const geomtools::vector_3d position((side == 0 ? -1 : 1) * (30 + 44 * layer) * CLHEP::mm,
+					      (row - 56.) * 44 * CLHEP::mm,
+					      1500 * CLHEP::mm * (2 * unit_distribution(engine) - 1));
+	  BSH.set_position_start(position);
+	  BSH.set_position_stop(position);
+	}
+    }
+  return;
+}
@@ -0,0 +1,52 @@
+//! \file synthetic_event_generator.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Synthetic simulated data banks on the demonstrator geometry,
+// to measure the analysis kernels without flsimulate output
+//
+
+#ifndef SYNTHETIC_EVENT_GENERATOR_HPP
+#define SYNTHETIC_EVENT_GENERATOR_HPP
+
+// Standard library:
+#include <cstdint>
+#include <random>
+
+// Third party:
+// - Bayeux/mctools:
+#include <mctools/simulated_data.h>
+
+//! \brief Generator of SD banks with configurable step hit multiplicities
+//
+// Calo step hits are grouped in a few OMs (side, column, row, part) with
+// several steps each, Geiger step hits in a few drift cells with later
+// re-hits of the same cell, as in flsimulate output. Multiplicities are
+// Poisson distributed, the same seed gives the same events.
+struct synthetic_event_generator
+{
+  /// Generate the next event
+  void generate(mctools::simulated_data & SD_);
+
+  // Geom ID types of the categories (from the geometry ID manager) :
+  uint32_t calo_type = 0;   ///< 'calorimeter_block' (module, side, column, row, part)
+  uint32_t geiger_type = 0; ///< 'drift_cell_core' (module, side, layer, row)
+
+  // Multiplicities :
+  double mean_calo_oms = 2;             ///< Mean number of OMs hit
+  double mean_calo_steps_per_om = 10;   ///< Mean number of step hits per OM
+  double mean_geiger_cells = 20;        ///< Mean number of drift cells hit
+  double mean_geiger_steps_per_cell = 3; ///< Mean number of step hits per cell
+
+  // Random engine :
+  std::mt19937_64 engine;
+
+};
+
+#endif // SYNTHETIC_EVENT_GENERATOR_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
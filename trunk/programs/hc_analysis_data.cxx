@@ -1,6 +1,15 @@
 // hc_analysis_data.cxx
 // Standard libraries :
-#include <bitset>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
 // #include <iostream>
 
 // Third party:
@@ -11,9 +20,7 @@
 #include <datatools/utils.h>
 #include <datatools/io_factory.h>
 // - Bayeux/geomtools:
-#include <bayeux/geomtools/manager.h>
 #include <bayeux/geomtools/id_mgr.h>
-#include <bayeux/geomtools/id_selector.h>
 // - Bayeux/mctools:
 #include <mctools/simulated_data.h>
 // - Bayeux/dpp:
@@ -26,6 +33,7 @@
 #include <falaise/snemo/geometry/calo_locator.h>
 
 // Root :
+#include "TROOT.h"
 #include "TError.h"
 #include "TFile.h"
 #include "TTree.h"
@@ -33,35 +41,123 @@
 #include "TH2F.h"
 
 // This project :
+#include "analysis_checkpoint.hpp"
+#include "async_event_writer.hpp"
+#include "compiled_id_selector.hpp"
 #include "data_statistics_simu.hpp"
+#include "event_analyzer.hpp"
+#include "event_cache.hpp"
+#include "event_index.hpp"
+#include "event_ntuple.hpp"
+#include "event_sorter.hpp"
+#include "event_source.hpp"
 #include "hc_constants.hpp"
+#include "job_spool.hpp"
+#include "ordered_event_pipeline.hpp"
+#include "processing_statistics.hpp"
 
 int column_to_hc_half_zone(const int & column);
 
-struct calo_hit_summary
+/// Parse calorimeter thresholds in keV : single values or 'min:max:step' ranges
+std::vector<double> parse_calo_threshold_scan(const std::vector<std::string> & tokens_);
+
+/// Name of the ROOT directory of a threshold scan point
+std::string calo_threshold_directory_name(double calo_threshold_kev_);
+
+/// Load the checkpoint of an output ROOT file, return false if there is no file or no checkpoint
+bool load_checkpoint(const std::string & root_filename_, analysis_checkpoint & checkpoint_);
+
+/// Add the histograms and processing statistics of the checkpoint of an output ROOT file
+void restore_checkpoint(const std::string & root_filename_,
+			const std::vector<double> & calo_threshold_scan_,
+			data_statistics_simu & dss_,
+			std::vector<std::unique_ptr<data_statistics_simu> > & scan_dss_);
+
+/// Save the histograms, processing statistics and checkpoint in an output ROOT file
+void save_root_file(const std::string & root_filename_,
+		    const std::vector<double> & calo_threshold_scan_,
+		    data_statistics_simu & dss_,
+		    std::vector<std::unique_ptr<data_statistics_simu> > & scan_dss_,
+		    const analysis_checkpoint & checkpoint_);
+
+/// Event output files of one segment of the run, a new segment is started at each checkpoint
+struct event_output_segment
 {
-  geomtools::geom_id geom_id;
-  double energy = 0;
-  double time = 0;
-  geomtools::vector_3d left_most_hit_position; // The left most position
-  bool geiger_association = false;
+  dpp::output_module calo_tracker_events_writer;
+  dpp::output_module sorted_writer;
+  dpp::output_module sorted_with_geiger_writer;
+  std::unique_ptr<async_event_writer> brio_writer;
+  std::size_t calo_tracker_output = 0;       ///< Output bit in the brio writer
+  std::size_t sorted_output = 0;             ///< Output bit in the brio writer (sort mode)
+  std::size_t sorted_with_geiger_output = 0; ///< Output bit in the brio writer (sort mode)
+  event_ntuple_writer ntuple_writer;
+  event_cache_writer cache_writer;
 };
 
+/// Prefix of the event output files of a segment, none for the first one
+std::string event_segment_prefix(uint32_t segment_);
+
+/// Copy the records of brio files one after the other in a new brio file
+void join_brio_files(const std::vector<std::string> & input_filenames_,
+		     const std::string & output_filename_,
+		     const datatools::multi_properties & metadata_store_);
+
+/// Output files selected for one event record
+struct event_outputs
+{
+  bool sorted = false;             ///< output_sorted.brio (sort mode)
+  bool sorted_with_geiger = false; ///< output_sorted_with_geiger.brio (sort mode)
+  bool calo_tracker = false;       ///< output_calo_tracker_events.brio
+  bool analyzed = false;           ///< Event passed to the analyzer
+  event_ntuple_row ntuple_row;     ///< Event summary for the ntuple (--ntuple)
+  std::vector<char> cache_record;  ///< Raw hits for the event cache (--cache)
+};
+
+/// Analyze the events of one command line, or serve the jobs of a spool
+int analyze_data(const std::vector<std::string> & arguments_, job_context & context_);
+
 int main( int  argc_ , char **argv_  )
 {
   falaise::initialize(argc_, argv_);
+  job_context context;
+  const int error_code = analyze_data(std::vector<std::string>(argv_ + 1, argv_ + argc_), context);
+  falaise::terminate();
+  return error_code;
+}
+
+int analyze_data(const std::vector<std::string> & arguments_, job_context & context_)
+{
   int error_code = EXIT_SUCCESS;
   datatools::logger::priority logging = datatools::logger::PRIO_FATAL;
 
   try {
 
     std::vector<std::string> input_filenames; // = "";
+    std::string input_index_file = "";
+    std::string index_selector = "";
     std::string output_path = "";
     std::string calo_mapping_config = "";
     std::string tracker_mapping_config = "";
+    std::string mapping_cache_file = "";
+    std::string spool_directory = "";
+    double      poll_interval = 1;
+    double      checkpoint_interval = 0;
     std::size_t max_events  = 0;
+    std::size_t number_of_threads = 1;
+    std::size_t write_queue_size = 64;
+    std::size_t prefetch_size = 128;
+    uint64_t    first_event = 0;
+    uint64_t    last_event = 0;
+    std::string shard_token = "";
     bool        is_debug    = false;
+    bool        sort_mode   = false;
+    bool        write_ntuple = false;
+    bool        write_cache = false;
+    bool        full_geometry = false;
+    bool        resume = false;
     double      calo_threshold_kev  = 0;
+    std::vector<std::string> calo_threshold_scan_tokens;
+    double      geiger_dead_time_us = 0;
 
     // Parse options:
     namespace po = boost::program_options;
@@ -72,26 +168,78 @@ int main( int  argc_ , char **argv_  )
       ("input,i",
        po::value<std::vector<std::string> >(& input_filenames)->multitoken(),
        "set a list of input files")
+      ("input-index,I",
+       po::value<std::string>(& input_index_file),
+       "read only the records listed in an event index (from hc_sort_data --index) in their original files")
+      ("index-selector",
+       po::value<std::string>(& index_selector),
+       "with --input-index, read only the records matching this selector (ex: output_sorted)")
       ("output,o",
        po::value<std::string>(& output_path),
        "set the output path")
       ("number_events,n",
        po::value<std::size_t>(& max_events)->default_value(10),
-       "set the maximum number of events")
+       "set the maximum number of events of each input file, from the start of its record range or shard (0 : all)")
+      ("sort,s",
+       "apply the sorting rules, write the sorted brio files and analyze the sorted events in the same pass")
+      ("ntuple",
+       "write a flat ntuple of the analyzed events (calo hits and Geiger cells) in output_event_ntuple.root")
+      ("cache",
+       "write the raw calo OM hits and Geiger fires of the analyzed events in output_event_cache.hcc, for hc_rehisto_cache")
+      ("threads,t",
+       po::value<std::size_t>(& number_of_threads)->default_value(1),
+       "set the number of analysis threads, the histograms (contents, entries and statistics) are identical to a serial run (1 : serial event loop)")
+      ("first-event",
+       po::value<uint64_t>(& first_event),
+       "read the records of each input file from this record number (from 0), the outputs are prefixed by records_first_last_")
+      ("last-event",
+       po::value<uint64_t>(& last_event),
+       "read the records of each input file up to this record number (excluded)")
+      ("shard",
+       po::value<std::string>(& shard_token),
+       "read only the shard 'k/N' (0 <= k < N) of N equal parts of each input file, the outputs are prefixed by shard_k_of_N_, -n still limits each shard from its start")
+      ("prefetch",
+       po::value<std::size_t>(& prefetch_size)->default_value(128),
+       "set the number of event records decoded in advance by a background reader thread, with read ahead of the next input file (0 : read in the event loop)")
+      ("write-queue",
+       po::value<std::size_t>(& write_queue_size)->default_value(64),
+       "set the number of event records queued for the background brio writer thread (0 : write in the event loop)")
       ("calo-threshold,c",
        po::value<double>(& calo_threshold_kev)->default_value(hc_constants::CALO_COMMISSIONING_HIGH_THRESHOLD_KEV),
        "set the calorimeter threshold in keV")
+      ("calo-threshold-scan",
+       po::value<std::vector<std::string> >(& calo_threshold_scan_tokens)->multitoken(),
+       "also fill the histograms for a list of calorimeter thresholds in keV, values or 'min:max:step' ranges (ex: 10 50:100:10), each in its own directory of the ROOT file")
+      ("geiger-dead-time",
+       po::value<double>(& geiger_dead_time_us),
+       "set the Geiger cell dead time in microseconds, counted from the last fire of the cell (default : a cell fires only once per event)")
       ("calo_mapping,C",
        po::value<std::string>(& calo_mapping_config),
        "set the calorimeter mapping configuration from a datatools::properties ASCII file")
       ("tracker_mapping,T",
        po::value<std::string>(& tracker_mapping_config),
        "set the tracker mapping configuration from a datatools::properties ASCII file")
+      ("full-geometry",
+       "build the full geometry manager and the calo / Geiger locators (slow), by default only the geom ID categories are loaded")
+      ("mapping-cache",
+       po::value<std::string>(& mapping_cache_file),
+       "reuse the compiled mapping rules cached in this file, and add the new ones to it")
+      ("checkpoint-interval",
+       po::value<double>(& checkpoint_interval)->default_value(0),
+       "save the histograms and the input position in output_rootfile.root every this number of seconds (0 : only at the end), the event output files are closed at each checkpoint and continued in segment_K_ prefixed files, joined in the unprefixed files at the end of the run")
+      ("resume",
+       "continue an interrupted run (same options) from the checkpoint of its output_rootfile.root, the event output files written after the checkpoint are removed and written again")
+      ("spool",
+       po::value<std::string>(& spool_directory),
+       "serve the jobs of a spool directory ('name.job' files of options) with the geometry loaded once, until a 'stop' file or SIGTERM")
+      ("poll-interval",
+       po::value<double>(& poll_interval)->default_value(1),
+       "with --spool, set the interval in seconds between two scans of the spool directory")
       ; // end of options description
 
     // Describe command line arguments :
     po::variables_map vm;
-    po::store(po::command_line_parser(argc_, argv_)
+    po::store(po::command_line_parser(arguments_)
 	      .options(opts)
 	      .run(), vm);
     po::notify(vm);
@@ -108,12 +256,36 @@ int main( int  argc_ , char **argv_  )
       is_debug = true;
     }
     if (is_debug) logging = datatools::logger::PRIO_DEBUG;
+    if (vm.count("sort")) sort_mode = true;
+    if (vm.count("ntuple")) write_ntuple = true;
+    if (vm.count("cache")) write_cache = true;
+    if (vm.count("full-geometry")) full_geometry = true;
+    if (vm.count("resume")) resume = true;
+
+    if (!spool_directory.empty()) {
+      DT_THROW_IF(context_.serving, std::logic_error, "A job can not serve a spool !");
+      // Geometry and compiled mapping rules kept warm for all the jobs :
+      context_.initialize_geometry(full_geometry);
+      context_.load_snapshot(mapping_cache_file);
+      context_.serving = true;
+      job_spool spool;
+      spool.initialize(spool_directory, poll_interval);
+      spool.serve([&context_] (const std::vector<std::string> & job_arguments_) -> int
+		  {
+		    const int job_error_code = analyze_data(job_arguments_, context_);
+		    context_.store_snapshot();
+		    return job_error_code;
+		  });
+      return error_code;
+    }
+
+    const std::vector<double> calo_threshold_scan = parse_calo_threshold_scan(calo_threshold_scan_tokens);
 
     DT_LOG_INFORMATION(logging, "List of input file(s) : ");
     for (auto file = input_filenames.begin();
 	 file != input_filenames.end();
 	 file++) std::clog << *file << ' ';
-    DT_THROW_IF(input_filenames.size() == 0, std::logic_error, "No input file(s) ! ");
+    DT_THROW_IF(input_filenames.size() == 0 && input_index_file.empty(), std::logic_error, "No input file(s) ! ");
 
     DT_LOG_INFORMATION(logging, "Output path for files = " + output_path);
     if (output_path.empty()) {
@@ -123,331 +295,554 @@ int main( int  argc_ , char **argv_  )
 
     std::clog << "INFO : Program sorting raw data file to reduce the number of event / file and produce root histograms for analysis simulated data from half commissioning" << std::endl;
 
-    std::string manager_config_file;
-    manager_config_file = "@falaise:config/snemo/demonstrator/geometry/4.0/manager.conf";
-    datatools::fetch_path_with_env(manager_config_file);
-    datatools::properties manager_config;
-    datatools::properties::read_config (manager_config_file,
-					manager_config);
-    geomtools::manager my_geom_manager;
-    manager_config.update ("build_mapping", true);
-    if (manager_config.has_key ("mapping.excluded_categories"))	manager_config.erase ("mapping.excluded_categories");
-    my_geom_manager.initialize (manager_config);
+    // Geom ID decoding and mapping rules only need the geom ID categories
+    // (already loaded for the jobs of a spool) :
+    context_.initialize_geometry(full_geometry);
+    const geometry_context & my_geometry = context_.geometry;
 
     // Simulated Data "SD" bank label :
     std::string SD_bank_label = "SD";
 
-    // Locators :
+    // Locators, only with the full geometry :
     int32_t my_module_number = 0;
-    snemo::geometry::calo_locator calo_locator;
-    calo_locator.set_geo_manager(my_geom_manager);
-    calo_locator.set_module_number(my_module_number);
-    calo_locator.initialize ();
-
-    snemo::geometry::gg_locator gg_locator;
-    gg_locator.set_geo_manager(my_geom_manager);
-    gg_locator.set_module_number(my_module_number);
-    gg_locator.initialize ();
-
-    int max_record_total = static_cast<int>(max_events) * static_cast<int>(input_filenames.size());
-    std::clog << "max_record total = " << max_record_total << std::endl;
-    std::clog << "max_events       = " << max_events << std::endl;
-
-    // Event reader :
-    dpp::input_module reader;
-    datatools::properties reader_config;
-    reader_config.store ("logging.priority", "debug");
-    reader_config.store("files.mode", "list");
-    reader_config.store("files.list.filenames", input_filenames);
-    reader_config.store("max_record_total", max_record_total);
-    reader_config.store("max_record_per_file", static_cast<int>(max_events));
-    reader.initialize_standalone (reader_config);
-    datatools::multi_properties iMetadataStore = reader.get_metadata_store();
-    // reader.tree_dump(std::clog, "Simulated data reader module");
-
-    // Event record :
-    datatools::things ER;
-
-    // Calo and tracker half commissioning mapping configuration :
-    datatools::properties calo_config;
-    if (!calo_mapping_config.empty()) {
-      calo_config.read_configuration(calo_mapping_config);
+    std::unique_ptr<snemo::geometry::calo_locator> calo_locator;
+    std::unique_ptr<snemo::geometry::gg_locator> gg_locator;
+    if (my_geometry.has_manager())
+      {
+	calo_locator.reset(new snemo::geometry::calo_locator);
+	calo_locator->set_geo_manager(my_geometry.get_manager());
+	calo_locator->set_module_number(my_module_number);
+	calo_locator->initialize ();
+
+	gg_locator.reset(new snemo::geometry::gg_locator);
+	gg_locator->set_geo_manager(my_geometry.get_manager());
+	gg_locator->set_module_number(my_module_number);
+	gg_locator->initialize ();
+      }
+
+    std::clog << "max_events per file = " << max_events << std::endl;
+
+    // Event source, file by file (records of an event index only with --input-index) :
+    event_source source;
+    source.set_logging(logging);
+    source.set_prefetch(prefetch_size);
+
+    // Part of each input file only (-n records at most), outputs named after the part :
+    if (!shard_token.empty()) {
+      DT_THROW_IF(vm.count("first-event") || vm.count("last-event"), std::logic_error,
+		  "A shard is not used with a record range !");
+      uint32_t shard = 0;
+      uint32_t number_of_shards = 0;
+      event_source::parse_shard(shard_token, shard, number_of_shards);
+      source.set_shard(shard, number_of_shards);
     }
+    else if (vm.count("first-event") || vm.count("last-event")) source.set_record_range(first_event, last_event);
+    output_path += source.get_range_tag();
 
-    datatools::properties tracker_config;
-    if (!tracker_mapping_config.empty()) {
-      tracker_config.read_configuration(tracker_mapping_config);
-    }
+    // Histograms and checkpoint, written aside and renamed at each save :
+    std::string root_filename = output_path + "output_rootfile.root";
+    datatools::fetch_path_with_env(root_filename);
 
-    geomtools::id_selector hc_calo_selector(my_geom_manager.get_id_mgr());
-    if (!calo_mapping_config.empty()) {
-      std::ifstream ifile(calo_mapping_config);
-      bool empty = false;
-      if (ifile.peek() == std::ifstream::traits_type::eof()) empty = true;
-      if (!empty)  hc_calo_selector.initialize(calo_config);
+    // Input position of an interrupted run :
+    analysis_checkpoint checkpoint;
+    bool resumed = false;
+    if (resume && load_checkpoint(root_filename, checkpoint))
+      {
+	if (checkpoint.complete) {
+	  std::clog << "INFO : '" << root_filename << "' is complete, nothing to resume" << std::endl;
+	  return error_code;
+	}
+	std::clog << "INFO : Resuming after " << checkpoint.number_of_events << " events, at record #"
+		  << checkpoint.record_number << " of input file #" << checkpoint.file_index
+		  << ", event output segment #" << checkpoint.segment << std::endl;
+	source.set_start_position(checkpoint.file_index, checkpoint.record_number);
+	resumed = true;
+      }
+    if (input_index_file.empty()) {
+      source.initialize(input_filenames, max_events);
     }
+    else {
+      event_index input_index;
+      input_index.load(input_index_file);
+      uint64_t selector_mask = 0;
+      if (!index_selector.empty()) selector_mask = uint64_t(1) << input_index.get_selector_bit(index_selector);
+      source.initialize(input_index, selector_mask);
+    }
+    datatools::multi_properties iMetadataStore = source.get_metadata_store();
+
+    // Event record, exchanged with the brio writer :
+    std::unique_ptr<datatools::things> ER(new datatools::things);
+
+    // Calo and tracker half commissioning mapping rules, compiled once in dense bitmaps
+    // (or taken from the compiled rules of the previous runs) :
+    context_.load_snapshot(mapping_cache_file);
+    mapping_snapshot & my_mapping_snapshot = context_.snapshot;
+
+    compiled_id_selector hc_calo_selector;
+    my_mapping_snapshot.initialize_selector(hc_calo_selector,
+					    calo_mapping_config,
+					    my_geometry.get_id_mgr(),
+					    compiled_id_selector::calo_category());
     if (is_debug) hc_calo_selector.dump(std::clog, "Half commissioning calo selector: ");
 
-    geomtools::id_selector hc_geiger_selector(my_geom_manager.get_id_mgr());
-    if (!tracker_mapping_config.empty()) {
-      std::ifstream ifile(tracker_mapping_config);
-      bool empty = false;
-      if (ifile.peek() == std::ifstream::traits_type::eof()) empty = true;
-      if (!empty) hc_geiger_selector.initialize(tracker_config);
-    }
+    compiled_id_selector hc_geiger_selector;
+    my_mapping_snapshot.initialize_selector(hc_geiger_selector,
+					    tracker_mapping_config,
+					    my_geometry.get_id_mgr(),
+					    compiled_id_selector::geiger_category());
     if (is_debug) hc_geiger_selector.dump(std::clog, "Half commissioning Geiger selector: ");
 
+    context_.store_snapshot();
+
     //==============================================//
     //          output files  and writers           //
     //==============================================//
 
-    // Name of full track (9 layers hit) SD output file :
-    std::string calo_tracker_events_brio = output_path + "output_calo_tracker_events.brio";
-
-    // Event writer for full track (9 layers hit) :
-    dpp::output_module calo_tracker_events_writer;
-    datatools::properties calo_tracker_events_config;
-    calo_tracker_events_config.store ("logging.priority", "fatal");
-    calo_tracker_events_config.store ("files.mode", "single");
-    calo_tracker_events_config.store ("files.single.filename", calo_tracker_events_brio);
-    calo_tracker_events_writer.grab_metadata_store() = iMetadataStore;
-    calo_tracker_events_writer.initialize_standalone(calo_tracker_events_config);
+    // Event output files, in segments closed at each checkpoint : the segments
+    // before the one of a checkpoint only hold the events committed before it
+    std::unique_ptr<event_output_segment> event_files;
+    processing_statistics writer_statistics;
+    std::size_t number_of_ntuple_entries = 0;
+    std::size_t number_of_cached_events = 0;
 
-    // Output ROOT file :
-    std::string string_buffer = output_path + "output_rootfile.root";
-    datatools::fetch_path_with_env(string_buffer);
+    auto event_output_filenames = [&] (uint32_t segment_) -> std::vector<std::string>
+      {
+	const std::string prefix = output_path + event_segment_prefix(segment_);
+	std::vector<std::string> filenames;
+	filenames.push_back(prefix + "output_calo_tracker_events.brio");
+	filenames.push_back(prefix + "output_sorted.brio");
+	filenames.push_back(prefix + "output_sorted_with_geiger.brio");
+	filenames.push_back(prefix + "output_event_ntuple.root");
+	filenames.push_back(prefix + "output_event_cache.hcc");
+	for (std::size_t ifile = 0; ifile < filenames.size(); ifile++) datatools::fetch_path_with_env(filenames[ifile]);
+	return filenames;
+      };
+
+    // Open the event output files of the segment of the checkpoint :
+    auto open_event_files = [&] ()
+      {
+	event_files.reset(new event_output_segment);
+	const std::string event_output_path = output_path + event_segment_prefix(checkpoint.segment);
+
+	// Name of full track (9 layers hit) SD output file :
+	std::string calo_tracker_events_brio = event_output_path + "output_calo_tracker_events.brio";
+
+	// Event writer for full track (9 layers hit) :
+	datatools::properties calo_tracker_events_config;
+	calo_tracker_events_config.store ("logging.priority", "fatal");
+	calo_tracker_events_config.store ("files.mode", "single");
+	calo_tracker_events_config.store ("files.single.filename", calo_tracker_events_brio);
+	event_files->calo_tracker_events_writer.grab_metadata_store() = iMetadataStore;
+	event_files->calo_tracker_events_writer.initialize_standalone(calo_tracker_events_config);
+
+	// Sorted (matching rules) SD output files, only in sort mode :
+	if (sort_mode)
+	  {
+	    // Name of sorted (matching rules) SD output file :
+	    std::string sorted_sd_brio = event_output_path + "output_sorted.brio";
+
+	    // Event writer for sorted SD :
+	    datatools::properties sorted_writer_config;
+	    sorted_writer_config.store ("logging.priority", "fatal");
+	    sorted_writer_config.store ("files.mode", "single");
+	    sorted_writer_config.store ("files.single.filename", sorted_sd_brio);
+	    event_files->sorted_writer.grab_metadata_store() = iMetadataStore;
+	    event_files->sorted_writer.initialize_standalone(sorted_writer_config);
+
+	    // Name of sorted (matching rules with Geiger) SD output file :
+	    std::string sorted_with_geiger_brio = event_output_path + "output_sorted_with_geiger.brio";
+
+	    // Event writer for sorted SD with Geiger :
+	    datatools::properties sorted_with_geiger_config;
+	    sorted_with_geiger_config.store ("logging.priority", "fatal");
+	    sorted_with_geiger_config.store ("files.mode", "single");
+	    sorted_with_geiger_config.store ("files.single.filename", sorted_with_geiger_brio);
+	    event_files->sorted_with_geiger_writer.grab_metadata_store() = iMetadataStore;
+	    event_files->sorted_with_geiger_writer.initialize_standalone(sorted_with_geiger_config);
+	  }
+
+	// Selected records written in the event order by a background thread :
+	event_files->brio_writer.reset(new async_event_writer(write_queue_size));
+	event_files->calo_tracker_output = event_files->brio_writer->add_output(event_files->calo_tracker_events_writer);
+	if (sort_mode) {
+	  event_files->sorted_output = event_files->brio_writer->add_output(event_files->sorted_writer);
+	  event_files->sorted_with_geiger_output = event_files->brio_writer->add_output(event_files->sorted_with_geiger_writer);
+	}
+	if (event_files->brio_writer->is_asynchronous()) ROOT::EnableThreadSafety();
+	event_files->brio_writer->start();
+
+	// Flat ntuple of the analyzed events, in its own file :
+	if (write_ntuple)
+	  {
+	    std::string ntuple_filename = event_output_path + "output_event_ntuple.root";
+	    datatools::fetch_path_with_env(ntuple_filename);
+	    event_files->ntuple_writer.initialize(ntuple_filename);
+	  }
 
-    TFile* root_file = new TFile(string_buffer.c_str(), "RECREATE");
-    root_file->mkdir("single_calo_energy",
-		     "Single calorimeter energy distribution");
+	// Event cache, before threshold and selector cuts :
+	if (write_cache)
+	  {
+	    std::string cache_filename = event_output_path + "output_event_cache.hcc";
+	    datatools::fetch_path_with_env(cache_filename);
+	    const geomtools::id_mgr & id_mgr = my_geometry.get_id_mgr();
+	    double cache_dead_time;
+	    datatools::invalidate(cache_dead_time);
+	    if (vm.count("geiger-dead-time")) cache_dead_time = geiger_dead_time_us * CLHEP::microsecond;
+	    event_files->cache_writer.initialize(cache_filename,
+						 id_mgr.get_category_info(compiled_id_selector::calo_category()).get_type(),
+						 id_mgr.get_category_info(compiled_id_selector::geiger_category()).get_type(),
+						 cache_dead_time);
+	  }
+      };
+
+    // Flush and close the event output files, the brio writer thread is stopped first :
+    auto close_event_files = [&] ()
+      {
+	if (!event_files) return;
+	event_files->brio_writer->terminate();
+	writer_statistics.merge(event_files->brio_writer->get_statistics());
+	event_files->brio_writer.reset();
+	if (event_files->calo_tracker_events_writer.is_initialized()) event_files->calo_tracker_events_writer.reset();
+	if (event_files->sorted_writer.is_initialized()) event_files->sorted_writer.reset();
+	if (event_files->sorted_with_geiger_writer.is_initialized()) event_files->sorted_with_geiger_writer.reset();
+	if (write_ntuple) {
+	  number_of_ntuple_entries += event_files->ntuple_writer.get_number_of_entries();
+	  event_files->ntuple_writer.terminate();
+	}
+	if (write_cache) {
+	  number_of_cached_events += event_files->cache_writer.get_number_of_events();
+	  event_files->cache_writer.terminate();
+	}
+	event_files.reset();
+      };
+
+    // Join the files of all segments written for an output in the file of the first one,
+    // through a 'joined_' file renamed once complete :
+    auto join_event_segments = [&] (const std::string & name_,
+				    const std::function<void(const std::vector<std::string> &, const std::string &)> & join_)
+      {
+	std::vector<std::string> segment_filenames;
+	for (uint32_t segment = 0; segment <= checkpoint.segment; segment++) {
+	  std::string filename = output_path + event_segment_prefix(segment) + name_;
+	  datatools::fetch_path_with_env(filename);
+	  if (std::ifstream(filename.c_str())) segment_filenames.push_back(filename);
+	}
+	if (segment_filenames.size() < 2) return;
+	std::string joined_filename = output_path + "joined_" + name_;
+	datatools::fetch_path_with_env(joined_filename);
+	join_(segment_filenames, joined_filename);
+	DT_THROW_IF(std::rename(joined_filename.c_str(), segment_filenames[0].c_str()) != 0, std::runtime_error,
+		    "Cannot rename '" << joined_filename << "' into '" << segment_filenames[0] << "' !");
+	for (std::size_t ifile = 1; ifile < segment_filenames.size(); ifile++) std::remove(segment_filenames[ifile].c_str());
+	std::clog << "INFO : Joined " << segment_filenames.size() << " segments in '" << segment_filenames[0] << "'" << std::endl;
+      };
+
+    // Files of the checkpoint segment and after hold events past the checkpoint,
+    // they are written again (a kill may also have left them unclosed) :
+    if (resumed)
+      {
+	for (uint32_t segment = checkpoint.segment; ; segment++) {
+	  const std::vector<std::string> filenames = event_output_filenames(segment);
+	  bool removed = false;
+	  for (std::size_t ifile = 0; ifile < filenames.size(); ifile++) {
+	    if (std::remove(filenames[ifile].c_str()) != 0) continue;
+	    std::clog << "INFO : Removed '" << filenames[ifile] << "', written after the checkpoint" << std::endl;
+	    removed = true;
+	  }
+	  if (!removed) break;
+	}
+      }
+    open_event_files();
 
     // Event counter :
-    int event_id    = 0;
+    uint64_t event_id = checkpoint.number_of_events;
+    uint64_t committed_event_id = checkpoint.number_of_events;
 
     data_statistics_simu my_dss;
     my_dss.initialize();
 
-    while (!reader.is_terminated())
+    // Event selections counted in the processing statistics :
+    std::size_t sorted_selection = 0;
+    std::size_t sorted_with_geiger_selection = 0;
+    std::size_t calo_tracker_selection = 0;
+    auto add_selections = [&] (processing_statistics & statistics_)
       {
-	DT_LOG_DEBUG(logging, "Event #" << event_id);
-	reader.process(ER);
-
-	bool full_track_event = false;
-
-	// A plain `mctools::simulated_data' object is stored here :
-	if (ER.has(SD_bank_label) && ER.is_a<mctools::simulated_data>(SD_bank_label))
+	if (sort_mode) {
+	  sorted_selection = statistics_.add_selection("output_sorted");
+	  sorted_with_geiger_selection = statistics_.add_selection("output_sorted_with_geiger");
+	}
+	calo_tracker_selection = statistics_.add_selection("output_calo_tracker_events");
+      };
+    add_selections(my_dss.statistics);
+
+    // One set of histograms per threshold of the scan, saved in their own directory :
+    auto make_scan_dss = [&] () -> std::vector<std::unique_ptr<data_statistics_simu> >
+      {
+	std::vector<std::unique_ptr<data_statistics_simu> > scan_dss;
+	for (std::size_t ithreshold = 0; ithreshold < calo_threshold_scan.size(); ithreshold++) {
+	  scan_dss.push_back(std::unique_ptr<data_statistics_simu>(new data_statistics_simu));
+	  scan_dss.back()->initialize();
+	}
+	return scan_dss;
+      };
+    std::vector<std::unique_ptr<data_statistics_simu> > my_scan_dss = make_scan_dss();
+
+    // Histograms of the events committed before the checkpoint, the output ROOT
+    // file is written now (or again) to check it early :
+    if (resumed) restore_checkpoint(root_filename, calo_threshold_scan, my_dss, my_scan_dss);
+    const uint64_t resumed_run_wall_ns = my_dss.statistics.run_wall_ns;
+    save_root_file(root_filename, calo_threshold_scan, my_dss, my_scan_dss, checkpoint);
+
+    // Sorting rules and event analyzer, one copy per worker thread :
+    event_sorter my_sorter;
+    my_sorter.calo_selector = &hc_calo_selector;
+    my_sorter.geiger_selector = &hc_geiger_selector;
+    my_sorter.logging = logging;
+
+    event_analyzer my_analyzer;
+    my_analyzer.calo_selector = &hc_calo_selector;
+    my_analyzer.geiger_selector = &hc_geiger_selector;
+    my_analyzer.calo_threshold_kev = calo_threshold_kev;
+    if (vm.count("geiger-dead-time")) my_analyzer.geiger_dead_time = geiger_dead_time_us * CLHEP::microsecond;
+    my_analyzer.logging = logging;
+    my_analyzer.statistics = &my_dss.statistics;
+
+    // Sort (if asked) and analyze one event record :
+    auto process_record = [&] (event_sorter & sorter_,
+			       event_analyzer & analyzer_,
+			       data_statistics_simu & dss_,
+			       std::vector<std::unique_ptr<data_statistics_simu> > & scan_dss_,
+			       const datatools::things & record_,
+			       event_outputs & outputs_)
+      {
+	processing_statistics & statistics = dss_.statistics;
+	statistics.number_of_events++;
+
+	const mctools::simulated_data * SD_ptr = nullptr;
+	{
+	  processing_statistics::scoped_timer timer(&statistics, processing_statistics::STAGE_BANK_ACCESS);
+	  // A plain `mctools::simulated_data' object is stored here :
+	  if (record_.has(SD_bank_label) && record_.is_a<mctools::simulated_data>(SD_bank_label)) {
+	    SD_ptr = &record_.get<mctools::simulated_data>(SD_bank_label);
+	  }
+	}
+	if (SD_ptr == nullptr) return;
+
+	// Access to the "SD" bank with a stored `mctools::simulated_data' :
+	const mctools::simulated_data & SD = *SD_ptr;
+
+	// Only events matching the sorting rules are analyzed, as with hc_sort_data outputs :
+	if (sort_mode)
 	  {
-	    // Access to the "SD" bank with a stored `mctools::simulated_data' :
-	    const mctools::simulated_data & SD = ER.get<mctools::simulated_data>(SD_bank_label);
-
-	    // New SD bank flaged for Geiger cell already hit
-	    mctools::simulated_data flaged_SD = SD;
-
-	    // First loop on all hits to merge each calo hit in the same OM, also tag GG cells hit several times :
-	    std::map<geomtools::geom_id, calo_hit_summary> calo_hit_map;
-	    // If main calo hits :
-	    if (flaged_SD.has_step_hits("calo"))
-	      {
-		mctools::simulated_data::hit_handle_collection_type BSHC = flaged_SD.get_step_hits("calo");
-		DT_LOG_TRACE(logging, "BSCH calo step hits # = " << BSHC.size());
-
-		for (mctools::simulated_data::hit_handle_collection_type::const_iterator i = BSHC.begin();
-		     i != BSHC.end();
-		     i++)
-		  {
-		    const mctools::base_step_hit & BSH = i->get();
-		    // extract the corresponding geom ID:
-		    const geomtools::geom_id & main_calo_gid = BSH.get_geom_id();
-
-		    // Add in the map calorimeters only if they match selector rules (from commissioning)
-		    if (hc_calo_selector.is_initialized() && hc_calo_selector.match(main_calo_gid)) {
-
-		      bool calo_hit_is_in_map = calo_hit_map.find(main_calo_gid) != calo_hit_map.end();
-		      //int column = main_calo_gid.get(2);
-		      // int row = main_calo_gid.get(3);
-
-		      if (!calo_hit_is_in_map)
-			{
-			  // Create a new calo hit and insert in the map only if it match commissioning rules
-			  calo_hit_summary new_calo_hit;
-			  new_calo_hit.geom_id = main_calo_gid;
-			  new_calo_hit.energy = BSH.get_energy_deposit();
-			  new_calo_hit.time = BSH.get_time_start();
-			  new_calo_hit.left_most_hit_position = BSH.get_position_start();
-			  calo_hit_map.insert(std::pair<geomtools::geom_id, calo_hit_summary>(main_calo_gid, new_calo_hit));
-			}
-		      else
-			{
-			  // Update the existing calo hit (add energy and check the time to be the t_start)min)
-			  calo_hit_map.find(main_calo_gid)->second.energy+= BSH.get_energy_deposit();
-			  if (BSH.get_time_start() < calo_hit_map.find(main_calo_gid)->second.time) calo_hit_map.find(main_calo_gid)->second.time = BSH.get_time_start();
-
-			  if (BSH.get_position_start().getX() < calo_hit_map.find(main_calo_gid)->second.left_most_hit_position.getX())
-			    {
-			      calo_hit_map.find(main_calo_gid)->second.left_most_hit_position = BSH.get_position_start();
-			    }
-			}
-
-		    } // end of match rules selection
-
-		  } // end of for i BSHC
-
-
-		DT_LOG_TRACE(logging, "Size of calo hit map :" << calo_hit_map.size());
-		// Check if all calo summary hit pass the threshold and remove them if not
-		for (std::map<geomtools::geom_id, calo_hit_summary>::iterator it_calo = calo_hit_map.begin();
-		     it_calo != calo_hit_map.end();)
-		  {
-		    DT_LOG_TRACE(logging, "Energy = " << it_calo->second.energy * 1000);
-		    if (it_calo->second.energy * 1000 < calo_threshold_kev) it_calo = calo_hit_map.erase(it_calo);
-		    else it_calo++;
-		  }
-
-	      } // end of if has step hits "calo"
-
-	    std::set<geomtools::geom_id> geiger_hit_set;
-	    std::vector<geomtools::vector_3d> collection_position_last_geiger_hit;
-	    std::size_t geiger_last_layer = hc_constants::NUMBER_OF_GEIGER_LAYERS - 1;
-
-	    if (flaged_SD.has_step_hits("gg"))
-	      {
-		const size_t number_of_gg_hits = flaged_SD.get_number_of_step_hits("gg");
-
-		// We have to flag the gg cells already hit before (maybe take into account the dead time of a GG cell)
-		for (size_t ihit = 0; ihit < number_of_gg_hits; ihit++)
-		  {
-		    mctools::base_step_hit & geiger_hit = flaged_SD.grab_step_hit("gg", ihit);
-		    for (size_t jhit = ihit + 1; jhit < number_of_gg_hits; jhit++)
-		      {
-			mctools::base_step_hit & other_geiger_hit = flaged_SD.grab_step_hit("gg", jhit);
-			if (geiger_hit.get_geom_id() == other_geiger_hit.get_geom_id())
-			  {
-			    const double gg_hit_time       = geiger_hit.get_time_start();
-			    const double other_gg_hit_time = other_geiger_hit.get_time_start();
-			    if (gg_hit_time > other_gg_hit_time)
-			      {
-				bool geiger_already_hit = true;
-				if (!geiger_hit.get_auxiliaries().has_flag("geiger_already_hit")) geiger_hit.grab_auxiliaries().store("geiger_already_hit", geiger_already_hit);
-			      }
-			    else
-			      {
-				bool geiger_already_hit = true;
-				if (!other_geiger_hit.get_auxiliaries().has_flag("geiger_already_hit")) other_geiger_hit.grab_auxiliaries().store("geiger_already_hit", geiger_already_hit);
-			      }
-			  } // end of if get_geom_id
-		      } // end of jhit
-		  } // end of ihit
-
-		mctools::simulated_data::hit_handle_collection_type BSHC_gg = flaged_SD.get_step_hits("gg");
-		DT_LOG_TRACE(logging, "BSCH geiger step hits # = " << BSHC_gg.size());
-		for (mctools::simulated_data::hit_handle_collection_type::const_iterator i = BSHC_gg.begin();
-		     i != BSHC_gg.end();
-		     i++)
-		  {
-		    const mctools::base_step_hit & BSH = i->get();
-		    // if (is_debug) BSH.tree_dump(std::clog, "A Geiger Base Step Hit : ", "INFO : ");
-
-		    // Second loop on Geiger hits, ignore cells hit 2 or more times.
-		    if (BSH.get_auxiliaries().has_flag("geiger_already_hit") || BSH.get_auxiliaries().has_flag("other_geiger_already_hit")) {}
-		    else
-		      {
-			const geomtools::geom_id & geiger_gid = BSH.get_geom_id();
-
-			// Add in the map tracker only if they match selector rules (from commissioning)
-			if (hc_geiger_selector.is_initialized() && hc_geiger_selector.match(geiger_gid)) {
-			  geiger_hit_set.insert(geiger_gid);
-			  // If the last Geiger at layer 8 is hit, push back position for calorimeter association
-			  if (geiger_gid.get(2) == geiger_last_layer) // last layer
-			    {
-			      collection_position_last_geiger_hit.push_back(BSH.get_position_stop());
-			    }
-			} // end of selector match
-		      }
-		  } // end of for
-	      } // end of if has step hits "gg"
-
-
-	    /*******************************************************/
-	    /* Begining analysis (based on calo map and geiger set */
-	    /*******************************************************/
-
-	    // Fill histograms in ROOT file :
-
-	    // int number_of_main_calo = calo_hit_map.size();
-	    // int number_of_geiger    = geiger_hit_set.size();
-
-	    // For each calorimeter, add it in the histogram
-	    // Calorimeter 'exists' only if E_calo > threshold
-	    double calo_tref;
-	    datatools::invalidate(calo_tref);
-	    double total_energy = 0;
-
-	    bool is_calo = false;
-	    bool is_tracker = false;
-
-
-	    for (std::map<geomtools::geom_id, calo_hit_summary>::const_iterator it_calo = calo_hit_map.begin();
-		 it_calo != calo_hit_map.end();
-		 it_calo++)
-	      {
-		if (it_calo == calo_hit_map.begin()) calo_tref = it_calo->second.time;
-		if (it_calo->second.time < calo_tref) calo_tref = it_calo->second.time;
-
-		int column = it_calo->first.get(2);
-		int row = it_calo->first.get(3);
-
-		my_dss.calo_distrib_ht_TH2F->Fill(column, row);
-		my_dss.calo_ht_energy_TH1F[column][row]->Fill(it_calo->second.energy * 1000);
-		total_energy+=it_calo->second.energy;
-
-		is_calo = true;
-	      }
-
-	    my_dss.calo_ht_total_energy_TH1F->Fill(total_energy * 1000);
-
-	    // Second loop for timing Tcalo_X - Tcalo_ref
-	    for (std::map<geomtools::geom_id, calo_hit_summary>::const_iterator it_calo = calo_hit_map.begin();
-		 it_calo != calo_hit_map.end();
-		 it_calo++)
-	      {
-		double delta_t = it_calo->second.time - calo_tref;
-		if (delta_t != 0) my_dss.calo_delta_t_calo_tref_TH1F->Fill(delta_t);
-	      }
-
-
-
-	    std::bitset<hc_constants::NUMBER_OF_GEIGER_LAYERS> layer_projection = 0x0;
-	    // For each Geiger cell, add it in the histogram
-	    for (std::set<geomtools::geom_id>::const_iterator it_geiger = geiger_hit_set.begin();
-		 it_geiger != geiger_hit_set.end();
-		 it_geiger++)
-	      {
-		int layer = it_geiger->get(2);
-		int row   = it_geiger->get(3);
-		// if (is_debug) std::clog << "Layer  = " << layer << " Row = " << row << std::endl;
-		my_dss.tracker_total_distribution_TH2F->Fill(row, layer);
-		layer_projection.set(layer, true);
-		is_tracker = true;
-	      }
-
-	    int number_of_layer = layer_projection.count();
-	    if (number_of_layer == hc_constants::NUMBER_OF_GEIGER_LAYERS) full_track_event = true;
-
-	    if (full_track_event) DT_LOG_DEBUG(logging, "Full track event !");
-
-	    if (is_calo && is_tracker) calo_tracker_events_writer.process(ER);
-
-
-
-	  } // end of if ER has flaged_SD_bank_label
+	    sorter_.process(SD);
+	    outputs_.sorted = sorter_.match_rules_event;
+	    outputs_.sorted_with_geiger = sorter_.match_rules_with_geiger;
+	    statistics.count_selection(sorted_selection, outputs_.sorted);
+	    statistics.count_selection(sorted_with_geiger_selection, outputs_.sorted_with_geiger);
+	    if (!outputs_.sorted) return;
+	  }
+
+	analyzer_.process(SD);
+	{
+	  processing_statistics::scoped_timer timer(&statistics, processing_statistics::STAGE_HISTOGRAM_FILL);
+	  analyzer_.fill(dss_);
+	}
+	outputs_.analyzed = true;
+	if (write_ntuple) outputs_.ntuple_row.set(analyzer_);
+	if (write_cache) event_cache_writer::encode(analyzer_, SD, outputs_.cache_record);
+
+	if (analyzer_.full_track_event) DT_LOG_DEBUG(logging, "Full track event !");
+
+	outputs_.calo_tracker = analyzer_.is_calo && analyzer_.is_tracker;
+	statistics.count_selection(calo_tracker_selection, outputs_.calo_tracker);
+
+	// Calo sums of the event are reused for each threshold of the scan :
+	for (std::size_t ithreshold = 0; ithreshold < calo_threshold_scan.size(); ithreshold++)
+	  {
+	    analyzer_.apply_calo_threshold(calo_threshold_scan[ithreshold]);
+	    processing_statistics::scoped_timer timer(&statistics, processing_statistics::STAGE_HISTOGRAM_FILL);
+	    analyzer_.fill(*scan_dss_[ithreshold]);
+	  }
+	return;
+      };
+
+    // Source positions of the records in flight, committed in the same order as read :
+    std::deque<std::pair<uint32_t, uint64_t> > record_positions;
+    std::mutex record_positions_mutex;
+
+    // Write one event record in the selected output files :
+    auto write_record = [&] (std::unique_ptr<datatools::things> & record_, const event_outputs & outputs_)
+      {
+	// A selected record is moved to the brio writer, an empty one comes back :
+	uint64_t output_mask = 0;
+	if (outputs_.sorted) output_mask |= uint64_t(1) << event_files->sorted_output;
+	if (outputs_.sorted_with_geiger) output_mask |= uint64_t(1) << event_files->sorted_with_geiger_output;
+	if (outputs_.calo_tracker) output_mask |= uint64_t(1) << event_files->calo_tracker_output;
+	event_files->brio_writer->write(record_, output_mask);
+	if (write_ntuple && outputs_.analyzed) event_files->ntuple_writer.fill(committed_event_id, outputs_.ntuple_row);
+	if (write_cache && outputs_.analyzed) event_files->cache_writer.write(outputs_.cache_record);
+	committed_event_id++;
+
+	// The next checkpoint starts after this record :
+	std::pair<uint32_t, uint64_t> position;
+	{
+	  std::lock_guard<std::mutex> lock(record_positions_mutex);
+	  position = record_positions.front();
+	  record_positions.pop_front();
+	}
+	checkpoint.file_index = position.first;
+	checkpoint.record_number = position.second + 1;
+	checkpoint.number_of_events = committed_event_id;
+	return;
+      };
+
+    // Read time, from the reader thread if any :
+    processing_statistics reader_statistics;
+    auto read_record = [&] (std::unique_ptr<datatools::things> & record_) -> bool
+      {
+	processing_statistics::scoped_timer timer(&reader_statistics, processing_statistics::STAGE_READ);
+	if (!source.read(record_)) return false;
+	std::lock_guard<std::mutex> lock(record_positions_mutex);
+	record_positions.push_back(std::make_pair(source.get_file_index(), source.get_record_number()));
+	return true;
+      };
+
+    const uint64_t event_loop_start_ns = processing_statistics::wall_clock_ns();
+
+    // Periodic checkpoints, with the histograms and the closed event output files
+    // of the committed events only :
+    uint64_t last_checkpoint_ns = event_loop_start_ns;
+    auto is_checkpoint_due = [&] () -> bool
+      {
+	return checkpoint_interval > 0
+	  && processing_statistics::wall_clock_ns() - last_checkpoint_ns >= checkpoint_interval * 1e9;
+      };
+    auto save_checkpoint = [&] (const std::vector<std::unique_ptr<data_statistics_simu> > & worker_dss_,
+				const std::vector<std::vector<std::unique_ptr<data_statistics_simu> > > & worker_scan_dss_)
+      {
+	// The events written so far are in closed files, the next ones go to a new segment :
+	close_event_files();
+	checkpoint.segment++;
+
+	// Merged in copies, the workers keep their histograms until the end of the run :
+	data_statistics_simu checkpoint_dss(my_dss);
+	std::vector<std::unique_ptr<data_statistics_simu> > checkpoint_scan_dss;
+	for (std::size_t ithreshold = 0; ithreshold < my_scan_dss.size(); ithreshold++) {
+	  checkpoint_scan_dss.push_back(std::unique_ptr<data_statistics_simu>(new data_statistics_simu(*my_scan_dss[ithreshold])));
+	}
+	for (std::size_t iworker = 0; iworker < worker_dss_.size(); iworker++) {
+	  checkpoint_dss.merge(*worker_dss_[iworker]);
+	  for (std::size_t ithreshold = 0; ithreshold < checkpoint_scan_dss.size(); ithreshold++) {
+	    checkpoint_scan_dss[ithreshold]->merge(*worker_scan_dss_[iworker][ithreshold]);
+	  }
+	}
+	checkpoint_dss.statistics.merge(reader_statistics);
+	checkpoint_dss.statistics.merge(writer_statistics);
+	last_checkpoint_ns = processing_statistics::wall_clock_ns();
+	checkpoint_dss.statistics.run_wall_ns = resumed_run_wall_ns + last_checkpoint_ns - event_loop_start_ns;
+	save_root_file(root_filename, calo_threshold_scan, checkpoint_dss, checkpoint_scan_dss, checkpoint);
+	std::clog << "INFO : Checkpoint after " << checkpoint.number_of_events << " events" << std::endl;
+	open_event_files();
+      };
+    if (number_of_threads <= 1)
+      {
+	while (read_record(ER))
+	  {
+	    DT_LOG_DEBUG(logging, "Event #" << event_id);
 
-	event_id++;
+	    event_outputs outputs;
+	    process_record(my_sorter, my_analyzer, my_dss, my_scan_dss, *ER, outputs);
+	    write_record(ER, outputs);
 
-	ER.clear();
-      } // end of reader is terminated
+	    event_id++;
 
-    my_dss.save_in_root_file(root_file);
-    root_file->Close();
+	    ER->clear();
+	    if (is_checkpoint_due()) save_checkpoint({}, {});
+	  } // end of source read
+      }
+    else
+      {
+	// One reader thread, N workers with their own analyzer and histograms,
+	// the output events are written in the input order by this thread :
+	ROOT::EnableThreadSafety();
+	std::vector<event_sorter> worker_sorters(number_of_threads, my_sorter);
+	std::vector<event_analyzer> worker_analyzers(number_of_threads, my_analyzer);
+	std::vector<std::unique_ptr<data_statistics_simu> > worker_dss;
+	std::vector<std::vector<std::unique_ptr<data_statistics_simu> > > worker_scan_dss;
+	for (std::size_t iworker = 0; iworker < number_of_threads; iworker++) {
+	  worker_dss.push_back(std::unique_ptr<data_statistics_simu>(new data_statistics_simu));
+	  worker_dss.back()->initialize();
+	  add_selections(worker_dss.back()->statistics);
+	  worker_analyzers[iworker].statistics = &worker_dss.back()->statistics;
+	  worker_scan_dss.push_back(make_scan_dss());
+	}
+
+	// At a checkpoint, reading stops until the records in flight are committed,
+	// then the event loop goes on from the next record of the source :
+	ordered_event_pipeline<event_outputs> pipeline(number_of_threads, 4 * number_of_threads);
+	bool checkpoint_requested = false;
+	do
+	  {
+	    checkpoint_requested = false;
+	    pipeline.run([&] (std::unique_ptr<datatools::things> & record_, event_outputs &) -> bool
+			 {
+			   if (is_checkpoint_due()) {
+			     checkpoint_requested = true;
+			     return false;
+			   }
+			   if (!read_record(record_)) return false;
+			   DT_LOG_DEBUG(logging, "Event #" << event_id);
+			   event_id++;
+			   return true;
+			 },
+			 [&] (std::size_t worker_, datatools::things & record_, event_outputs & outputs_)
+			 {
+			   process_record(worker_sorters[worker_], worker_analyzers[worker_], *worker_dss[worker_], worker_scan_dss[worker_], record_, outputs_);
+			 },
+			 write_record);
+	    if (checkpoint_requested) save_checkpoint(worker_dss, worker_scan_dss);
+	  }
+	while (checkpoint_requested);
+
+	// Merge worker histograms before saving :
+	for (std::size_t iworker = 0; iworker < worker_dss.size(); iworker++) {
+	  my_dss.merge(*worker_dss[iworker]);
+	  for (std::size_t ithreshold = 0; ithreshold < my_scan_dss.size(); ithreshold++) {
+	    my_scan_dss[ithreshold]->merge(*worker_scan_dss[iworker][ithreshold]);
+	  }
+	}
+      }
+    close_event_files();
+
+    // The files of the checkpoint segments are joined, the run has the same event output files as without checkpoints :
+    if (checkpoint.segment > 0)
+      {
+	auto join_brio = [&] (const std::vector<std::string> & input_filenames_, const std::string & output_filename_)
+	  {
+	    join_brio_files(input_filenames_, output_filename_, iMetadataStore);
+	  };
+	join_event_segments("output_calo_tracker_events.brio", join_brio);
+	join_event_segments("output_sorted.brio", join_brio);
+	join_event_segments("output_sorted_with_geiger.brio", join_brio);
+	join_event_segments("output_event_ntuple.root", &event_ntuple_writer::concatenate);
+	join_event_segments("output_event_cache.hcc", &event_cache_writer::concatenate);
+      }
+    my_dss.statistics.merge(reader_statistics);
+    my_dss.statistics.merge(writer_statistics);
+    my_dss.statistics.run_wall_ns = resumed_run_wall_ns + processing_statistics::wall_clock_ns() - event_loop_start_ns;
+
+    // Statistics also in the ROOT file, so the outputs of several jobs can be merged :
+    checkpoint.complete = true;
+    save_root_file(root_filename, calo_threshold_scan, my_dss, my_scan_dss, checkpoint);
+
+    if (write_ntuple) std::clog << "INFO : " << number_of_ntuple_entries << " events written in the ntuple" << std::endl;
+    if (write_cache) std::clog << "INFO : " << number_of_cached_events << " events written in the event cache" << std::endl;
+
+    // Processing report, also next to the ROOT file for the batch jobs :
+    my_dss.print(std::clog);
+    std::string statistics_filename = output_path + "output_processing_statistics.json";
+    datatools::fetch_path_with_env(statistics_filename);
+    my_dss.statistics.store_json(statistics_filename);
 
     std::clog << "The end." << std::endl;
   } // end of try
@@ -462,6 +857,139 @@ int main( int  argc_ , char **argv_  )
     error_code = EXIT_FAILURE;
   }
 
-  falaise::terminate();
   return error_code;
 }
+
+std::vector<double> parse_calo_threshold_scan(const std::vector<std::string> & tokens_)
+{
+  std::vector<double> thresholds;
+  for (std::size_t itoken = 0; itoken < tokens_.size(); itoken++)
+    {
+      std::vector<double> values;
+      std::istringstream token_in(tokens_[itoken]);
+      std::string value_token;
+      while (std::getline(token_in, value_token, ':')) {
+	std::istringstream value_in(value_token);
+	double value = 0;
+	value_in >> value;
+	DT_THROW_IF(!value_in || !value_in.eof(), std::logic_error,
+		    "Invalid calo threshold '" << value_token << "' in '" << tokens_[itoken] << "' !");
+	values.push_back(value);
+      }
+
+      if (values.size() == 1) thresholds.push_back(values[0]);
+      else if (values.size() == 3 && values[2] > 0 && values[1] >= values[0])
+	{
+	  const std::size_t number_of_steps = std::floor((values[1] - values[0]) / values[2] + 1e-6);
+	  for (std::size_t istep = 0; istep <= number_of_steps; istep++) thresholds.push_back(values[0] + istep * values[2]);
+	}
+      else DT_THROW(std::logic_error, "Invalid calo threshold scan '" << tokens_[itoken] << "', expected 'threshold' or 'min:max:step' in keV !");
+    }
+  std::sort(thresholds.begin(), thresholds.end());
+  thresholds.erase(std::unique(thresholds.begin(), thresholds.end()), thresholds.end());
+  return thresholds;
+}
+
+std::string calo_threshold_directory_name(double calo_threshold_kev_)
+{
+  std::ostringstream name;
+  name << "calo_threshold_" << calo_threshold_kev_ << "keV";
+  std::string directory_name = name.str();
+  std::replace(directory_name.begin(), directory_name.end(), '.', 'p');
+  return directory_name;
+}
+
+std::string event_segment_prefix(uint32_t segment_)
+{
+  if (segment_ == 0) return "";
+  return "segment_" + std::to_string(segment_) + "_";
+}
+
+void join_brio_files(const std::vector<std::string> & input_filenames_,
+		     const std::string & output_filename_,
+		     const datatools::multi_properties & metadata_store_)
+{
+  // Records read in the order of the files :
+  dpp::input_module reader;
+  datatools::properties reader_config;
+  reader_config.store("logging.priority", "fatal");
+  reader_config.store("files.mode", "list");
+  reader_config.store("files.list.filenames", input_filenames_);
+  reader.initialize_standalone(reader_config);
+
+  dpp::output_module writer;
+  datatools::properties writer_config;
+  writer_config.store("logging.priority", "fatal");
+  writer_config.store("files.mode", "single");
+  writer_config.store("files.single.filename", output_filename_);
+  writer.grab_metadata_store() = metadata_store_;
+  writer.initialize_standalone(writer_config);
+
+  datatools::things record;
+  while (!reader.is_terminated()) {
+    DT_THROW_IF(reader.process(record) == dpp::base_module::PROCESS_ERROR, std::runtime_error,
+		"Cannot read a record to join in '" << output_filename_ << "' !");
+    writer.process(record);
+    record.clear();
+  }
+  writer.reset();
+  reader.reset();
+  return;
+}
+
+bool load_checkpoint(const std::string & root_filename_, analysis_checkpoint & checkpoint_)
+{
+  if (!std::ifstream(root_filename_.c_str())) return false;
+  std::unique_ptr<TFile> root_file(TFile::Open(root_filename_.c_str(), "READ"));
+  DT_THROW_IF(!root_file || root_file->IsZombie(), std::runtime_error, "Cannot open ROOT file '" << root_filename_ << "' !");
+  const bool loaded = checkpoint_.load(root_file.get());
+  root_file->Close();
+  return loaded;
+}
+
+void restore_checkpoint(const std::string & root_filename_,
+			const std::vector<double> & calo_threshold_scan_,
+			data_statistics_simu & dss_,
+			std::vector<std::unique_ptr<data_statistics_simu> > & scan_dss_)
+{
+  std::unique_ptr<TFile> root_file(TFile::Open(root_filename_.c_str(), "READ"));
+  DT_THROW_IF(!root_file || root_file->IsZombie(), std::runtime_error, "Cannot open ROOT file '" << root_filename_ << "' !");
+  dss_.merge_from_root_file(root_file.get());
+  dss_.merge_statistics_from_root_file(root_file.get());
+  for (std::size_t ithreshold = 0; ithreshold < calo_threshold_scan_.size(); ithreshold++) {
+    const std::string directory_name = calo_threshold_directory_name(calo_threshold_scan_[ithreshold]);
+    TDirectory * scan_directory = root_file->GetDirectory(directory_name.c_str());
+    DT_THROW_IF(scan_directory == nullptr, std::logic_error,
+		"No '" << directory_name << "' directory to resume in '" << root_filename_ << "', the threshold scan has changed !");
+    scan_dss_[ithreshold]->merge_from_root_file(scan_directory);
+  }
+  root_file->Close();
+  return;
+}
+
+void save_root_file(const std::string & root_filename_,
+		    const std::vector<double> & calo_threshold_scan_,
+		    data_statistics_simu & dss_,
+		    std::vector<std::unique_ptr<data_statistics_simu> > & scan_dss_,
+		    const analysis_checkpoint & checkpoint_)
+{
+  // Written aside then renamed, a job killed while saving keeps its previous checkpoint :
+  const std::string tmp_filename = root_filename_ + ".tmp";
+  {
+    std::unique_ptr<TFile> root_file(new TFile(tmp_filename.c_str(), "RECREATE"));
+    DT_THROW_IF(root_file->IsZombie(), std::runtime_error, "Cannot create ROOT file '" << tmp_filename << "' !");
+    dss_.save_in_root_file(root_file.get());
+    dss_.save_statistics_in_root_file(root_file.get());
+    for (std::size_t ithreshold = 0; ithreshold < calo_threshold_scan_.size(); ithreshold++) {
+      const std::string directory_name = calo_threshold_directory_name(calo_threshold_scan_[ithreshold]);
+      TDirectory * scan_directory = root_file->mkdir(directory_name.c_str(),
+						     Form("Histograms with a calorimeter threshold of %g keV", calo_threshold_scan_[ithreshold]));
+      scan_dss_[ithreshold]->save_in_root_file(scan_directory);
+    }
+    checkpoint_.save(root_file.get());
+    root_file->Close();
+  }
+  DT_THROW_IF(std::rename(tmp_filename.c_str(), root_filename_.c_str()) != 0, std::runtime_error,
+	      "Cannot rename ROOT file '" << tmp_filename << "' !");
+  return;
+}
@@ -0,0 +1,306 @@
+// hc_compare_outputs.cxx
+// Standard libraries :
+#include <cmath>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+// Third party:
+// - Boost:
+#include <boost/program_options.hpp>
+
+// - Bayeux/datatools:
+#include <datatools/utils.h>
+#include <datatools/things.h>
+// - Bayeux/mctools:
+#include <mctools/simulated_data.h>
+
+// Falaise:
+#include <falaise/falaise.h>
+
+// Root :
+#include "TFile.h"
+#include "TKey.h"
+#include "TList.h"
+#include "TH1.h"
+
+// This project :
+#include "event_source.hpp"
+
+/// Contents of a ROOT histogram, as compared between two files
+struct histogram_contents
+{
+  std::string class_name;
+  int dimension = 0;
+  std::vector<int> number_of_bins;  ///< Per axis
+  std::vector<double> axis_ranges;  ///< Min and max per axis
+  std::vector<double> cells;        ///< All bins, underflow and overflow included
+  double entries = 0;
+  std::vector<double> statistics;   ///< TH1::GetStats
+};
+
+/// Read all histograms of a ROOT file, by path
+void load_histograms(TDirectory * directory_,
+		     const std::string & path_,
+		     std::map<std::string, histogram_contents> & histograms_);
+
+/// Compare the histograms of two ROOT files, return the number of differences
+std::size_t compare_root_files(const std::string & reference_,
+			       const std::string & candidate_,
+			       double tolerance_,
+			       std::ostream & out_);
+
+/// Read the event list of a brio file, one fingerprint per record
+void load_event_list(const std::string & filename_,
+		     std::vector<std::string> & events_);
+
+/// Compare the event lists of two brio files, return the number of differences
+std::size_t compare_brio_files(const std::string & reference_,
+			       const std::string & candidate_,
+			       std::ostream & out_);
+
+int main( int  argc_ , char **argv_  )
+{
+  falaise::initialize(argc_, argv_);
+  int error_code = EXIT_SUCCESS;
+  datatools::logger::priority logging = datatools::logger::PRIO_FATAL;
+
+  try {
+
+    std::string reference_filename = "";
+    std::string candidate_filename = "";
+    double      tolerance = 0;
+
+    // Parse options:
+    namespace po = boost::program_options;
+    po::options_description opts("Allowed options");
+    opts.add_options()
+      ("help,h", "produce help message")
+      ("reference,r",
+       po::value<std::string>(& reference_filename),
+       "set the reference (golden) output file, a ROOT file of histograms or a brio file of events")
+      ("candidate,c",
+       po::value<std::string>(& candidate_filename),
+       "set the output file to compare with the reference")
+      ("tolerance",
+       po::value<double>(& tolerance)->default_value(0),
+       "set the relative tolerance on the histogram statistics, for outputs of other programs (bin contents and entries must be equal)")
+      ; // end of options description
+
+    // Describe command line arguments :
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc_, argv_)
+	      .options(opts)
+	      .run(), vm);
+    po::notify(vm);
+
+    // Use command line arguments :
+    if (vm.count("help")) {
+      std::cout << "Usage : " << std::endl;
+      std::cout << opts << std::endl;
+      return(1);
+    }
+
+    DT_THROW_IF(reference_filename.empty() || candidate_filename.empty(), std::logic_error, "Missing reference or candidate file ! ");
+    datatools::fetch_path_with_env(reference_filename);
+    datatools::fetch_path_with_env(candidate_filename);
+
+    std::size_t number_of_differences = 0;
+    const std::string extension = reference_filename.substr(reference_filename.find_last_of('.') + 1);
+    if (extension == "root") number_of_differences = compare_root_files(reference_filename, candidate_filename, tolerance, std::cout);
+    else if (extension == "brio") number_of_differences = compare_brio_files(reference_filename, candidate_filename, std::cout);
+    else DT_THROW(std::logic_error, "Unsupported file '" << reference_filename << "', expected a .root or a .brio file !");
+
+    if (number_of_differences == 0) std::clog << "INFO : '" << candidate_filename << "' matches '" << reference_filename << "'" << std::endl;
+    else {
+      std::clog << "ERROR : " << number_of_differences << " differences between '" << candidate_filename << "' and '" << reference_filename << "'" << std::endl;
+      error_code = EXIT_FAILURE;
+    }
+  } // end of try
+
+  catch (std::exception & error) {
+    DT_LOG_FATAL(logging, error.what());
+    error_code = EXIT_FAILURE;
+  }
+
+  catch (...) {
+    DT_LOG_FATAL(logging, "Unexpected error!");
+    error_code = EXIT_FAILURE;
+  }
+
+  falaise::terminate();
+  return error_code;
+}
+
+void load_histograms(TDirectory * directory_,
+		     const std::string & path_,
+		     std::map<std::string, histogram_contents> & histograms_)
+{
+  TIter next_key(directory_->GetListOfKeys());
+  while (TKey * key = static_cast<TKey *>(next_key()))
+    {
+      const std::string path = path_ + key->GetName();
+      const std::string class_name = key->GetClassName();
+      if (class_name == "TDirectoryFile" || class_name == "TDirectory") {
+	load_histograms(directory_->GetDirectory(key->GetName()), path + "/", histograms_);
+	continue;
+      }
+      std::unique_ptr<TObject> object(key->ReadObj());
+      const TH1 * histogram = dynamic_cast<const TH1 *>(object.get());
+      if (histogram == nullptr) continue;
+
+      histogram_contents & contents = histograms_[path];
+      contents.class_name = class_name;
+      contents.dimension = histogram->GetDimension();
+      contents.number_of_bins.push_back(histogram->GetNbinsX());
+      contents.axis_ranges.push_back(histogram->GetXaxis()->GetXmin());
+      contents.axis_ranges.push_back(histogram->GetXaxis()->GetXmax());
+      if (contents.dimension > 1) {
+	contents.number_of_bins.push_back(histogram->GetNbinsY());
+	contents.axis_ranges.push_back(histogram->GetYaxis()->GetXmin());
+	contents.axis_ranges.push_back(histogram->GetYaxis()->GetXmax());
+      }
+      contents.cells.resize(histogram->GetNcells());
+      for (int cell = 0; cell < histogram->GetNcells(); cell++) contents.cells[cell] = histogram->GetBinContent(cell);
+      contents.entries = histogram->GetEntries();
+      // 1D : 4 statistics, 2D : 7 statistics, room for 3D :
+      contents.statistics.assign(13, 0);
+      histogram->GetStats(contents.statistics.data());
+      contents.statistics.resize(contents.dimension == 1 ? 4 : 7);
+    }
+  return;
+}
+
+std::size_t compare_root_files(const std::string & reference_,
+			       const std::string & candidate_,
+			       double tolerance_,
+			       std::ostream & out_)
+{
+  std::map<std::string, histogram_contents> reference_histograms;
+  std::map<std::string, histogram_contents> candidate_histograms;
+  const std::string filenames[2] = {reference_, candidate_};
+  std::map<std::string, histogram_contents> * histograms[2] = {&reference_histograms, &candidate_histograms};
+  for (std::size_t ifile = 0; ifile < 2; ifile++) {
+    std::unique_ptr<TFile> root_file(TFile::Open(filenames[ifile].c_str(), "READ"));
+    DT_THROW_IF(!root_file || root_file->IsZombie(), std::runtime_error, "Cannot open ROOT file '" << filenames[ifile] << "' !");
+    load_histograms(root_file.get(), "", *histograms[ifile]);
+    root_file->Close();
+  }
+
+  std::size_t number_of_differences = 0;
+  for (std::map<std::string, histogram_contents>::const_iterator it = reference_histograms.begin();
+       it != reference_histograms.end();
+       it++)
+    {
+      const std::string & path = it->first;
+      const histogram_contents & reference = it->second;
+      std::map<std::string, histogram_contents>::const_iterator found = candidate_histograms.find(path);
+      if (found == candidate_histograms.end()) {
+	out_ << path << " : missing histogram" << std::endl;
+	number_of_differences++;
+	continue;
+      }
+      const histogram_contents & candidate = found->second;
+      if (candidate.class_name != reference.class_name
+	  || candidate.number_of_bins != reference.number_of_bins
+	  || candidate.axis_ranges != reference.axis_ranges) {
+	out_ << path << " : different class or binning" << std::endl;
+	number_of_differences++;
+	continue;
+      }
+      for (std::size_t cell = 0; cell < reference.cells.size(); cell++) {
+	if (candidate.cells[cell] == reference.cells[cell]) continue;
+	out_ << path << " : bin " << cell << " = " << candidate.cells[cell] << ", expected " << reference.cells[cell] << std::endl;
+	number_of_differences++;
+      }
+      if (candidate.entries != reference.entries) {
+	out_ << path << " : entries = " << candidate.entries << ", expected " << reference.entries << std::endl;
+	number_of_differences++;
+      }
+      // Statistics are computed from the bin contents, they are only expected to differ for other programs :
+      for (std::size_t istat = 0; istat < reference.statistics.size(); istat++) {
+	const double expected = reference.statistics[istat];
+	const double value = candidate.statistics[istat];
+	if (std::abs(value - expected) <= tolerance_ * std::max(std::abs(expected), 1.)) continue;
+	out_ << path << " : statistics " << istat << " = " << value << ", expected " << expected << std::endl;
+	number_of_differences++;
+      }
+    }
+
+  for (std::map<std::string, histogram_contents>::const_iterator it = candidate_histograms.begin();
+       it != candidate_histograms.end();
+       it++)
+    {
+      if (reference_histograms.count(it->first)) continue;
+      out_ << it->first << " : unexpected histogram" << std::endl;
+      number_of_differences++;
+    }
+
+  std::clog << "INFO : " << reference_histograms.size() << " reference histograms compared" << std::endl;
+  return number_of_differences;
+}
+
+void load_event_list(const std::string & filename_,
+		     std::vector<std::string> & events_)
+{
+  event_source source;
+  source.initialize(std::vector<std::string>(1, filename_), 0);
+  datatools::things ER;
+  const std::string SD_bank_label = "SD";
+  const std::string categories[2] = {"calo", "gg"};
+  while (source.read(ER))
+    {
+      std::ostringstream fingerprint;
+      fingerprint.precision(17);
+      if (ER.has(SD_bank_label) && ER.is_a<mctools::simulated_data>(SD_bank_label))
+	{
+	  const mctools::simulated_data & SD = ER.get<mctools::simulated_data>(SD_bank_label);
+	  // Step hits of each category : number, energy sum and first hit
+	  for (std::size_t icategory = 0; icategory < 2; icategory++)
+	    {
+	      fingerprint << categories[icategory] << ':';
+	      if (!SD.has_step_hits(categories[icategory])) {
+		fingerprint << "0 ";
+		continue;
+	      }
+	      const mctools::simulated_data::hit_handle_collection_type & BSHC = SD.get_step_hits(categories[icategory]);
+	      double energy = 0;
+	      for (std::size_t ihit = 0; ihit < BSHC.size(); ihit++) energy += BSHC[ihit].get().get_energy_deposit();
+	      fingerprint << BSHC.size() << ' ' << energy;
+	      if (!BSHC.empty()) fingerprint << ' ' << BSHC[0].get().get_geom_id() << ' ' << BSHC[0].get().get_time_start();
+	      fingerprint << ' ';
+	    }
+	}
+      else fingerprint << "no SD bank";
+      events_.push_back(fingerprint.str());
+      ER.clear();
+    }
+  return;
+}
+
+std::size_t compare_brio_files(const std::string & reference_,
+			       const std::string & candidate_,
+			       std::ostream & out_)
+{
+  std::vector<std::string> reference_events;
+  std::vector<std::string> candidate_events;
+  load_event_list(reference_, reference_events);
+  load_event_list(candidate_, candidate_events);
+
+  std::size_t number_of_differences = 0;
+  if (candidate_events.size() != reference_events.size()) {
+    out_ << "number of events = " << candidate_events.size() << ", expected " << reference_events.size() << std::endl;
+    number_of_differences++;
+  }
+  const std::size_t number_of_events = std::min(reference_events.size(), candidate_events.size());
+  for (std::size_t ievent = 0; ievent < number_of_events; ievent++) {
+    if (candidate_events[ievent] == reference_events[ievent]) continue;
+    out_ << "event #" << ievent << " : " << candidate_events[ievent] << std::endl
+	 << "  expected " << reference_events[ievent] << std::endl;
+    number_of_differences++;
+  }
+
+  std::clog << "INFO : " << reference_events.size() << " reference events compared" << std::endl;
+  return number_of_differences;
+}
@@ -0,0 +1,241 @@
+// hc_merge_outputs.cxx
+// Standard libraries :
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Third party:
+// - Boost:
+#include <boost/program_options.hpp>
+
+// - Bayeux/datatools:
+#include <datatools/utils.h>
+
+// Falaise:
+#include <falaise/falaise.h>
+
+// Root :
+#include "TROOT.h"
+#include "TFile.h"
+#include "TKey.h"
+#include "TList.h"
+#include "TH1.h"
+
+// This project :
+#include "data_statistics_simu.hpp"
+
+/// Histograms of one directory of the analysis outputs
+struct merged_directory
+{
+  std::string title;
+  std::unique_ptr<data_statistics_simu> dss;
+};
+
+/// Histograms of all directories, by name ("" : top directory, else a threshold scan point)
+typedef std::map<std::string, merged_directory> merged_outputs;
+
+/// Add the histograms and processing statistics of an analysis output file
+void merge_output_file(const std::string & filename_, merged_outputs & outputs_);
+
+/// Add merged outputs in other ones, the source is left empty
+void merge_outputs(merged_outputs & source_, merged_outputs & target_);
+
+/// Write merged outputs in a new ROOT file, with the layout of the analysis output files
+void save_outputs(const merged_outputs & outputs_, const std::string & filename_);
+
+int main( int  argc_ , char **argv_  )
+{
+  falaise::initialize(argc_, argv_);
+  int error_code = EXIT_SUCCESS;
+  datatools::logger::priority logging = datatools::logger::PRIO_FATAL;
+
+  try {
+
+    std::vector<std::string> input_filenames;
+    std::string output_filename = "";
+    std::size_t number_of_threads = 0;
+    bool        is_debug = false;
+
+    // Parse options:
+    namespace po = boost::program_options;
+    po::options_description opts("Allowed options");
+    opts.add_options()
+      ("help,h", "produce help message")
+      ("input,i",
+       po::value<std::vector<std::string> >(& input_filenames)->multitoken(),
+       "set the ROOT files written by hc_analysis_data to merge")
+      ("output,o",
+       po::value<std::string>(& output_filename),
+       "set the merged ROOT file")
+      ("threads,t",
+       po::value<std::size_t>(& number_of_threads)->default_value(0),
+       "set the number of threads reading and merging the files (0 : one per core)")
+      ("debug,d",
+       po::value<bool>(& is_debug)->zero_tokens()->default_value(false),
+       "debug mode")
+      ; // end of options description
+
+    // Describe command line arguments :
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc_, argv_)
+	      .options(opts)
+	      .run(), vm);
+    po::notify(vm);
+
+    // Use command line arguments :
+    if (vm.count("help")) {
+      std::cout << "Usage : " << std::endl;
+      std::cout << opts << std::endl;
+      return(1);
+    }
+
+    // Use command line arguments :
+    if (vm.count("debug")) {
+      is_debug = vm["debug"].as<bool>();
+    }
+
+    if (is_debug) logging = datatools::logger::PRIO_DEBUG;
+
+    DT_THROW_IF(input_filenames.empty(), std::logic_error, "Missing input files ! ");
+    DT_THROW_IF(output_filename.empty(), std::logic_error, "Missing output file ! ");
+    for (std::size_t ifile = 0; ifile < input_filenames.size(); ifile++) datatools::fetch_path_with_env(input_filenames[ifile]);
+    datatools::fetch_path_with_env(output_filename);
+
+    if (number_of_threads == 0) number_of_threads = std::max(1u, std::thread::hardware_concurrency());
+    number_of_threads = std::min(number_of_threads, input_filenames.size());
+    std::clog << "INFO : Merging " << input_filenames.size() << " files with " << number_of_threads << " threads" << std::endl;
+
+    // Each ROOT file is read by a single thread, histograms are not attached to the files :
+    ROOT::EnableThreadSafety();
+    TH1::AddDirectory(kFALSE);
+
+    // Files taken in turn by the threads, each thread merges them in its own outputs :
+    std::vector<merged_outputs> worker_outputs(number_of_threads);
+    std::atomic<std::size_t> next_file(0);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    std::vector<std::thread> workers;
+    for (std::size_t iworker = 0; iworker < number_of_threads; iworker++) {
+      workers.push_back(std::thread([&, iworker] {
+	    try {
+	      for (std::size_t ifile = next_file++; ifile < input_filenames.size(); ifile = next_file++) {
+		DT_LOG_DEBUG(logging, "Merging file '" << input_filenames[ifile] << "'");
+		merge_output_file(input_filenames[ifile], worker_outputs[iworker]);
+	      }
+	    }
+	    catch (...) {
+	      std::lock_guard<std::mutex> lock(error_mutex);
+	      if (!error) error = std::current_exception();
+	      // Stop the other threads after their current file :
+	      next_file = input_filenames.size();
+	    }
+	  }));
+    }
+    for (std::size_t iworker = 0; iworker < workers.size(); iworker++) workers[iworker].join();
+    if (error) std::rethrow_exception(error);
+
+    // Tree reduction : at each level the pairs of outputs are merged in parallel,
+    // log2(threads) levels instead of a serial merge of all outputs :
+    for (std::size_t stride = 1; stride < worker_outputs.size(); stride *= 2)
+      {
+	std::vector<std::thread> mergers;
+	for (std::size_t target = 0; target + stride < worker_outputs.size(); target += 2 * stride) {
+	  mergers.push_back(std::thread([&, target, stride] {
+		try {
+		  merge_outputs(worker_outputs[target + stride], worker_outputs[target]);
+		}
+		catch (...) {
+		  std::lock_guard<std::mutex> lock(error_mutex);
+		  if (!error) error = std::current_exception();
+		}
+	      }));
+	}
+	for (std::size_t imerger = 0; imerger < mergers.size(); imerger++) mergers[imerger].join();
+	if (error) std::rethrow_exception(error);
+      }
+
+    const merged_outputs & outputs = worker_outputs[0];
+    DT_THROW_IF(outputs.count("") == 0, std::logic_error, "No histograms in the input files !");
+    save_outputs(outputs, output_filename);
+    std::clog << "INFO : " << input_filenames.size() << " files merged in '" << output_filename << "'" << std::endl;
+    outputs.at("").dss->print(std::clog);
+
+    std::clog << "The end." << std::endl;
+  } // end of try
+
+  catch (std::exception & error) {
+    DT_LOG_FATAL(logging, error.what());
+    error_code = EXIT_FAILURE;
+  }
+
+  catch (...) {
+    DT_LOG_FATAL(logging, "Unexpected error!");
+    error_code = EXIT_FAILURE;
+  }
+
+  falaise::terminate();
+  return error_code;
+}
+
+void merge_output_file(const std::string & filename_, merged_outputs & outputs_)
+{
+  std::unique_ptr<TFile> root_file(TFile::Open(filename_.c_str(), "READ"));
+  DT_THROW_IF(!root_file || root_file->IsZombie(), std::runtime_error, "Cannot open ROOT file '" << filename_ << "' !");
+
+  // The top directory and the threshold scan directories, which all have their single calo spectra :
+  std::vector<std::pair<std::string, TDirectory *> > directories;
+  directories.push_back(std::make_pair(std::string(""), static_cast<TDirectory *>(root_file.get())));
+  TIter next_key(root_file->GetListOfKeys());
+  while (TKey * key = static_cast<TKey *>(next_key()))
+    {
+      const std::string class_name = key->GetClassName();
+      if (class_name != "TDirectoryFile" && class_name != "TDirectory") continue;
+      TDirectory * directory = root_file->GetDirectory(key->GetName());
+      if (directory == nullptr || directory->GetDirectory("single_calo_energy") == nullptr) continue;
+      directories.push_back(std::make_pair(std::string(key->GetName()), directory));
+    }
+
+  for (std::size_t idirectory = 0; idirectory < directories.size(); idirectory++) {
+    merged_directory & merged = outputs_[directories[idirectory].first];
+    if (!merged.dss) {
+      merged.title = directories[idirectory].second->GetTitle();
+      merged.dss.reset(new data_statistics_simu);
+      merged.dss->initialize();
+    }
+    merged.dss->merge_from_root_file(directories[idirectory].second);
+    merged.dss->merge_statistics_from_root_file(directories[idirectory].second);
+  }
+
+  root_file->Close();
+  return;
+}
+
+void merge_outputs(merged_outputs & source_, merged_outputs & target_)
+{
+  for (merged_outputs::iterator it = source_.begin(); it != source_.end(); it++) {
+    merged_directory & merged = target_[it->first];
+    if (!merged.dss) merged = std::move(it->second);
+    else merged.dss->merge(*it->second.dss, true);
+  }
+  source_.clear();
+  return;
+}
+
+void save_outputs(const merged_outputs & outputs_, const std::string & filename_)
+{
+  std::unique_ptr<TFile> root_file(new TFile(filename_.c_str(), "RECREATE"));
+  DT_THROW_IF(root_file->IsZombie(), std::runtime_error, "Cannot create ROOT file '" << filename_ << "' !");
+  for (merged_outputs::const_iterator it = outputs_.begin(); it != outputs_.end(); it++) {
+    TDirectory * directory = root_file.get();
+    if (!it->first.empty()) directory = root_file->mkdir(it->first.c_str(), it->second.title.c_str());
+    it->second.dss->save_in_root_file(directory);
+    if (it->first.empty()) it->second.dss->save_statistics_in_root_file(directory);
+  }
+  root_file->Close();
+  return;
+}
@@ -0,0 +1,181 @@
+// hc_rehisto_cache.cxx
+// Standard libraries :
+#include <vector>
+
+// Third party:
+// - Boost:
+#include <boost/program_options.hpp>
+
+// - Bayeux/datatools:
+#include <datatools/utils.h>
+#include <datatools/properties.h>
+#include <datatools/clhep_units.h>
+// - Bayeux/geomtools:
+#include <bayeux/geomtools/id_mgr.h>
+
+// Falaise:
+#include <falaise/falaise.h>
+
+// Root :
+#include "TFile.h"
+
+// This project :
+#include "compiled_id_selector.hpp"
+#include "data_statistics_simu.hpp"
+#include "event_analyzer.hpp"
+#include "event_cache.hpp"
+#include "geometry_context.hpp"
+#include "hc_constants.hpp"
+#include "mapping_snapshot.hpp"
+
+int main( int  argc_ , char **argv_  )
+{
+  falaise::initialize(argc_, argv_);
+  int error_code = EXIT_SUCCESS;
+  datatools::logger::priority logging = datatools::logger::PRIO_FATAL;
+
+  try {
+
+    std::vector<std::string> input_filenames;
+    std::string output_path = "";
+    std::string calo_mapping_config = "";
+    std::string tracker_mapping_config = "";
+    std::string mapping_cache_file = "";
+    bool        is_debug    = false;
+    double      calo_threshold_kev  = 0;
+
+    // Parse options:
+    namespace po = boost::program_options;
+    po::options_description opts("Allowed options");
+    opts.add_options()
+      ("help,h", "produce help message")
+      ("debug,d", "debug mode")
+      ("input,i",
+       po::value<std::vector<std::string> >(& input_filenames)->multitoken(),
+       "set a list of event cache files (from hc_analysis_data --cache)")
+      ("output,o",
+       po::value<std::string>(& output_path),
+       "set the output path")
+      ("calo-threshold,c",
+       po::value<double>(& calo_threshold_kev)->default_value(hc_constants::CALO_COMMISSIONING_HIGH_THRESHOLD_KEV),
+       "set the calorimeter threshold in keV")
+      ("calo_mapping,C",
+       po::value<std::string>(& calo_mapping_config),
+       "set the calorimeter mapping configuration from a datatools::properties ASCII file")
+      ("tracker_mapping,T",
+       po::value<std::string>(& tracker_mapping_config),
+       "set the tracker mapping configuration from a datatools::properties ASCII file")
+      ("mapping-cache",
+       po::value<std::string>(& mapping_cache_file),
+       "reuse the compiled mapping rules cached in this file, and add the new ones to it")
+      ; // end of options description
+
+    // Describe command line arguments :
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc_, argv_)
+	      .options(opts)
+	      .run(), vm);
+    po::notify(vm);
+
+    // Use command line arguments :
+    if (vm.count("help")) {
+      std::cout << "Usage : " << std::endl;
+      std::cout << opts << std::endl;
+      return(1);
+    }
+
+    // Use command line arguments :
+    else if (vm.count("debug")) {
+      is_debug = true;
+    }
+    if (is_debug) logging = datatools::logger::PRIO_DEBUG;
+
+    DT_THROW_IF(input_filenames.size() == 0, std::logic_error, "No input file(s) ! ");
+
+    if (output_path.empty()) {
+      output_path = ".";
+      DT_LOG_INFORMATION(logging, "No output path, default output path is = " + output_path);
+    }
+
+    std::clog << "INFO : Program producing root histograms from event caches, with new threshold and mapping cuts" << std::endl;
+
+    // Only the geom ID categories are needed by the mapping rules, the geometry is not built :
+    geometry_context my_geometry;
+    my_geometry.initialize(false);
+    const geomtools::id_mgr & my_id_mgr = my_geometry.get_id_mgr();
+
+    // Calo and tracker half commissioning mapping rules :
+    mapping_snapshot my_mapping_snapshot;
+    if (!mapping_cache_file.empty()) {
+      datatools::fetch_path_with_env(mapping_cache_file);
+      my_mapping_snapshot.load(mapping_cache_file);
+    }
+
+    compiled_id_selector hc_calo_selector;
+    my_mapping_snapshot.initialize_selector(hc_calo_selector, calo_mapping_config, my_id_mgr, compiled_id_selector::calo_category());
+    if (is_debug) hc_calo_selector.dump(std::clog, "Half commissioning calo selector: ");
+
+    compiled_id_selector hc_geiger_selector;
+    my_mapping_snapshot.initialize_selector(hc_geiger_selector, tracker_mapping_config, my_id_mgr, compiled_id_selector::geiger_category());
+    if (is_debug) hc_geiger_selector.dump(std::clog, "Half commissioning Geiger selector: ");
+
+    if (!mapping_cache_file.empty() && my_mapping_snapshot.is_modified()) my_mapping_snapshot.store(mapping_cache_file);
+
+    // Output ROOT file :
+    std::string string_buffer = output_path + "output_rootfile.root";
+    datatools::fetch_path_with_env(string_buffer);
+
+    TFile* root_file = new TFile(string_buffer.c_str(), "RECREATE");
+    root_file->mkdir("single_calo_energy",
+		     "Single calorimeter energy distribution");
+
+    data_statistics_simu my_dss;
+    my_dss.initialize();
+
+    event_analyzer my_analyzer;
+    my_analyzer.calo_selector = &hc_calo_selector;
+    my_analyzer.geiger_selector = &hc_geiger_selector;
+    my_analyzer.calo_threshold_kev = calo_threshold_kev;
+    my_analyzer.logging = logging;
+
+    std::size_t event_id = 0;
+    for (std::size_t ifile = 0; ifile < input_filenames.size(); ifile++)
+      {
+	std::string cache_filename = input_filenames[ifile];
+	datatools::fetch_path_with_env(cache_filename);
+	event_cache_reader reader;
+	reader.open(cache_filename);
+	const event_cache_header & header = reader.get_header();
+	std::clog << "INFO : Event cache '" << cache_filename << "' : " << header.number_of_events << " events";
+	if (datatools::is_valid(header.geiger_dead_time)) std::clog << ", Geiger dead time = " << header.geiger_dead_time / CLHEP::microsecond << " us";
+	std::clog << std::endl;
+
+	event_cache_event_view event;
+	while (reader.next(event))
+	  {
+	    DT_LOG_DEBUG(logging, "Event #" << event_id);
+	    my_analyzer.process(event);
+	    my_analyzer.fill(my_dss);
+	    event_id++;
+	  }
+      }
+
+    my_dss.save_in_root_file(root_file);
+    root_file->Close();
+
+    std::clog << "The end." << std::endl;
+  } // end of try
+
+  catch (std::exception & error) {
+    DT_LOG_FATAL(logging, error.what());
+    error_code = EXIT_FAILURE;
+  }
+
+  catch (...) {
+    DT_LOG_FATAL(logging, "Unexpected error!");
+    error_code = EXIT_FAILURE;
+  }
+
+  falaise::terminate();
+  return error_code;
+}
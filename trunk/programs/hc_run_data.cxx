@@ -0,0 +1,209 @@
+// hc_run_data.cxx
+// Standard libraries :
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// POSIX :
+#include <dirent.h>
+#include <sys/stat.h>
+
+// Third party:
+// - Boost:
+#include <boost/program_options.hpp>
+
+// - Bayeux/datatools:
+#include <datatools/utils.h>
+
+// Falaise:
+#include <falaise/falaise.h>
+
+// This project :
+#include "process_scheduler.hpp"
+
+/// Return the brio files of a directory, in the order of their names
+std::vector<std::string> list_brio_files(const std::string & directory_);
+
+/// Return the name of a file without its directory and extension
+std::string file_stem(const std::string & filename_);
+
+int main( int  argc_ , char **argv_  )
+{
+  falaise::initialize(argc_, argv_);
+  int error_code = EXIT_SUCCESS;
+  datatools::logger::priority logging = datatools::logger::PRIO_FATAL;
+
+  try {
+
+    std::string program = "";
+    std::vector<std::string> input_filenames;
+    std::string input_directory = "";
+    std::string output_path = "";
+    std::string log_directory = "";
+    std::string status_label = "";
+    std::size_t number_of_processes = 0;
+    std::size_t number_of_shards = 1;
+    std::size_t max_retries = 2;
+    bool        is_debug = false;
+
+    // Parse options:
+    namespace po = boost::program_options;
+    po::options_description opts("Allowed options (the other options are given to each worker process)");
+    opts.add_options()
+      ("help,h", "produce help message")
+      ("program,p",
+       po::value<std::string>(& program),
+       "set the program run by the worker processes (default : hc_analysis_data next to this program)")
+      ("input,i",
+       po::value<std::vector<std::string> >(& input_filenames)->multitoken(),
+       "set a list of input files")
+      ("input-dir",
+       po::value<std::string>(& input_directory),
+       "process all the .brio files of a directory (ex: the sorted data of a run)")
+      ("output,o",
+       po::value<std::string>(& output_path),
+       "set the output directory, the outputs of each file are prefixed by its name")
+      ("processes,j",
+       po::value<std::size_t>(& number_of_processes)->default_value(0),
+       "set the number of worker processes (0 : one per core)")
+      ("shards",
+       po::value<std::size_t>(& number_of_shards)->default_value(1),
+       "split each input file in this number of shards, processed as separate tasks (--shard option of the programs), -n applies to each shard : use -n 0 to process the whole files")
+      ("retries",
+       po::value<std::size_t>(& max_retries)->default_value(2),
+       "set the number of retries of a failed task")
+      ("log-dir",
+       po::value<std::string>(& log_directory),
+       "set the directory of the task logs (default : the output directory)")
+      ("status-label",
+       po::value<std::string>(& status_label)->default_value("FILE_ANALYZING"),
+       "set the label of the status lines of the task logs and of the summary (ex: FILE_SORTING)")
+      ("debug,d",
+       po::value<bool>(& is_debug)->zero_tokens()->default_value(false),
+       "debug mode")
+      ; // end of options description
+
+    // Describe command line arguments, unknown options are for the workers :
+    po::variables_map vm;
+    po::parsed_options parsed = po::command_line_parser(argc_, argv_)
+      .options(opts)
+      .allow_unregistered()
+      .run();
+    po::store(parsed, vm);
+    po::notify(vm);
+    const std::vector<std::string> worker_options = po::collect_unrecognized(parsed.options, po::include_positional);
+
+    // Use command line arguments :
+    if (vm.count("help")) {
+      std::cout << "Usage : " << std::endl;
+      std::cout << opts << std::endl;
+      return(1);
+    }
+
+    // Use command line arguments :
+    if (vm.count("debug")) {
+      is_debug = vm["debug"].as<bool>();
+    }
+
+    if (is_debug) logging = datatools::logger::PRIO_DEBUG;
+
+    if (program.empty()) {
+      const std::string self = argv_[0];
+      const std::size_t slash = self.find_last_of('/');
+      program = (slash == std::string::npos ? std::string("") : self.substr(0, slash + 1)) + "hc_analysis_data";
+    }
+    if (!input_directory.empty()) {
+      datatools::fetch_path_with_env(input_directory);
+      const std::vector<std::string> directory_files = list_brio_files(input_directory);
+      input_filenames.insert(input_filenames.end(), directory_files.begin(), directory_files.end());
+    }
+    DT_THROW_IF(input_filenames.empty(), std::logic_error, "No input file(s) ! ");
+    DT_THROW_IF(number_of_shards == 0, std::logic_error, "Invalid number of shards !");
+    if (output_path.empty()) output_path = ".";
+    datatools::fetch_path_with_env(output_path);
+    if (log_directory.empty()) log_directory = output_path;
+    datatools::fetch_path_with_env(log_directory);
+    if (number_of_processes == 0) number_of_processes = std::max(1u, std::thread::hardware_concurrency());
+
+    // One task per shard of each file, the file size gives the cost of a shard :
+    process_scheduler scheduler;
+    scheduler.set_max_retries(max_retries);
+    scheduler.set_status_label(status_label);
+    for (std::size_t ifile = 0; ifile < input_filenames.size(); ifile++) {
+      datatools::fetch_path_with_env(input_filenames[ifile]);
+      struct stat file_stat;
+      DT_THROW_IF(::stat(input_filenames[ifile].c_str(), &file_stat) != 0, std::logic_error,
+		  "Input file '" << input_filenames[ifile] << "' does not exist !");
+      const std::string stem = file_stem(input_filenames[ifile]);
+      for (std::size_t ishard = 0; ishard < number_of_shards; ishard++) {
+	process_scheduler::task a_task;
+	a_task.name = stem;
+	a_task.arguments.push_back(program);
+	a_task.arguments.push_back("-i");
+	a_task.arguments.push_back(input_filenames[ifile]);
+	a_task.arguments.push_back("-o");
+	a_task.arguments.push_back(output_path + "/" + stem + "_");
+	if (number_of_shards > 1) {
+	  const std::string shard = std::to_string(ishard) + "/" + std::to_string(number_of_shards);
+	  a_task.name += "_shard_" + std::to_string(ishard) + "_of_" + std::to_string(number_of_shards);
+	  a_task.arguments.push_back("--shard");
+	  a_task.arguments.push_back(shard);
+	}
+	a_task.arguments.insert(a_task.arguments.end(), worker_options.begin(), worker_options.end());
+	a_task.log_filename = log_directory + "/" + a_task.name + ".log";
+	a_task.cost = file_stat.st_size / number_of_shards;
+	scheduler.add_task(a_task);
+      }
+    }
+
+    std::clog << "INFO : Running " << scheduler.get_tasks().size() << " tasks of '" << program << "' with "
+	      << number_of_processes << " processes" << std::endl;
+    const std::size_t number_of_failed_tasks = scheduler.run(number_of_processes);
+    scheduler.print_summary(std::cout);
+    if (number_of_failed_tasks > 0) {
+      std::clog << "ERROR : " << number_of_failed_tasks << " tasks failed, see their logs in '" << log_directory << "'" << std::endl;
+      error_code = EXIT_FAILURE;
+    }
+
+    std::clog << "The end." << std::endl;
+  } // end of try
+
+  catch (std::exception & error) {
+    DT_LOG_FATAL(logging, error.what());
+    error_code = EXIT_FAILURE;
+  }
+
+  catch (...) {
+    DT_LOG_FATAL(logging, "Unexpected error!");
+    error_code = EXIT_FAILURE;
+  }
+
+  falaise::terminate();
+  return error_code;
+}
+
+std::vector<std::string> list_brio_files(const std::string & directory_)
+{
+  const std::string extension = ".brio";
+  std::vector<std::string> filenames;
+  DIR * directory = ::opendir(directory_.c_str());
+  DT_THROW_IF(directory == nullptr, std::runtime_error, "Cannot read input directory '" << directory_ << "' !");
+  while (const struct dirent * an_entry = ::readdir(directory)) {
+    const std::string filename = an_entry->d_name;
+    if (filename.size() > extension.size()
+	&& filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0) {
+      filenames.push_back(directory_ + "/" + filename);
+    }
+  }
+  ::closedir(directory);
+  std::sort(filenames.begin(), filenames.end());
+  return filenames;
+}
+
+std::string file_stem(const std::string & filename_)
+{
+  std::string stem = filename_.substr(filename_.find_last_of('/') + 1);
+  const std::size_t dot = stem.find_last_of('.');
+  if (dot != std::string::npos) stem.erase(dot);
+  return stem;
+}
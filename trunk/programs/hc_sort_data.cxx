@@ -3,6 +3,8 @@
 // #include <iostream>
 // #include <bitset>
 // #include <fstream>
+#include <memory>
+#include <set>
 
 // Third party:
 // - Boost:
@@ -12,25 +14,64 @@
 #include <datatools/utils.h>
 #include <datatools/io_factory.h>
 
-// - Bayeux/geomtools:
-#include <bayeux/geomtools/manager.h>
-#include <bayeux/geomtools/id_mgr.h>
-#include <bayeux/geomtools/id_selector.h>
-
 // - Bayeux/mctools:
 #include <mctools/simulated_data.h>
 
 // - Bayeux/dpp:
-#include <dpp/input_module.h>
 #include <dpp/output_module.h>
 
 // Falaise:
 #include <falaise/falaise.h>
 
+// Root :
+#include "TROOT.h"
+
+// This project :
+#include "async_event_writer.hpp"
+#include "event_index.hpp"
+#include "event_record_loader.hpp"
+#include "event_sorter.hpp"
+#include "event_source.hpp"
+#include "job_spool.hpp"
+#include "mapping_layout.hpp"
+#include "ordered_event_pipeline.hpp"
+
+/// Sorting rules and output files of one mapping layout
+struct layout_sorting
+{
+  mapping_layout layout;
+  event_sorter sorter;
+  dpp::output_module sorted_writer;
+  dpp::output_module sorted_with_geiger_writer;
+  std::size_t sorted_bit = 0;             ///< Selector bit in the event index
+  std::size_t sorted_with_geiger_bit = 0; ///< Selector bit in the event index
+  std::size_t sorted_output = 0;             ///< Output bit in the brio writer
+  std::size_t sorted_with_geiger_output = 0; ///< Output bit in the brio writer
+};
+
+/// Layouts matched by one event record
+struct sorting_result
+{
+  uint32_t file_index = 0;    ///< Source file of the record
+  uint64_t record_number = 0; ///< Record number in its source file
+  uint64_t selector_mask = 0; ///< Selector bits in the event index
+  uint64_t output_mask = 0;   ///< Output bits in the brio writer
+};
+
+/// Sort the events of one command line, or serve the jobs of a spool
+int sort_data(const std::vector<std::string> & arguments_, job_context & context_);
 
 int main( int  argc_ , char **argv_  )
 {
   falaise::initialize(argc_, argv_);
+  job_context context;
+  const int error_code = sort_data(std::vector<std::string>(argv_ + 1, argv_ + argc_), context);
+  falaise::terminate();
+  return error_code;
+}
+
+int sort_data(const std::vector<std::string> & arguments_, job_context & context_)
+{
   int error_code = EXIT_SUCCESS;
   datatools::logger::priority logging = datatools::logger::PRIO_FATAL;
 
@@ -40,8 +81,21 @@ int main( int  argc_ , char **argv_  )
     std::string output_path = "";
     std::string calo_mapping_config = "";
     std::string tracker_mapping_config = "";
+    std::string mapping_cache_file = "";
+    std::string spool_directory = "";
+    double      poll_interval = 1;
+    std::vector<std::string> layout_descriptions;
     std::size_t max_events  = 0;
+    std::size_t number_of_threads = 1;
+    std::size_t write_queue_size = 64;
+    std::size_t prefetch_size = 128;
+    uint64_t    first_event = 0;
+    uint64_t    last_event = 0;
+    std::string shard_token = "";
     bool is_debug = false;
+    bool write_index = false;
+    bool index_only = false;
+    bool full_geometry = false;
 
     // Parse options:
     namespace po = boost::program_options;
@@ -57,18 +111,54 @@ int main( int  argc_ , char **argv_  )
        "set the output path")
       ("number_events,n",
        po::value<std::size_t>(& max_events)->default_value(10),
-       "set the maximum number of events")
+       "set the maximum number of events of each input file, from the start of its record range or shard (0 : all)")
+      ("threads,t",
+       po::value<std::size_t>(& number_of_threads)->default_value(1),
+       "set the number of sorting threads, each decoding and matching its own records, the sorted files are identical to a serial run (1 : serial event loop)")
       ("calo_mapping,C",
        po::value<std::string>(& calo_mapping_config),
        "set the calorimeter mapping configuration from a datatools::properties ASCII file")
       ("tracker_mapping,T",
        po::value<std::string>(& tracker_mapping_config),
        "set the tracker mapping configuration from a datatools::properties ASCII file")
+      ("layout,L",
+       po::value<std::vector<std::string> >(& layout_descriptions)->multitoken(),
+       "add named mapping layouts 'name:calo_mapping_file:tracker_mapping_file', written in name_sorted.brio and name_sorted_with_geiger.brio")
+      ("first-event",
+       po::value<uint64_t>(& first_event),
+       "read the records of each input file from this record number (from 0), the outputs are prefixed by records_first_last_")
+      ("last-event",
+       po::value<uint64_t>(& last_event),
+       "read the records of each input file up to this record number (excluded)")
+      ("shard",
+       po::value<std::string>(& shard_token),
+       "read only the shard 'k/N' (0 <= k < N) of N equal parts of each input file, the outputs are prefixed by shard_k_of_N_, -n still limits each shard from its start")
+      ("prefetch",
+       po::value<std::size_t>(& prefetch_size)->default_value(128),
+       "set the number of event records decoded in advance by a background reader thread, with read ahead of the next input file (0 : read in the event loop), with --threads only the read ahead is kept")
+      ("write-queue",
+       po::value<std::size_t>(& write_queue_size)->default_value(64),
+       "set the number of event records queued for the background brio writer thread (0 : write in the event loop)")
+      ("index",
+       "write the accepted events (source file, record number, matched selectors) in output_event_index.txt")
+      ("index-only",
+       "write the event index only, without the sorted brio files")
+      ("full-geometry",
+       "build the full geometry manager (slow), by default only the geom ID categories are loaded")
+      ("mapping-cache",
+       po::value<std::string>(& mapping_cache_file),
+       "reuse the compiled mapping rules cached in this file, and add the new ones to it")
+      ("spool",
+       po::value<std::string>(& spool_directory),
+       "serve the jobs of a spool directory ('name.job' files of options) with the geometry loaded once, until a 'stop' file or SIGTERM")
+      ("poll-interval",
+       po::value<double>(& poll_interval)->default_value(1),
+       "with --spool, set the interval in seconds between two scans of the spool directory")
       ; // end of options description
 
     // Describe command line arguments :
     po::variables_map vm;
-    po::store(po::command_line_parser(argc_, argv_)
+    po::store(po::command_line_parser(arguments_)
 	      .options(opts)
 	      .run(), vm);
     po::notify(vm);
@@ -87,6 +177,29 @@ int main( int  argc_ , char **argv_  )
     }
 
     if (is_debug) logging = datatools::logger::PRIO_DEBUG;
+    if (vm.count("index")) write_index = true;
+    if (vm.count("index-only")) {
+      write_index = true;
+      index_only = true;
+    }
+    if (vm.count("full-geometry")) full_geometry = true;
+
+    if (!spool_directory.empty()) {
+      DT_THROW_IF(context_.serving, std::logic_error, "A job can not serve a spool !");
+      // Geometry and compiled mapping rules kept warm for all the jobs :
+      context_.initialize_geometry(full_geometry);
+      context_.load_snapshot(mapping_cache_file);
+      context_.serving = true;
+      job_spool spool;
+      spool.initialize(spool_directory, poll_interval);
+      spool.serve([&context_] (const std::vector<std::string> & job_arguments_) -> int
+		  {
+		    const int job_error_code = sort_data(job_arguments_, context_);
+		    context_.store_snapshot();
+		    return job_error_code;
+		  });
+      return error_code;
+    }
 
     DT_LOG_INFORMATION(logging, "List of input file(s) : ");
     for (auto file = input_filenames.begin();
@@ -104,170 +217,218 @@ int main( int  argc_ , char **argv_  )
     std::clog << "INFO : Program sorting raw data file to reduce the number of event / file" << std::endl;
     std::clog << "INFO : Events have to touch GG cells or OMs in given zones to be saved" << std::endl;
 
-    std::string manager_config_file;
-    manager_config_file = "@falaise:config/snemo/demonstrator/geometry/4.0/manager.conf";
-    datatools::fetch_path_with_env(manager_config_file);
-    datatools::properties manager_config;
-    datatools::properties::read_config (manager_config_file,
-					manager_config);
+    // The sorting rules only need the geom ID categories (already loaded for the jobs of a spool) :
+    context_.initialize_geometry(full_geometry);
 
-    geomtools::manager my_geom_manager;
-    manager_config.update ("build_mapping", true);
-    if (manager_config.has_key ("mapping.excluded_categories"))
-      {
-	manager_config.erase ("mapping.excluded_categories");
-      }
-    my_geom_manager.initialize (manager_config);
+    // Compiled mapping rules of the previous runs :
+    context_.load_snapshot(mapping_cache_file);
 
     // Simulated Data "SD" bank label :
     std::string SD_bank_label = "SD";
 
-    int max_record_total = static_cast<int>(max_events) * static_cast<int>(input_filenames.size());
-    std::clog << "max_record total = " << max_record_total << std::endl;
-    std::clog << "max_events       = " << max_events << std::endl;
-
-    // Event reader :
-    dpp::input_module reader;
-    datatools::properties reader_config;
-    reader_config.store ("logging.priority", "debug");
-    reader_config.store("files.mode", "list");
-    reader_config.store("files.list.filenames", input_filenames);
-    reader_config.store("max_record_total", max_record_total);
-    reader_config.store("max_record_per_file", static_cast<int>(max_events));
-    reader.initialize_standalone (reader_config);
-    datatools::multi_properties iMetadataStore = reader.get_metadata_store();
-    // reader.tree_dump(std::clog, "Simulated data reader module");
-
-    // Event record :
-    datatools::things ER;
-
-    // Calo and tracker half commissioning mapping configuration :
-    datatools::properties calo_config;
-    if (!calo_mapping_config.empty()) {
-      calo_config.read_configuration(calo_mapping_config);
+    std::clog << "max_events per file = " << max_events << std::endl;
+
+    // Event source, file by file :
+    event_source source;
+    source.set_logging(logging);
+    source.set_prefetch(prefetch_size);
+    // With several threads, the records are decoded by the workers :
+    source.set_positions_only(number_of_threads > 1);
+
+    // Part of each input file only (-n records at most), outputs named after the part :
+    if (!shard_token.empty()) {
+      DT_THROW_IF(vm.count("first-event") || vm.count("last-event"), std::logic_error,
+		  "A shard is not used with a record range !");
+      uint32_t shard = 0;
+      uint32_t number_of_shards = 0;
+      event_source::parse_shard(shard_token, shard, number_of_shards);
+      source.set_shard(shard, number_of_shards);
     }
-
-    datatools::properties tracker_config;
-    if (!tracker_mapping_config.empty()) tracker_config.read_configuration(tracker_mapping_config);
-
-    geomtools::id_selector hc_calo_selector(my_geom_manager.get_id_mgr());
-    if (!calo_mapping_config.empty()) {
-      std::ifstream ifile(calo_mapping_config);
-      bool empty = false;
-      if (ifile.peek() == std::ifstream::traits_type::eof()) empty = true;
-      if (!empty) hc_calo_selector.initialize(calo_config);
+    else if (vm.count("first-event") || vm.count("last-event")) source.set_record_range(first_event, last_event);
+    output_path += source.get_range_tag();
+    source.initialize(input_filenames, max_events);
+    datatools::multi_properties iMetadataStore = source.get_metadata_store();
+
+    // Index of accepted events, two selectors per layout :
+    event_index output_index;
+    for (std::size_t ifile = 0; ifile < input_filenames.size(); ifile++) output_index.add_file(input_filenames[ifile]);
+
+    // Event record, exchanged with the brio writer :
+    std::unique_ptr<datatools::things> ER(new datatools::things);
+
+    // Calo and tracker half commissioning mapping layouts, each event is matched against all of them :
+    std::vector<mapping_layout> layouts;
+    if (layout_descriptions.empty() || !calo_mapping_config.empty() || !tracker_mapping_config.empty()) {
+      mapping_layout default_layout;
+      default_layout.name = mapping_layout::default_name();
+      default_layout.calo_mapping_config = calo_mapping_config;
+      default_layout.tracker_mapping_config = tracker_mapping_config;
+      layouts.push_back(default_layout);
     }
-    if (is_debug) hc_calo_selector.dump(std::clog, "Half commissioning calo selector: ");
-
-    geomtools::id_selector hc_geiger_selector(my_geom_manager.get_id_mgr());
-    if (!tracker_mapping_config.empty()) {
-      std::ifstream ifile(tracker_mapping_config);
-      bool empty = false;
-      if (ifile.peek() == std::ifstream::traits_type::eof()) empty = true;
-      if (!empty) hc_geiger_selector.initialize(tracker_config);
+    for (std::size_t ilayout = 0; ilayout < layout_descriptions.size(); ilayout++) {
+      layouts.push_back(mapping_layout::parse(layout_descriptions[ilayout]));
     }
-    if (is_debug) hc_geiger_selector.dump(std::clog, "Half commissioning Geiger selector: ");
 
     //============================================//
-    //          output file  and writer           //
+    //          output files  and writers         //
     //============================================//
 
-    // Name of sorted (matching rules) SD output file :
-    std::string sorted_sd_brio = output_path + "output_sorted.brio";
-
-    // Event writer for sorted SD :
-    dpp::output_module sorted_writer;
-    datatools::properties sorted_writer_config;
-    sorted_writer_config.store ("logging.priority", "fatal");
-    sorted_writer_config.store ("files.mode", "single");
-    sorted_writer_config.store ("files.single.filename", sorted_sd_brio);
-    sorted_writer.grab_metadata_store() = iMetadataStore;
-    sorted_writer.initialize_standalone(sorted_writer_config);
-
-    // Name of sorted (matching rules) SD output file :
-    std::string sorted_with_geiger_brio = output_path + "output_sorted_with_geiger.brio";
-
-    // Event writer for sorted SD :
-    dpp::output_module sorted_with_geiger_writer;
-    datatools::properties sorted_with_geiger_config;
-    sorted_with_geiger_config.store ("logging.priority", "fatal");
-    sorted_with_geiger_config.store ("files.mode", "single");
-    sorted_with_geiger_config.store ("files.single.filename", sorted_with_geiger_brio);
-    sorted_with_geiger_writer.grab_metadata_store() = iMetadataStore;
-    sorted_with_geiger_writer.initialize_standalone(sorted_with_geiger_config);
+    std::vector<std::unique_ptr<layout_sorting> > sortings;
+    std::set<std::string> layout_names;
+    for (std::size_t ilayout = 0; ilayout < layouts.size(); ilayout++) {
+      DT_THROW_IF(!layout_names.insert(layouts[ilayout].name).second,
+		  std::logic_error,
+		  "Layout name '" << layouts[ilayout].name << "' is used twice !");
+
+      sortings.push_back(std::unique_ptr<layout_sorting>(new layout_sorting));
+      layout_sorting & a_sorting = *sortings.back();
+      a_sorting.layout = layouts[ilayout];
+      a_sorting.layout.initialize(context_.geometry.get_id_mgr(), &context_.snapshot);
+      if (is_debug) a_sorting.layout.dump(std::clog, "Half commissioning mapping layout: ");
+
+      // Sorting rules :
+      a_sorting.sorter.calo_selector = &a_sorting.layout.calo_selector;
+      a_sorting.sorter.geiger_selector = &a_sorting.layout.geiger_selector;
+      a_sorting.sorter.logging = logging;
+
+      a_sorting.sorted_bit = output_index.add_selector(a_sorting.layout.name + "_sorted");
+      a_sorting.sorted_with_geiger_bit = output_index.add_selector(a_sorting.layout.name + "_sorted_with_geiger");
+      if (index_only) continue;
+
+      // Name of sorted (matching rules) SD output file :
+      std::string sorted_sd_brio = output_path + a_sorting.layout.name + "_sorted.brio";
+
+      // Event writer for sorted SD :
+      datatools::properties sorted_writer_config;
+      sorted_writer_config.store ("logging.priority", "fatal");
+      sorted_writer_config.store ("files.mode", "single");
+      sorted_writer_config.store ("files.single.filename", sorted_sd_brio);
+      a_sorting.sorted_writer.grab_metadata_store() = iMetadataStore;
+      a_sorting.sorted_writer.initialize_standalone(sorted_writer_config);
+
+      // Name of sorted (matching rules) SD output file :
+      std::string sorted_with_geiger_brio = output_path + a_sorting.layout.name + "_sorted_with_geiger.brio";
+
+      // Event writer for sorted SD :
+      datatools::properties sorted_with_geiger_config;
+      sorted_with_geiger_config.store ("logging.priority", "fatal");
+      sorted_with_geiger_config.store ("files.mode", "single");
+      sorted_with_geiger_config.store ("files.single.filename", sorted_with_geiger_brio);
+      a_sorting.sorted_with_geiger_writer.grab_metadata_store() = iMetadataStore;
+      a_sorting.sorted_with_geiger_writer.initialize_standalone(sorted_with_geiger_config);
+    }
+
+    context_.store_snapshot();
+
+    // Sorted records of all layouts written in the event order by a background thread :
+    async_event_writer brio_writer(write_queue_size);
+    if (!index_only) {
+      for (std::size_t isorting = 0; isorting < sortings.size(); isorting++) {
+	sortings[isorting]->sorted_output = brio_writer.add_output(sortings[isorting]->sorted_writer);
+	sortings[isorting]->sorted_with_geiger_output = brio_writer.add_output(sortings[isorting]->sorted_with_geiger_writer);
+      }
+    }
+    if (brio_writer.is_asynchronous()) ROOT::EnableThreadSafety();
+    brio_writer.start();
 
     // Event counter :
     int event_id    = 0;
 
-    while (!reader.is_terminated())
-      {
-	DT_LOG_DEBUG(logging, "Event #" + event_id);
-	reader.process(ER);
-
-	bool match_rules_event = false;
-	bool match_rules_with_geiger = false;
+    // Sorting rules of all layouts, one copy per worker thread :
+    std::vector<event_sorter> my_sorters;
+    for (std::size_t isorting = 0; isorting < sortings.size(); isorting++) my_sorters.push_back(sortings[isorting]->sorter);
 
+    // Match one event record against all layouts :
+    auto match_record = [&] (std::vector<event_sorter> & sorters_,
+			     const datatools::things & record_,
+			     sorting_result & result_)
+      {
 	// A plain `mctools::simulated_data' object is stored here :
-	if (ER.has(SD_bank_label) && ER.is_a<mctools::simulated_data>(SD_bank_label))
-	  {
-	    // Access to the "SD" bank with a stored `mctools::simulated_data' :
-	    const mctools::simulated_data & SD = ER.get<mctools::simulated_data>(SD_bank_label);
-
-	    // Main calo hits :
-	    if (SD.has_step_hits("calo"))
-	      {
-		mctools::simulated_data::hit_handle_collection_type BSHC = SD.get_step_hits("calo");
-		if (is_debug) std::clog << "BSCH calo step hits # = " << BSHC.size() << std::endl;
-
-		for (mctools::simulated_data::hit_handle_collection_type::const_iterator i = BSHC.begin();
-		     i != BSHC.end();
-		     i++)
-		  {
-		    const mctools::base_step_hit & BSH = i->get();
-		    // extract the corresponding geom ID:
-		    const geomtools::geom_id & main_calo_gid = BSH.get_geom_id();
-		    if (hc_calo_selector.is_initialized()) {
-		      if (hc_calo_selector.match(main_calo_gid)) match_rules_event = true;
-		    }
-
-		  } // end of for i BSHC
-
-	      } // end of if has step hits "calo"
+	if (!record_.has(SD_bank_label) || !record_.is_a<mctools::simulated_data>(SD_bank_label)) return;
 
+	// Access to the "SD" bank with a stored `mctools::simulated_data' :
+	const mctools::simulated_data & SD = record_.get<mctools::simulated_data>(SD_bank_label);
 
-	    if (SD.has_step_hits("gg"))
-	      {
-		mctools::simulated_data::hit_handle_collection_type BSHC_gg = SD.get_step_hits("gg");
-		if (is_debug) std::clog << "BSCH geiger step hits # = " << BSHC_gg.size() << std::endl;
-		for (mctools::simulated_data::hit_handle_collection_type::const_iterator i = BSHC_gg.begin();
-		     i != BSHC_gg.end();
-		     i++)
-		  {
-		    const mctools::base_step_hit & BSH = i->get();
-		    if (is_debug) BSH.tree_dump(std::clog, "A Geiger Base Step Hit : ", "INFO : ");
-		    const geomtools::geom_id & geiger_gid = BSH.get_geom_id();
-
-		    if (hc_geiger_selector.is_initialized()) {
-		      if (hc_geiger_selector.match(geiger_gid))
-			{
-			  match_rules_event = true;
-			  match_rules_with_geiger = true;
-			}
-		    }
+	// Event is decoded once and matched against all layouts :
+	for (std::size_t isorting = 0; isorting < sortings.size(); isorting++)
+	  {
+	    const layout_sorting & a_sorting = *sortings[isorting];
+	    event_sorter & a_sorter = sorters_[isorting];
+	    a_sorter.process(SD);
+
+	    if (a_sorter.match_rules_event) result_.selector_mask |= uint64_t(1) << a_sorting.sorted_bit;
+	    if (a_sorter.match_rules_with_geiger) result_.selector_mask |= uint64_t(1) << a_sorting.sorted_with_geiger_bit;
+
+	    if (index_only) continue;
+	    if (a_sorter.match_rules_event) result_.output_mask |= uint64_t(1) << a_sorting.sorted_output;
+	    if (a_sorter.match_rules_with_geiger) result_.output_mask |= uint64_t(1) << a_sorting.sorted_with_geiger_output;
+	  }
+	return;
+      };
+
+    // Commit one event record, in the input order :
+    auto commit_record = [&] (std::unique_ptr<datatools::things> & record_,
+			      const sorting_result & result_)
+      {
+	if (write_index && result_.selector_mask != 0) output_index.add_entry(result_.file_index, result_.record_number, result_.selector_mask);
 
-		  } // end of i bsh
-	      } // end of if has step hits "gg"
+	// The record is moved to the brio writer, an empty one comes back :
+	brio_writer.write(record_, result_.output_mask);
+	return;
+      };
 
-	    if (match_rules_event) sorted_writer.process(ER);
-	    if (match_rules_with_geiger) sorted_with_geiger_writer.process(ER);
+    if (number_of_threads <= 1)
+      {
+	while (source.read(ER))
+	  {
+	    DT_LOG_DEBUG(logging, "Event #" << event_id);
 
-	  } // end of if ER has flaged_SD_bank_label
+	    sorting_result result;
+	    result.file_index = source.get_file_index();
+	    result.record_number = source.get_record_number();
+	    match_record(my_sorters, *ER, result);
+	    commit_record(ER, result);
 
-	event_id++;
+	    event_id++;
 
-	ER.clear();
-      } // end of reader is terminated
+	    ER->clear();
+	  } // end of source read
+      }
+    else
+      {
+	// One reader thread handing out the record positions, N workers decoding
+	// (the full Bayeux deserialization) and matching the records, the accepted
+	// events are committed in the input order by this thread, as in the serial loop :
+	ROOT::EnableThreadSafety();
+	std::vector<std::vector<event_sorter> > worker_sorters(number_of_threads, my_sorters);
+	std::vector<std::unique_ptr<event_record_loader> > worker_loaders;
+	for (std::size_t iworker = 0; iworker < number_of_threads; iworker++) {
+	  worker_loaders.push_back(std::unique_ptr<event_record_loader>(new event_record_loader(source.get_filenames(), logging)));
+	}
+
+	ordered_event_pipeline<sorting_result> pipeline(number_of_threads, 4 * number_of_threads);
+	pipeline.run([&] (std::unique_ptr<datatools::things> &, sorting_result & result_) -> bool
+		     {
+		       if (!source.read_position(result_.file_index, result_.record_number)) return false;
+		       DT_LOG_DEBUG(logging, "Event #" << event_id);
+		       event_id++;
+		       return true;
+		     },
+		     [&] (std::size_t worker_, datatools::things & record_, sorting_result & result_)
+		     {
+		       worker_loaders[worker_]->load(result_.file_index, result_.record_number, record_);
+		       match_record(worker_sorters[worker_], record_, result_);
+		     },
+		     commit_record);
+      }
+    brio_writer.terminate();
 
+    if (write_index) {
+      std::string index_filename = output_path + "output_event_index.txt";
+      datatools::fetch_path_with_env(index_filename);
+      output_index.store(index_filename);
+      std::clog << "INFO : Event index with " << output_index.entries.size() << " events written in " << index_filename << std::endl;
+    }
 
     std::clog << "The end." << std::endl;
   } // end of try
@@ -282,6 +443,5 @@ int main( int  argc_ , char **argv_  )
     error_code = EXIT_FAILURE;
   }
 
-  falaise::terminate();
   return error_code;
 }
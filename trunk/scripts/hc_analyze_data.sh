@@ -20,6 +20,8 @@ echo "Allowed options: "
 echo "-h  [ --help ]     produce help message"
 echo "-n  [ --number ]   set the number of events"
 echo "-r  [--run-number] set the run number to analyze"
+echo "-q  [--spool]      queue one job per file in the spool directory of a running 'hc_analysis_data --spool', wait for the jobs and collect their outputs"
+echo "-j  [--processes] run the files with this number of local worker processes (hc_run_data) instead of one after the other"
 echo " "
 echo "./hc_analysis_raw_data.sh -n number_of_events"
 echo "Default value : number_of_events = 10"
@@ -35,6 +37,8 @@ echo " "
 START_DATE=`date "+%Y-%m-%d"`
 nb_event=10
 run_number=UNDEFINED
+spool_dir=UNDEFINED
+number_of_processes=UNDEFINED
 
 while [ -n "$1" ];
 do
@@ -50,6 +54,12 @@ do
     if [ "x$arg" = "x-r" ]; then
 	run_number=$arg_value
     fi
+    if [ "x$arg" = "x-q" -o "x$arg" = "x--spool" ]; then
+	spool_dir=$arg_value
+    fi
+    if [ "x$arg" = "x-j" -o "x$arg" = "x--processes" ]; then
+	number_of_processes=$arg_value
+    fi
     shift 2
 done
 
@@ -75,21 +85,76 @@ fi
 HC_CALO_MAPPING_CONFIG_FILE=${INPUT_RUN_DIR}/hc_mapping/mapping_calo.conf
 HC_TRACKER_MAPPING_CONFIG_FILE=${INPUT_RUN_DIR}/hc_mapping/mapping_tracker.conf
 
+# Move the analyzed files of an input file, written with the given path prefix, in the brio and root directories
+function collect_analyzed_files(){
+    local INPUT_FILENAME=$1
+    local OUTPUT_PREFIX=$2
+    OUTPUT_CALO_TRACKER_FILENAME="${OUTPUT_PREFIX}output_calo_tracker_events.brio"
+    OUTPUT_ROOT_FILE="${OUTPUT_PREFIX}output_rootfile.root"
+
+    mv ${OUTPUT_CALO_TRACKER_FILENAME} ${ANALYZED_BRIO_OUTPUT_PATH}/${INPUT_FILENAME}_calo_tracker.brio
+    if [ $? -eq 1 ];
+    then
+	echo "ERROR : mv ${OUTPUT_CALO_TRACKER_FILENAME} into ${ANALYZED_BRIO_OUTPUT_PATH}/${INPUT_FILENAME}_calo_tracker.brio FAILED !"
+	exit 0
+    fi
+
+    mv ${OUTPUT_ROOT_FILE} ${ANALYZED_ROOT_OUTPUT_PATH}/${INPUT_FILENAME}_analyzed.root
+    if [ $? -eq 1 ];
+    then
+	echo "ERROR : mv ${OUTPUT_ROOT_FILE} into ${ANALYZED_ROOT_OUTPUT_PATH}/${INPUT_FILENAME}_analyzed.root FAILED !"
+	exit 0
+    fi
+}
+
 file_counter=0
 
+# Outputs of the worker processes or of the spool jobs, prefixed by the input file names,
+# the analyzed files are moved by the collect function and the other outputs of each file stay there :
+STAGING_OUTPUT_PATH=${ANALYZED_OUTPUT_PATH}/staging
+mkdir -p ${STAGING_OUTPUT_PATH}
+
+if [ "x${number_of_processes}" != "xUNDEFINED" ];
+then
+    # Files scheduled on the local worker processes, outputs prefixed by the input file names in the staging directory :
+    ${SW_PATH}/hc_run_data -p ${SW_PATH}/${SW_NAME} --input-dir ${INPUT_SORTED_DIR} -o ${STAGING_OUTPUT_PATH} -j ${number_of_processes} --log-dir ${LOG_DIR} --status-label FILE_ANALYZING -n $nb_event -C ${HC_CALO_MAPPING_CONFIG_FILE} -T ${HC_TRACKER_MAPPING_CONFIG_FILE}
+    if [ $? -eq 1 ];
+    then
+	echo "ERROR : some files of ${INPUT_SORTED_DIR} FAILED, see the logs in ${LOG_DIR} !"
+	exit 0
+    fi
+fi
+
 for file in ${INPUT_FILES}
 do
     INPUT_FILENAME=`basename ${file} .brio` # .brio after basename $file remove extension of the input file
     INPUT_FILENAME=`basename ${INPUT_FILENAME} _sorted` # _sorted after basename $INPUT_FILENAME remove extension _sorted of the input file
 
-    OUTPUT_CALO_TRACKER_FILENAME="output_calo_tracker_events.brio"
-    OUTPUT_ROOT_FILE="output_rootfile.root"
-
     LOG_FILE=${LOG_DIR}/${INPUT_FILENAME}_analyzed.log
 
+    if [ "x${number_of_processes}" != "xUNDEFINED" ];
+    then
+	# Already processed by the local worker processes, their outputs are prefixed by the full input file name :
+	collect_analyzed_files ${INPUT_FILENAME} ${STAGING_OUTPUT_PATH}/`basename ${file} .brio`_
+	let file_counter++
+	continue
+    fi
+
     echo "Mapping calo :" ${HC_CALO_MAPPING_CONFIG_FILE}
     echo "Mapping tracker :" ${HC_TRACKER_MAPPING_CONFIG_FILE}
 
+    if [ "x${spool_dir}" != "xUNDEFINED" ];
+    then
+	# Outputs written in the staging directory by the program serving the spool, collected below :
+	JOB_FILE=${spool_dir}/${INPUT_FILENAME}_analyzed
+	rm -f ${JOB_FILE}.done ${JOB_FILE}.failed
+	echo "-i ${file} -o ${STAGING_OUTPUT_PATH}/`basename ${file} .brio`_ -n $nb_event -C ${HC_CALO_MAPPING_CONFIG_FILE} -T ${HC_TRACKER_MAPPING_CONFIG_FILE}" > ${JOB_FILE}.tmp
+	mv ${JOB_FILE}.tmp ${JOB_FILE}.job # the job is visible only once complete
+	echo "Job queued in ${JOB_FILE}.job"
+	let file_counter++
+	continue
+    fi
+
     echo "Starting process..."
     echo "Processing..."
 
@@ -101,22 +166,44 @@ do
 	exit 0
     fi
 
-    mv ${ANALYZED_OUTPUT_PATH}/${OUTPUT_CALO_TRACKER_FILENAME} ${ANALYZED_BRIO_OUTPUT_PATH}/${INPUT_FILENAME}_calo_tracker.brio
-    if [ $? -eq 1 ];
-    then
-	echo "ERROR : mv ${ANALYZED_OUTPUT_PATH}/${OUTPUT_CALO_TRACKER_FILENAME} into ${ANALYZED_BRIO_OUTPUT_PATH}/${INPUT_FILENAME}_calo_tracker.brio FAILED !"
-	exit 0
-    fi
-
-    mv ${ANALYZED_OUTPUT_PATH}/${OUTPUT_ROOT_FILE} ${ANALYZED_ROOT_OUTPUT_PATH}/${INPUT_FILENAME}_analyzed.root
-    if [ $? -eq 1 ];
-    then
-	echo "ERROR : mv ${ANALYZED_OUTPUT_PATH}/${OUTPUT_ROOT_FILE} into ${ANALYZED_ROOT_OUTPUT_PATH}/${INPUT_FILENAME}_analyzed.root FAILED !"
-	exit 0
-    fi
+    collect_analyzed_files ${INPUT_FILENAME} ${ANALYZED_OUTPUT_PATH}/
 
     echo "FILE_ANALYZING:SUCCESS" >> ${LOG_FILE}
     let file_counter++
 
     echo "Ending process..."
 done
+
+if [ "x${spool_dir}" != "xUNDEFINED" -a "x${number_of_processes}" = "xUNDEFINED" ];
+then
+    # Wait for the jobs served from the spool, then collect their outputs like the serial loop :
+    for file in ${INPUT_FILES}
+    do
+	INPUT_FILENAME=`basename ${file} .brio`
+	INPUT_FILENAME=`basename ${INPUT_FILENAME} _sorted`
+	JOB_FILE=${spool_dir}/${INPUT_FILENAME}_analyzed
+	while [ ! -f ${JOB_FILE}.done -a ! -f ${JOB_FILE}.failed ];
+	do
+	    sleep 10
+	done
+	if [ -f ${JOB_FILE}.failed ];
+	then
+	    echo "ERROR : job ${JOB_FILE} FAILED, see ${JOB_FILE}.log !"
+	    exit 0
+	fi
+	echo "Job ${JOB_FILE} done"
+	collect_analyzed_files ${INPUT_FILENAME} ${STAGING_OUTPUT_PATH}/`basename ${file} .brio`_
+    done
+fi
+
+if [ ${file_counter} -gt 0 ];
+then
+    # Histograms and processing statistics of all files in one ROOT file :
+    MERGED_ROOT_FILE=${ANALYZED_OUTPUT_PATH}/run_${run_number}_analyzed.root
+    ${SW_PATH}/hc_merge_outputs -i ${ANALYZED_ROOT_OUTPUT_PATH}/*_analyzed.root -o ${MERGED_ROOT_FILE} > ${LOG_DIR}/run_${run_number}_merged.log 2>&1
+    if [ $? -eq 1 ];
+    then
+	echo "ERROR : merge of ${ANALYZED_ROOT_OUTPUT_PATH}/*_analyzed.root into ${MERGED_ROOT_FILE} FAILED !"
+	exit 0
+    fi
+fi
@@ -0,0 +1,199 @@
+#!/usr/bin/env bash
+# hc_regression_check.sh
+
+echo "Starting..." >&2
+
+SW_PATH="/home/goliviero/software/Falaise/Analysis/sn_hc_simu_analysis/build/BuildProducts/bin"
+SOURCE_DIR=$(cd $(dirname $0)/.. && pwd)
+MAPPING_DIR=${SOURCE_DIR}/resources/commissioning_mapping_example
+
+function usage(){
+echo "--------------"
+echo "Goal : Check hc_sort_data and hc_analysis_data outputs against golden references"
+echo "--------------"
+echo "How to use it"
+echo " "
+echo "$ ./hc_regression_check.sh [OPTIONS] [ARGUMENTS]"
+echo ""
+echo "Allowed options: "
+echo "-h  [ --help ]       produce help message"
+echo "-i  [ --input ]      set the fixed simulated input brio file"
+echo "-g  [ --golden ]     set the golden reference directory"
+echo "-w  [ --work ]       set the work directory for the outputs (default : /tmp/hc_regression)"
+echo "-n  [ --number ]     set the number of events (default : 1000)"
+echo "-t  [ --threads ]    set the number of sorting and analysis threads to check (default : 1)"
+echo "-b  [ --bin ]        set the path of the programs (default : ${SW_PATH})"
+echo "-s  [ --slowdown ]   set the allowed throughput and peak RSS degradation in % (default : 20)"
+echo "-u  [ --update ]     record the outputs and the performance as new golden references"
+echo " "
+echo "--------------"
+echo "Example : "
+echo "./hc_regression_check.sh -i hc_simu_1000.brio -g golden.d -u"
+echo "./hc_regression_check.sh -i hc_simu_1000.brio -g golden.d -t 4"
+echo " "
+}
+
+# Value of a field of output_processing_statistics.json :
+function json_value(){
+    grep "\"$2\"" $1 | head -1 | sed -e 's/.*: *//' -e 's/,$//'
+}
+
+#### ->MAIN<- #####
+
+input_file=UNDEFINED
+golden_dir=UNDEFINED
+work_dir=/tmp/hc_regression
+nb_event=1000
+nb_threads=1
+slowdown=20
+update=0
+
+while [ -n "$1" ];
+do
+    arg="$1"
+    arg_value="$2"
+    if [ "x$arg" = "x-h" -o "x$arg" = "x--help" ]; then
+        usage
+        exit 0
+    fi
+    if [ "x$arg" = "x-u" -o "x$arg" = "x--update" ]; then
+	update=1
+	shift 1
+	continue
+    fi
+    if [ "x$arg" = "x-i" -o "x$arg" = "x--input" ]; then
+        input_file=$arg_value
+    fi
+    if [ "x$arg" = "x-g" -o "x$arg" = "x--golden" ]; then
+	golden_dir=$arg_value
+    fi
+    if [ "x$arg" = "x-w" -o "x$arg" = "x--work" ]; then
+	work_dir=$arg_value
+    fi
+    if [ "x$arg" = "x-n" -o "x$arg" = "x--number" ]; then
+	nb_event=$arg_value
+    fi
+    if [ "x$arg" = "x-t" -o "x$arg" = "x--threads" ]; then
+	nb_threads=$arg_value
+    fi
+    if [ "x$arg" = "x-b" -o "x$arg" = "x--bin" ]; then
+	SW_PATH=$arg_value
+    fi
+    if [ "x$arg" = "x-s" -o "x$arg" = "x--slowdown" ]; then
+	slowdown=$arg_value
+    fi
+    shift 2
+done
+
+if [ ! -f ${input_file} -o "x${golden_dir}" = "xUNDEFINED" ];
+then
+    echo "ERROR : missing input file or golden directory !" >&2
+    usage
+    exit 1
+fi
+
+CALO_1_COLUMN=${MAPPING_DIR}/hc_layout_1_column.conf
+CALO_2_COLUMNS=${MAPPING_DIR}/hc_layout_2_columns.conf
+TRACKER_GEIGER=${MAPPING_DIR}/hc_layout_geiger.conf
+
+rm -rf ${work_dir}
+mkdir -p ${work_dir}/sort ${work_dir}/analysis_1_column ${work_dir}/analysis_2_columns
+if [ $? -ne 0 ];
+then
+    echo "ERROR : mkdir ${work_dir} FAILED !" >&2
+    exit 1
+fi
+
+# Sorting with both calo layouts in one pass (wall time in s and peak RSS in kB from time) :
+echo "Sorting..."
+/usr/bin/time -f "%e %M" -o ${work_dir}/sort/time.txt \
+    ${SW_PATH}/hc_sort_data -i ${input_file} -o ${work_dir}/sort/ -n ${nb_event} -t ${nb_threads} \
+    -L hc_1_column:${CALO_1_COLUMN}:${TRACKER_GEIGER} \
+    -L hc_2_columns:${CALO_2_COLUMNS}:${TRACKER_GEIGER} > ${work_dir}/sort/sort.log 2>&1
+if [ $? -ne 0 ];
+then
+    echo "ERROR : hc_sort_data FAILED, see ${work_dir}/sort/sort.log !" >&2
+    exit 1
+fi
+
+# Analysis of each calo layout (events/s and peak RSS in output_processing_statistics.json) :
+for layout in 1_column 2_columns
+do
+    echo "Analyzing with layout ${layout}..."
+    calo_config=${MAPPING_DIR}/hc_layout_${layout}.conf
+    ${SW_PATH}/hc_analysis_data -i ${input_file} -o ${work_dir}/analysis_${layout}/ -n ${nb_event} -t ${nb_threads} \
+	-C ${calo_config} -T ${TRACKER_GEIGER} > ${work_dir}/analysis_${layout}/analysis.log 2>&1
+    if [ $? -ne 0 ];
+    then
+	echo "ERROR : hc_analysis_data FAILED, see ${work_dir}/analysis_${layout}/analysis.log !" >&2
+	exit 1
+    fi
+done
+
+# Outputs compared bin for bin and event for event :
+OUTPUT_FILES="sort/hc_1_column_sorted.brio sort/hc_1_column_sorted_with_geiger.brio
+sort/hc_2_columns_sorted.brio sort/hc_2_columns_sorted_with_geiger.brio
+analysis_1_column/output_rootfile.root analysis_1_column/output_calo_tracker_events.brio
+analysis_2_columns/output_rootfile.root analysis_2_columns/output_calo_tracker_events.brio"
+
+# Performance of each step, one line 'name events_per_second peak_rss_kb' :
+sort_time=`cat ${work_dir}/sort/time.txt | tail -1`
+sort_wall=`echo ${sort_time} | cut -d' ' -f1`
+sort_rss=`echo ${sort_time} | cut -d' ' -f2`
+echo "sort `echo "${nb_event} ${sort_wall}" | awk '{ if ($2 > 0) print $1 / $2; else print 0 }'` ${sort_rss}" > ${work_dir}/performance.txt
+for layout in 1_column 2_columns
+do
+    statistics=${work_dir}/analysis_${layout}/output_processing_statistics.json
+    echo "analysis_${layout} `json_value ${statistics} events_per_second` `json_value ${statistics} peak_rss_kb`" >> ${work_dir}/performance.txt
+done
+
+if [ ${update} -eq 1 ];
+then
+    mkdir -p ${golden_dir}/sort ${golden_dir}/analysis_1_column ${golden_dir}/analysis_2_columns
+    for file in ${OUTPUT_FILES}
+    do
+	cp ${work_dir}/${file} ${golden_dir}/${file}
+    done
+    cp ${work_dir}/performance.txt ${golden_dir}/performance.txt
+    echo "Golden references recorded in ${golden_dir}"
+    exit 0
+fi
+
+status=0
+for file in ${OUTPUT_FILES}
+do
+    ${SW_PATH}/hc_compare_outputs -r ${golden_dir}/${file} -c ${work_dir}/${file} > ${work_dir}/compare.log 2>&1
+    if [ $? -ne 0 ];
+    then
+	echo "FAILED : ${file} differs from the golden reference :"
+	head -20 ${work_dir}/compare.log
+	status=1
+    else
+	echo "OK : ${file}"
+    fi
+done
+
+# Throughput may not drop and peak RSS may not grow by more than the allowed slowdown :
+while read name rate rss
+do
+    baseline=`grep "^${name} " ${golden_dir}/performance.txt`
+    baseline_rate=`echo ${baseline} | cut -d' ' -f2`
+    baseline_rss=`echo ${baseline} | cut -d' ' -f3`
+    echo "${name} : ${rate} events/s (baseline ${baseline_rate}), peak RSS ${rss} kB (baseline ${baseline_rss})"
+    check=`echo "${rate} ${rss} ${baseline_rate} ${baseline_rss} ${slowdown}" | awk '{ print ($1 >= $3 * (1 - $5 / 100.) && $2 <= $4 * (1 + $5 / 100.)) ? "OK" : "FAILED" }'`
+    if [ "x${check}" != "xOK" ];
+    then
+	echo "FAILED : ${name} performance below the baseline"
+	status=1
+    fi
+done < ${work_dir}/performance.txt
+
+if [ ${status} -eq 0 ];
+then
+    echo "REGRESSION_CHECK:SUCCESS"
+else
+    echo "REGRESSION_CHECK:FAILED"
+fi
+
+echo "Ending..."
+exit ${status}
@@ -21,6 +21,8 @@ echo "Allowed options: "
 echo "-h  [ --help ]     produce help message"
 echo "-n  [ --number ]   set the number of events"
 echo "-r  [--run-number] set the run number to analyze"
+echo "-q  [--spool]      queue one job per file in the spool directory of a running 'hc_sort_data --spool', wait for the jobs and collect their outputs"
+echo "-j  [--processes] run the files with this number of local worker processes (hc_run_data) instead of one after the other"
 echo " "
 echo "./hc_sort_data.sh -n number_of_events"
 echo "Default value : number_of_events = 10"
@@ -36,6 +38,8 @@ echo " "
 START_DATE=`date "+%Y-%m-%d"`
 nb_event=10
 run_number=UNDEFINED
+spool_dir=UNDEFINED
+number_of_processes=UNDEFINED
 
 while [ -n "$1" ];
 do
@@ -51,6 +55,12 @@ do
     if [ "x$arg" = "x-r" ]; then
 	run_number=$arg_value
     fi
+    if [ "x$arg" = "x-q" -o "x$arg" = "x--spool" ]; then
+	spool_dir=$arg_value
+    fi
+    if [ "x$arg" = "x-j" -o "x$arg" = "x--processes" ]; then
+	number_of_processes=$arg_value
+    fi
     shift 2
 done
 
@@ -75,19 +85,75 @@ fi
 HC_CALO_MAPPING_CONFIG_FILE=${INPUT_RUN_DIR}/hc_mapping/mapping_calo.conf
 HC_TRACKER_MAPPING_CONFIG_FILE=${INPUT_RUN_DIR}/hc_mapping/mapping_tracker.conf
 
+# Move the sorted files of an input file, written with the given path prefix, in the match rules directories
+function collect_sorted_files(){
+    local INPUT_FILENAME=$1
+    local OUTPUT_PREFIX=$2
+    OUTPUT_FILENAME="${OUTPUT_PREFIX}output_sorted.brio"
+    OUTPUT_WITH_GG_FILENAME="${OUTPUT_PREFIX}output_sorted_with_geiger.brio"
+
+    mv ${OUTPUT_FILENAME} ${MATCH_RULES_OUTPUT_PATH}/${INPUT_FILENAME}_sorted.brio
+    if [ $? -eq 1 ];
+    then
+	echo "ERROR : mv ${OUTPUT_FILENAME} into ${MATCH_RULES_OUTPUT_PATH}/${INPUT_FILENAME}_sorted.brio FAILED !"
+	exit 0
+    fi
+
+    mv ${OUTPUT_WITH_GG_FILENAME} ${MATCH_RULES_WITH_GG_OUTPUT_PATH}/${INPUT_FILENAME}_sorted_with_gg.brio
+    if [ $? -eq 1 ];
+    then
+	echo "ERROR : mv ${OUTPUT_WITH_GG_FILENAME} into ${MATCH_RULES_WITH_GG_OUTPUT_PATH}/${INPUT_FILENAME}_sorted_with_gg.brio FAILED !"
+	exit 0
+    fi
+}
+
 file_counter=0
 
+# Outputs of the worker processes or of the spool jobs, prefixed by the input file names,
+# the sorted files are moved by the collect function and the other outputs of each file stay there :
+STAGING_OUTPUT_PATH=${SORTED_OUTPUT_PATH}/staging
+mkdir -p ${STAGING_OUTPUT_PATH}
+
+if [ "x${number_of_processes}" != "xUNDEFINED" ];
+then
+    # Files scheduled on the local worker processes, outputs prefixed by the input file names in the staging directory :
+    ${SW_PATH}/hc_run_data -p ${SW_PATH}/${SW_NAME} --input-dir ${INPUT_SIMU_DIR} -o ${STAGING_OUTPUT_PATH} -j ${number_of_processes} --log-dir ${LOG_DIR} --status-label FILE_SORTING -n $nb_event -C ${HC_CALO_MAPPING_CONFIG_FILE} -T ${HC_TRACKER_MAPPING_CONFIG_FILE}
+    if [ $? -eq 1 ];
+    then
+	echo "ERROR : some files of ${INPUT_SIMU_DIR} FAILED, see the logs in ${LOG_DIR} !"
+	exit 0
+    fi
+fi
+
 for file in ${INPUT_FILES}
 do
     INPUT_FILENAME=`basename $file .brio` # .brio after $file remove extension of the input file
-    OUTPUT_FILENAME="output_sorted.brio"
-    OUTPUT_WITH_GG_FILENAME="output_sorted_with_geiger.brio"
 
     LOG_FILE=${LOG_DIR}/${INPUT_FILENAME}_sorted.log
 
+    if [ "x${number_of_processes}" != "xUNDEFINED" ];
+    then
+	# Already processed by the local worker processes :
+	collect_sorted_files ${INPUT_FILENAME} ${STAGING_OUTPUT_PATH}/${INPUT_FILENAME}_
+	let file_counter++
+	continue
+    fi
+
     echo "Mapping calo :" ${HC_CALO_MAPPING_CONFIG_FILE}
     echo "Mapping tracker :" ${HC_TRACKER_MAPPING_CONFIG_FILE}
 
+    if [ "x${spool_dir}" != "xUNDEFINED" ];
+    then
+	# Outputs written in the staging directory by the program serving the spool, collected below :
+	JOB_FILE=${spool_dir}/${INPUT_FILENAME}_sorted
+	rm -f ${JOB_FILE}.done ${JOB_FILE}.failed
+	echo "-i ${file} -o ${STAGING_OUTPUT_PATH}/${INPUT_FILENAME}_ -n $nb_event -C ${HC_CALO_MAPPING_CONFIG_FILE} -T ${HC_TRACKER_MAPPING_CONFIG_FILE}" > ${JOB_FILE}.tmp
+	mv ${JOB_FILE}.tmp ${JOB_FILE}.job # the job is visible only once complete
+	echo "Job queued in ${JOB_FILE}.job"
+	let file_counter++
+	continue
+    fi
+
     echo "Starting process..."
     echo "Processing..."
 
@@ -99,22 +165,31 @@ do
 	exit 0
     fi
 
-    mv ${SORTED_OUTPUT_PATH}/${OUTPUT_FILENAME} ${MATCH_RULES_OUTPUT_PATH}/${INPUT_FILENAME}_sorted.brio
-    if [ $? -eq 1 ];
-    then
-	echo "ERROR : mv ${SORTED_OUTPUT_PATH}/${OUTPUT_FILENAME} into ${SORTED_OUTPUT_PATH}/${INPUT_FILENAME}_sorted.brio FAILED !"
-	exit 0
-    fi
-
-    mv ${SORTED_OUTPUT_PATH}/${OUTPUT_WITH_GG_FILENAME} ${MATCH_RULES_WITH_GG_OUTPUT_PATH}/${INPUT_FILENAME}_sorted_with_gg.brio
-    if [ $? -eq 1 ];
-    then
-	echo "ERROR : mv ${SORTED_OUTPUT_PATH}/${OUTPUT_WITH_GG_FILENAME} into ${SORTED_OUTPUT_PATH}/${INPUT_FILENAME}_sorted_with_gg.brio FAILED !"
-	exit 0
-    fi
+    collect_sorted_files ${INPUT_FILENAME} ${SORTED_OUTPUT_PATH}/
 
     echo "FILE_SORTING:SUCCESS" >> ${LOG_FILE}
     let file_counter++
 
     echo "Ending process..."
 done
+
+if [ "x${spool_dir}" != "xUNDEFINED" -a "x${number_of_processes}" = "xUNDEFINED" ];
+then
+    # Wait for the jobs served from the spool, then collect their outputs like the serial loop :
+    for file in ${INPUT_FILES}
+    do
+	INPUT_FILENAME=`basename ${file} .brio`
+	JOB_FILE=${spool_dir}/${INPUT_FILENAME}_sorted
+	while [ ! -f ${JOB_FILE}.done -a ! -f ${JOB_FILE}.failed ];
+	do
+	    sleep 10
+	done
+	if [ -f ${JOB_FILE}.failed ];
+	then
+	    echo "ERROR : job ${JOB_FILE} FAILED, see ${JOB_FILE}.log !"
+	    exit 0
+	fi
+	echo "Job ${JOB_FILE} done"
+	collect_sorted_files ${INPUT_FILENAME} ${STAGING_OUTPUT_PATH}/${INPUT_FILENAME}_
+    done
+fi
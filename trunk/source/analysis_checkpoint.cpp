@@ -0,0 +1,71 @@
+//! \file analysis_checkpoint.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <memory>
+#include <string>
+
+// Root :
+#include "TParameter.h"
+
+// Ourselves:
+#include <analysis_checkpoint.hpp>
+
+namespace {
+
+  const std::string CHECKPOINT_DIRECTORY = "checkpoint";
+
+  /// Write a value as a ROOT parameter in the current directory
+  void write_value(const std::string & name_, uint64_t value_)
+  {
+    TParameter<Long64_t> parameter(name_.c_str(), static_cast<Long64_t>(value_));
+    parameter.Write("", TObject::kOverwrite);
+    return;
+  }
+
+  /// Read a value written by write_value, false if missing
+  bool read_value(TDirectory * directory_, const std::string & name_, uint64_t & value_)
+  {
+    std::unique_ptr<TObject> object(directory_->Get(name_.c_str()));
+    const TParameter<Long64_t> * parameter = dynamic_cast<const TParameter<Long64_t> *>(object.get());
+    if (parameter == nullptr) return false;
+    value_ = static_cast<uint64_t>(parameter->GetVal());
+    return true;
+  }
+
+}
+
+void analysis_checkpoint::save(TDirectory * directory_) const
+{
+  TDirectory * checkpoint_directory = directory_->GetDirectory(CHECKPOINT_DIRECTORY.c_str());
+  if (checkpoint_directory == nullptr) checkpoint_directory = directory_->mkdir(CHECKPOINT_DIRECTORY.c_str(),
+										 "Position of the next record to analyze");
+  checkpoint_directory->cd();
+  write_value("file_index", file_index);
+  write_value("record_number", record_number);
+  write_value("number_of_events", number_of_events);
+  write_value("segment", segment);
+  write_value("complete", complete ? 1 : 0);
+  directory_->cd();
+  return;
+}
+
+bool analysis_checkpoint::load(TDirectory * directory_)
+{
+  TDirectory * checkpoint_directory = directory_->GetDirectory(CHECKPOINT_DIRECTORY.c_str());
+  if (checkpoint_directory == nullptr) return false;
+  uint64_t file_index_value = 0;
+  uint64_t segment_value = 0;
+  uint64_t complete_value = 0;
+  if (!read_value(checkpoint_directory, "file_index", file_index_value)
+      || !read_value(checkpoint_directory, "record_number", record_number)
+      || !read_value(checkpoint_directory, "number_of_events", number_of_events)
+      || !read_value(checkpoint_directory, "segment", segment_value)
+      || !read_value(checkpoint_directory, "complete", complete_value)) return false;
+  file_index = static_cast<uint32_t>(file_index_value);
+  segment = static_cast<uint32_t>(segment_value);
+  complete = complete_value != 0;
+  return true;
+}
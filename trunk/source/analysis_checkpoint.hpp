@@ -0,0 +1,44 @@
+//! \file analysis_checkpoint.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Input position of an analysis, saved with its histograms so an
+// interrupted job can be resumed
+//
+
+#ifndef ANALYSIS_CHECKPOINT_HPP
+#define ANALYSIS_CHECKPOINT_HPP
+
+// Standard library:
+#include <cstdint>
+
+// Root :
+#include "TDirectory.h"
+
+//! \brief Position of the next record to analyze in the input files
+//
+// Saved as ROOT parameters in the 'checkpoint' sub-directory of the
+// output ROOT file, next to the histograms of the events committed
+// before the position.
+struct analysis_checkpoint
+{
+  /// Save in the 'checkpoint' sub-directory of a directory
+  void save(TDirectory * directory_) const;
+
+  /// Load from the 'checkpoint' sub-directory of a directory, return false if there is none
+  bool load(TDirectory * directory_);
+
+  uint32_t file_index = 0;       ///< File of the next record
+  uint64_t record_number = 0;    ///< Record number of the next record in its file
+  uint64_t number_of_events = 0; ///< Events committed before the position
+  uint32_t segment = 0;          ///< Segment of the event output files of the events after the position
+  bool complete = false;         ///< All the input records were analyzed
+};
+
+#endif // ANALYSIS_CHECKPOINT_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
@@ -0,0 +1,137 @@
+//! \file async_event_writer.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+
+// Ourselves:
+#include <async_event_writer.hpp>
+
+async_event_writer::async_event_writer(std::size_t capacity_)
+  : _capacity_(capacity_),
+    _pending_records_(capacity_),
+    _free_records_(capacity_)
+{
+}
+
+async_event_writer::~async_event_writer()
+{
+  // Errors are only reported by an explicit terminate() :
+  try {
+    terminate();
+  }
+  catch (...) {
+  }
+}
+
+std::size_t async_event_writer::add_output(dpp::output_module & output_)
+{
+  DT_THROW_IF(_started_, std::logic_error, "Outputs can not be added to a started writer !");
+  DT_THROW_IF(_outputs_.size() >= 64, std::logic_error, "Too many outputs for the output masks !");
+  _outputs_.push_back(&output_);
+  return _outputs_.size() - 1;
+}
+
+void async_event_writer::start()
+{
+  DT_THROW_IF(_started_ || _pending_records_.is_closed(), std::logic_error, "Writer is already started !");
+  _started_ = true;
+  if (!is_asynchronous()) return;
+
+  for (std::size_t irecord = 0; irecord < _capacity_; irecord++) {
+    _free_records_.push(std::unique_ptr<datatools::things>(new datatools::things));
+  }
+
+  _thread_ = std::thread([this] {
+      try {
+	_pending_record_ a_pending;
+	while (_pending_records_.pop(a_pending)) {
+	  _write_(*a_pending.record, a_pending.output_mask);
+	  a_pending.record->clear();
+	  if (!_free_records_.push(std::move(a_pending.record))) break;
+	}
+      }
+      catch (...) {
+	std::lock_guard<std::mutex> lock(_error_mutex_);
+	_error_ = std::current_exception();
+      }
+      // Wake up a producer waiting for a free record :
+      _pending_records_.close();
+      _free_records_.close();
+    });
+  return;
+}
+
+bool async_event_writer::is_started() const
+{
+  return _started_;
+}
+
+bool async_event_writer::is_asynchronous() const
+{
+  return _capacity_ > 0;
+}
+
+void async_event_writer::write(std::unique_ptr<datatools::things> & record_, uint64_t output_mask_)
+{
+  DT_THROW_IF(!_started_, std::logic_error, "Writer is not started !");
+  if (output_mask_ == 0) return;
+  if (!is_asynchronous()) {
+    _write_(*record_, output_mask_);
+    return;
+  }
+
+  // Waits while all the records of the pool are in flight :
+  std::unique_ptr<datatools::things> free_record;
+  if (!_free_records_.pop(free_record)) _check_error_();
+  _pending_record_ a_pending;
+  a_pending.record = std::move(record_);
+  a_pending.output_mask = output_mask_;
+  record_ = std::move(free_record);
+  if (!_pending_records_.push(std::move(a_pending))) _check_error_();
+  return;
+}
+
+void async_event_writer::terminate()
+{
+  if (!_started_) return;
+  _started_ = false;
+  if (_thread_.joinable()) {
+    _pending_records_.close();
+    _thread_.join();
+  }
+  _check_error_();
+  return;
+}
+
+const processing_statistics & async_event_writer::get_statistics() const
+{
+  return _statistics_;
+}
+
+void async_event_writer::_write_(datatools::things & record_, uint64_t output_mask_)
+{
+  processing_statistics::scoped_timer timer(&_statistics_, processing_statistics::STAGE_BRIO_WRITE);
+  for (std::size_t ioutput = 0; ioutput < _outputs_.size(); ioutput++) {
+    if (output_mask_ & (uint64_t(1) << ioutput)) _outputs_[ioutput]->process(record_);
+  }
+  return;
+}
+
+void async_event_writer::_check_error_()
+{
+  std::lock_guard<std::mutex> lock(_error_mutex_);
+  if (_error_) {
+    std::exception_ptr error = _error_;
+    _error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+  DT_THROW_IF(_started_, std::logic_error, "Writer thread is stopped !");
+  return;
+}
@@ -0,0 +1,106 @@
+//! \file async_event_writer.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Brio output modules fed by a background thread, so serialization,
+// compression and disk latency overlap with reading and analysis
+//
+
+#ifndef ASYNC_EVENT_WRITER_HPP
+#define ASYNC_EVENT_WRITER_HPP
+
+// Standard library:
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/things.h>
+// - Bayeux/dpp:
+#include <dpp/output_module.h>
+
+// This project :
+#include "bounded_queue.hpp"
+#include "processing_statistics.hpp"
+
+//! \brief Ordered background writer of event records
+//
+// A record given to write() is moved in a FIFO queue, and the caller
+// gets an empty record from a fixed pool in exchange, so records are
+// never copied. A single thread processes the queue in order, each
+// record in the output modules of its mask. When all the records of
+// the pool are in flight, write() waits for the writer thread
+// (backpressure), so the memory is bounded by the queue capacity.
+//
+// With a capacity of 0, the records are written synchronously by
+// write(), without thread. The output modules must live until
+// terminate() returns.
+class async_event_writer
+{
+public :
+
+  /// Constructor with the number of records in flight
+  explicit async_event_writer(std::size_t capacity_ = 64);
+
+  /// Destructor : write the remaining records
+  ~async_event_writer();
+
+  /// Add an output module, return its bit in the output masks
+  std::size_t add_output(dpp::output_module & output_);
+
+  /// Start the writer thread, a writer is started only once
+  void start();
+
+  /// Check if the writer is started
+  bool is_started() const;
+
+  /// Check if the records are written in a background thread
+  bool is_asynchronous() const;
+
+  /// Write a record in the outputs of a mask, the record is exchanged for an empty one
+  void write(std::unique_ptr<datatools::things> & record_, uint64_t output_mask_);
+
+  /// Write the remaining records and stop the writer thread, rethrow its error if any
+  void terminate();
+
+  /// Return the write time and the number of written records
+  const processing_statistics & get_statistics() const;
+
+private :
+
+  /// Record waiting to be written
+  struct _pending_record_
+  {
+    std::unique_ptr<datatools::things> record;
+    uint64_t output_mask = 0;
+  };
+
+  /// Write a record in the outputs of its mask
+  void _write_(datatools::things & record_, uint64_t output_mask_);
+
+  /// Rethrow the error of the writer thread
+  void _check_error_();
+
+  const std::size_t _capacity_;
+  std::vector<dpp::output_module *> _outputs_;
+  bounded_queue<_pending_record_> _pending_records_;
+  bounded_queue<std::unique_ptr<datatools::things> > _free_records_;
+  std::thread _thread_;
+  bool _started_ = false;
+  std::exception_ptr _error_;
+  std::mutex _error_mutex_;
+  processing_statistics _statistics_; ///< Used by the writer thread only, until terminate()
+
+};
+
+#endif // ASYNC_EVENT_WRITER_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
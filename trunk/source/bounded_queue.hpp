@@ -0,0 +1,96 @@
+//! \file bounded_queue.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Blocking FIFO queue with a fixed capacity, shared between threads
+//
+
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+// Standard library:
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+//! \brief Blocking queue : push waits while full, pop waits while empty
+//
+// Once closed, push is refused and pop drains the remaining items
+// before returning false.
+template <class T>
+class bounded_queue
+{
+public :
+
+  /// Constructor
+  explicit bounded_queue(std::size_t capacity_)
+    : _capacity_(capacity_ == 0 ? 1 : capacity_)
+  {
+  }
+
+  /// Push an item, return false if the queue is closed
+  bool push(T item_)
+  {
+    std::unique_lock<std::mutex> lock(_mutex_);
+    _not_full_.wait(lock, [this] { return _closed_ || _items_.size() < _capacity_; });
+    if (_closed_) return false;
+    _items_.push_back(std::move(item_));
+    _not_empty_.notify_one();
+    return true;
+  }
+
+  /// Pop an item, return false if the queue is closed and empty
+  bool pop(T & item_)
+  {
+    std::unique_lock<std::mutex> lock(_mutex_);
+    _not_empty_.wait(lock, [this] { return _closed_ || !_items_.empty(); });
+    if (_items_.empty()) return false;
+    item_ = std::move(_items_.front());
+    _items_.pop_front();
+    _not_full_.notify_one();
+    return true;
+  }
+
+  /// Close the queue and wake up all waiting threads
+  void close()
+  {
+    std::lock_guard<std::mutex> lock(_mutex_);
+    _closed_ = true;
+    _not_full_.notify_all();
+    _not_empty_.notify_all();
+    return;
+  }
+
+  /// Check if the queue is closed
+  bool is_closed() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex_);
+    return _closed_;
+  }
+
+  /// Return the capacity
+  std::size_t get_capacity() const
+  {
+    return _capacity_;
+  }
+
+private :
+
+  const std::size_t _capacity_;
+  bool _closed_ = false;
+  std::deque<T> _items_;
+  mutable std::mutex _mutex_;
+  std::condition_variable _not_full_;
+  std::condition_variable _not_empty_;
+
+};
+
+#endif // BOUNDED_QUEUE_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
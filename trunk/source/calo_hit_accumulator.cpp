@@ -0,0 +1,105 @@
+//! \file calo_hit_accumulator.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <algorithm>
+
+// Ourselves:
+#include <calo_hit_accumulator.hpp>
+
+calo_hit_accumulator::calo_hit_accumulator()
+  : _oms_(NUMBER_OF_OMS),
+    _fired_(NUMBER_OF_OMS, false)
+{
+  _touched_oms_.reserve(NUMBER_OF_OMS);
+}
+
+std::size_t calo_hit_accumulator::om_index(const geomtools::geom_id & calo_gid_)
+{
+  const uint32_t side   = calo_gid_.get(1);
+  const uint32_t column = calo_gid_.get(2);
+  const uint32_t row    = calo_gid_.get(3);
+  if (side >= hc_constants::NUMBER_OF_SIDES
+      || column >= hc_constants::NUMBER_OF_CALO_COLUMNS
+      || row >= hc_constants::NUMBER_OF_CALO_PER_COLUMN) return INVALID_OM;
+  return (side * hc_constants::NUMBER_OF_CALO_COLUMNS + column) * hc_constants::NUMBER_OF_CALO_PER_COLUMN + row;
+}
+
+void calo_hit_accumulator::om_address(std::size_t om_, uint32_t & side_, uint32_t & column_, uint32_t & row_)
+{
+  row_ = om_ % hc_constants::NUMBER_OF_CALO_PER_COLUMN;
+  column_ = (om_ / hc_constants::NUMBER_OF_CALO_PER_COLUMN) % hc_constants::NUMBER_OF_CALO_COLUMNS;
+  side_ = om_ / (hc_constants::NUMBER_OF_CALO_PER_COLUMN * hc_constants::NUMBER_OF_CALO_COLUMNS);
+  return;
+}
+
+void calo_hit_accumulator::reset()
+{
+  for (std::size_t i = 0; i < _touched_oms_.size(); i++) {
+    _fired_[_touched_oms_[i]] = false;
+  }
+  _touched_oms_.clear();
+  return;
+}
+
+void calo_hit_accumulator::add(const mctools::base_step_hit & BSH_)
+{
+  const std::size_t om = om_index(BSH_.get_geom_id());
+  if (om == INVALID_OM) return;
+
+  calo_hit_summary & calo_hit = _oms_[om];
+  if (!_fired_[om])
+    {
+      // First step hit in this OM :
+      _fired_[om] = true;
+      _touched_oms_.push_back(om);
+      calo_hit.geom_id = BSH_.get_geom_id();
+      calo_hit.energy = BSH_.get_energy_deposit();
+      calo_hit.time = BSH_.get_time_start();
+      calo_hit.left_most_hit_position = BSH_.get_position_start();
+      calo_hit.geiger_association = false;
+    }
+  else
+    {
+      // Update the existing calo hit (add energy and check the time to be the t_start min)
+      calo_hit.energy += BSH_.get_energy_deposit();
+      if (BSH_.get_time_start() < calo_hit.time) calo_hit.time = BSH_.get_time_start();
+      if (BSH_.get_position_start().getX() < calo_hit.left_most_hit_position.getX())
+	{
+	  calo_hit.left_most_hit_position = BSH_.get_position_start();
+	}
+    }
+  return;
+}
+
+void calo_hit_accumulator::extract(const compiled_id_selector & selector_,
+				   double calo_threshold_kev_,
+				   std::vector<calo_hit_summary> & calo_hits_)
+{
+  // Same order as a map sorted by geom ID :
+  std::sort(_touched_oms_.begin(), _touched_oms_.end());
+  for (std::size_t i = 0; i < _touched_oms_.size(); i++) {
+    const calo_hit_summary & calo_hit = _oms_[_touched_oms_[i]];
+    if (calo_hit.energy * 1000 < calo_threshold_kev_) continue;
+    if (!selector_.match(calo_hit.geom_id)) continue;
+    calo_hits_.push_back(calo_hit);
+  }
+  return;
+}
+
+std::size_t calo_hit_accumulator::get_number_of_touched() const
+{
+  return _touched_oms_.size();
+}
+
+const std::vector<std::size_t> & calo_hit_accumulator::get_touched_oms() const
+{
+  return _touched_oms_;
+}
+
+const calo_hit_summary & calo_hit_accumulator::get_om(std::size_t om_) const
+{
+  return _oms_[om_];
+}
@@ -0,0 +1,94 @@
+//! \file calo_hit_accumulator.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Dense side x column x row accumulator merging the calo step hits
+// of an event by optical module (OM)
+//
+
+#ifndef CALO_HIT_ACCUMULATOR_HPP
+#define CALO_HIT_ACCUMULATOR_HPP
+
+// Standard library:
+#include <cstddef>
+#include <vector>
+
+// Third party:
+// - Bayeux/geomtools:
+#include <bayeux/geomtools/geom_id.h>
+#include <bayeux/geomtools/clhep.h>
+// - Bayeux/mctools:
+#include <mctools/base_step_hit.h>
+
+// This project :
+#include "compiled_id_selector.hpp"
+#include "hc_constants.hpp"
+
+/// Calorimeter hit merged from all the step hits of the same OM
+struct calo_hit_summary
+{
+  geomtools::geom_id geom_id;
+  double energy = 0;
+  double time = 0;
+  geomtools::vector_3d left_most_hit_position; // The left most position
+  bool geiger_association = false;
+};
+
+//! \brief Calo hits of an event merged by OM
+//
+// Only the OMs touched since the last reset are cleared, the accumulator
+// is meant to be reused from one event to the other without allocation.
+struct calo_hit_accumulator
+{
+  /// Number of OMs in the table
+  static const std::size_t NUMBER_OF_OMS = hc_constants::NUMBER_OF_SIDES
+    * hc_constants::NUMBER_OF_CALO_COLUMNS
+    * hc_constants::NUMBER_OF_CALO_PER_COLUMN;
+
+  /// Index returned for a geom ID outside of the table
+  static const std::size_t INVALID_OM = static_cast<std::size_t>(-1);
+
+  /// Default constructor
+  calo_hit_accumulator();
+
+  /// Return the OM index of a calorimeter block geom ID (module, side, column, row, part)
+  static std::size_t om_index(const geomtools::geom_id & calo_gid_);
+
+  /// Return the side, column and row of an OM index
+  static void om_address(std::size_t om_, uint32_t & side_, uint32_t & column_, uint32_t & row_);
+
+  /// Reset the OMs touched since the last reset
+  void reset();
+
+  /// Add a calo step hit : sum of energy, minimum start time and left most start position
+  void add(const mctools::base_step_hit & BSH_);
+
+  /// Append the selected OM hits above the threshold, in the OM index order
+  void extract(const compiled_id_selector & selector_,
+	       double calo_threshold_kev_,
+	       std::vector<calo_hit_summary> & calo_hits_);
+
+  /// Return the number of OMs touched since the last reset
+  std::size_t get_number_of_touched() const;
+
+  /// Return the OMs touched since the last reset (in the OM order after an extraction)
+  const std::vector<std::size_t> & get_touched_oms() const;
+
+  /// Return the hit of a touched OM, before threshold and selector
+  const calo_hit_summary & get_om(std::size_t om_) const;
+
+private :
+
+  std::vector<calo_hit_summary> _oms_;
+  std::vector<bool> _fired_;
+  std::vector<std::size_t> _touched_oms_;
+
+};
+
+#endif // CALO_HIT_ACCUMULATOR_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
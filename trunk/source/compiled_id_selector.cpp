@@ -0,0 +1,206 @@
+//! \file compiled_id_selector.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <fstream>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+#include <datatools/properties.h>
+
+// Ourselves:
+#include <compiled_id_selector.hpp>
+
+const std::string & compiled_id_selector::calo_category()
+{
+  static const std::string _category("calorimeter_block");
+  return _category;
+}
+
+const std::string & compiled_id_selector::geiger_category()
+{
+  static const std::string _category("drift_cell_core");
+  return _category;
+}
+
+compiled_id_selector::compiled_id_selector()
+{
+  reset();
+}
+
+bool compiled_id_selector::is_initialized() const
+{
+  return _initialized_;
+}
+
+void compiled_id_selector::initialize(const geomtools::id_selector & selector_,
+				      const geomtools::id_mgr & id_mgr_,
+				      const std::string & category_)
+{
+  DT_THROW_IF(!selector_.is_initialized(), std::logic_error, "ID selector is not initialized !");
+  reset();
+
+  if (category_ == calo_category()) {
+    _number_of_columns_or_layers_ = hc_constants::NUMBER_OF_CALO_COLUMNS;
+    _number_of_rows_ = hc_constants::NUMBER_OF_CALO_PER_COLUMN;
+  }
+  else if (category_ == geiger_category()) {
+    _number_of_columns_or_layers_ = hc_constants::NUMBER_OF_GEIGER_LAYERS;
+    _number_of_rows_ = hc_constants::NUMBER_OF_GEIGER_ROWS;
+  }
+  else DT_THROW(std::logic_error, "Category '" << category_ << "' cannot be compiled !");
+
+  // Probe every cell of the category once with the generic selector :
+  geomtools::geom_id gid;
+  id_mgr_.make_id(category_, gid);
+  for (uint32_t i = 4; i < gid.get_depth(); i++) gid.set(i, 0);
+  _category_ = category_;
+  _type_ = gid.get_type();
+  _bitmap_.assign(hc_constants::NUMBER_OF_MODULES * hc_constants::NUMBER_OF_SIDES
+		  * _number_of_columns_or_layers_ * _number_of_rows_, false);
+
+  std::size_t index = 0;
+  for (uint32_t module = 0; module < hc_constants::NUMBER_OF_MODULES; module++) {
+    gid.set(0, module);
+    for (uint32_t side = 0; side < hc_constants::NUMBER_OF_SIDES; side++) {
+      gid.set(1, side);
+      for (uint32_t icol = 0; icol < _number_of_columns_or_layers_; icol++) {
+	gid.set(2, icol);
+	for (uint32_t irow = 0; irow < _number_of_rows_; irow++) {
+	  gid.set(3, irow);
+	  _bitmap_[index++] = selector_.match(gid);
+	}
+      }
+    }
+  }
+
+  _initialized_ = true;
+  return;
+}
+
+void compiled_id_selector::initialize(const std::string & mapping_config_,
+				      const geomtools::id_mgr & id_mgr_,
+				      const std::string & category_)
+{
+  reset();
+  if (mapping_config_.empty()) return;
+
+  std::ifstream ifile(mapping_config_);
+  DT_THROW_IF(!ifile, std::logic_error, "Cannot open mapping configuration file '" << mapping_config_ << "' !");
+  if (ifile.peek() == std::ifstream::traits_type::eof()) return;
+
+  datatools::properties mapping_config;
+  mapping_config.read_configuration(mapping_config_);
+  geomtools::id_selector selector(id_mgr_);
+  selector.initialize(mapping_config);
+  initialize(selector, id_mgr_, category_);
+  return;
+}
+
+void compiled_id_selector::reset()
+{
+  _initialized_ = false;
+  _category_.clear();
+  _type_ = geomtools::geom_id::INVALID_TYPE;
+  _number_of_columns_or_layers_ = 0;
+  _number_of_rows_ = 0;
+  _bitmap_.clear();
+  return;
+}
+
+bool compiled_id_selector::match(const geomtools::geom_id & gid_) const
+{
+  if (gid_.get_type() != _type_) return false;
+  return match(gid_.get(0), gid_.get(1), gid_.get(2), gid_.get(3));
+}
+
+bool compiled_id_selector::match(uint32_t module_, uint32_t side_, uint32_t column_or_layer_, uint32_t row_) const
+{
+  if (!_initialized_
+      || module_ >= hc_constants::NUMBER_OF_MODULES
+      || side_ >= hc_constants::NUMBER_OF_SIDES
+      || column_or_layer_ >= _number_of_columns_or_layers_
+      || row_ >= _number_of_rows_) return false;
+  return _bitmap_[((module_ * hc_constants::NUMBER_OF_SIDES + side_) * _number_of_columns_or_layers_ + column_or_layer_) * _number_of_rows_ + row_];
+}
+
+const std::string & compiled_id_selector::get_category() const
+{
+  return _category_;
+}
+
+uint32_t compiled_id_selector::get_type() const
+{
+  return _type_;
+}
+
+std::size_t compiled_id_selector::get_number_of_selected() const
+{
+  std::size_t number_of_selected = 0;
+  for (std::size_t i = 0; i < _bitmap_.size(); i++) if (_bitmap_[i]) number_of_selected++;
+  return number_of_selected;
+}
+
+void compiled_id_selector::dump(std::ostream & out_, const std::string & title_) const
+{
+  if (!title_.empty()) out_ << title_ << std::endl;
+  out_ << "|-- Initialized : " << (_initialized_ ? "yes" : "no") << std::endl;
+  if (!_initialized_) return;
+  out_ << "|-- Category    : '" << _category_ << "' (type " << _type_ << ")" << std::endl;
+  out_ << "`-- Selected    : " << get_number_of_selected() << " / " << _bitmap_.size() << std::endl;
+  std::size_t index = 0;
+  for (uint32_t module = 0; module < hc_constants::NUMBER_OF_MODULES; module++) {
+    for (uint32_t side = 0; side < hc_constants::NUMBER_OF_SIDES; side++) {
+      for (uint32_t icol = 0; icol < _number_of_columns_or_layers_; icol++) {
+	for (uint32_t irow = 0; irow < _number_of_rows_; irow++) {
+	  if (_bitmap_[index++]) out_ << "    [" << module << ':' << side << '.' << icol << '.' << irow << ']' << std::endl;
+	}
+      }
+    }
+  }
+  return;
+}
+
+void compiled_id_selector::store(std::ostream & out_) const
+{
+  DT_THROW_IF(!_initialized_, std::logic_error, "Selector is not initialized !");
+  out_ << _category_ << ' ' << _type_ << ' ' << _number_of_columns_or_layers_ << ' ' << _number_of_rows_ << ' ';
+  for (std::size_t i = 0; i < _bitmap_.size(); i++) out_ << (_bitmap_[i] ? '1' : '0');
+  out_ << std::endl;
+  return;
+}
+
+void compiled_id_selector::load(std::istream & in_)
+{
+  reset();
+  std::string category;
+  uint32_t type = geomtools::geom_id::INVALID_TYPE;
+  uint32_t number_of_columns_or_layers = 0;
+  uint32_t number_of_rows = 0;
+  std::string bits;
+  in_ >> category >> type >> number_of_columns_or_layers >> number_of_rows >> bits;
+  DT_THROW_IF(!in_, std::logic_error, "Cannot read a compiled selector !");
+  const bool known_category =
+    (category == calo_category()
+     && number_of_columns_or_layers == hc_constants::NUMBER_OF_CALO_COLUMNS
+     && number_of_rows == hc_constants::NUMBER_OF_CALO_PER_COLUMN)
+    || (category == geiger_category()
+	&& number_of_columns_or_layers == hc_constants::NUMBER_OF_GEIGER_LAYERS
+	&& number_of_rows == hc_constants::NUMBER_OF_GEIGER_ROWS);
+  DT_THROW_IF(!known_category, std::logic_error, "Compiled selector of category '" << category << "' does not match the demonstrator cells !");
+  DT_THROW_IF(bits.size() != std::size_t(hc_constants::NUMBER_OF_MODULES) * hc_constants::NUMBER_OF_SIDES * number_of_columns_or_layers * number_of_rows
+	      || bits.find_first_not_of("01") != std::string::npos,
+	      std::logic_error, "Invalid bitmap of compiled selector '" << category << "' !");
+  _category_ = category;
+  _type_ = type;
+  _number_of_columns_or_layers_ = number_of_columns_or_layers;
+  _number_of_rows_ = number_of_rows;
+  _bitmap_.resize(bits.size());
+  for (std::size_t i = 0; i < bits.size(); i++) _bitmap_[i] = bits[i] == '1';
+  _initialized_ = true;
+  return;
+}
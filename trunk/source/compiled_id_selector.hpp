@@ -0,0 +1,103 @@
+//! \file compiled_id_selector.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Half commissioning mapping rules (geomtools::id_selector) compiled
+// once into a dense bitmap over module / side / column or layer / row
+//
+
+#ifndef COMPILED_ID_SELECTOR_HPP
+#define COMPILED_ID_SELECTOR_HPP
+
+// Standard library:
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Third party:
+// - Bayeux/geomtools:
+#include <bayeux/geomtools/id_mgr.h>
+#include <bayeux/geomtools/id_selector.h>
+
+// This project :
+#include "hc_constants.hpp"
+
+//! \brief Dense bitmap of the geom IDs selected by mapping rules
+//
+// Supported categories are 'calorimeter_block' (module, side, column, row)
+// and 'drift_cell_core' (module, side, layer, row). Deeper addresses
+// (the calorimeter block part) are not part of the bitmap, rules must
+// not select on them.
+struct compiled_id_selector
+{
+  /// Calorimeter category
+  static const std::string & calo_category();
+
+  /// Geiger cell category
+  static const std::string & geiger_category();
+
+  /// Default constructor
+  compiled_id_selector();
+
+  /// Check initialization
+  bool is_initialized() const;
+
+  /// Compile the rules of an initialized id_selector for a category
+  void initialize(const geomtools::id_selector & selector_,
+		  const geomtools::id_mgr & id_mgr_,
+		  const std::string & category_);
+
+  /// Compile the rules of a mapping configuration file
+  ///
+  /// An empty path or an empty file leaves the selector uninitialized
+  /// (no geom ID matches), as the id_selector in the programs did.
+  void initialize(const std::string & mapping_config_,
+		  const geomtools::id_mgr & id_mgr_,
+		  const std::string & category_);
+
+  /// Reset
+  void reset();
+
+  /// Check if a geom ID matches the rules (one indexed bit test)
+  bool match(const geomtools::geom_id & gid_) const;
+
+  /// Check if a dense cell matches the rules
+  bool match(uint32_t module_, uint32_t side_, uint32_t column_or_layer_, uint32_t row_) const;
+
+  /// Return the category
+  const std::string & get_category() const;
+
+  /// Return the geom ID type of the category
+  uint32_t get_type() const;
+
+  /// Return the number of selected cells
+  std::size_t get_number_of_selected() const;
+
+  /// Print the selected cells
+  void dump(std::ostream & out_, const std::string & title_ = "") const;
+
+  /// Write the compiled bitmap of an initialized selector on one line
+  void store(std::ostream & out_) const;
+
+  /// Read a compiled bitmap written by store
+  void load(std::istream & in_);
+
+private :
+
+  bool _initialized_ = false;
+  std::string _category_;
+  uint32_t _type_ = geomtools::geom_id::INVALID_TYPE;
+  uint32_t _number_of_columns_or_layers_ = 0;
+  uint32_t _number_of_rows_ = 0;
+  std::vector<bool> _bitmap_;
+
+};
+
+#endif // COMPILED_ID_SELECTOR_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
@@ -5,11 +5,62 @@
 
 
 // Standard library:
+#include <cstdio>
 #include <limits>
+#include <memory>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+
+// Root :
+#include "TKey.h"
+#include "TList.h"
+#include "TParameter.h"
 
 // Ourselves:
 #include <data_statistics_simu.hpp>
 
+// This project :
+#include "calo_hit_accumulator.hpp"
+
+namespace {
+
+  const std::string SINGLE_CALO_DIRECTORY = "single_calo_energy";
+  const std::string STATISTICS_DIRECTORY = "processing_statistics";
+  const std::string SELECTIONS_DIRECTORY = "selections";
+
+  /// Add a histogram of a directory in a fixed histogram of the same name
+  template <class FixedHistogram>
+  void merge_histogram(TDirectory * directory_, FixedHistogram & histogram_)
+  {
+    std::unique_ptr<TH1> root_histogram(dynamic_cast<TH1 *>(directory_->Get(histogram_.get_name().c_str())));
+    DT_THROW_IF(!root_histogram, std::logic_error,
+		"Missing histogram '" << histogram_.get_name() << "' in directory '" << directory_->GetName() << "' !");
+    histogram_.merge(*root_histogram);
+    return;
+  }
+
+  /// Write a counter as a ROOT parameter in the current directory
+  void write_counter(const std::string & name_, uint64_t value_)
+  {
+    TParameter<Long64_t> parameter(name_.c_str(), static_cast<Long64_t>(value_));
+    parameter.Write("", TObject::kOverwrite);
+    return;
+  }
+
+  /// Read a counter written by write_counter, 0 if missing
+  uint64_t read_counter(TDirectory * directory_, const std::string & name_)
+  {
+    std::unique_ptr<TObject> object(directory_->Get(name_.c_str()));
+    const TParameter<Long64_t> * parameter = dynamic_cast<const TParameter<Long64_t> *>(object.get());
+    if (parameter == nullptr) return 0;
+    return static_cast<uint64_t>(parameter->GetVal());
+  }
+
+}
+
 data_statistics_simu::data_statistics_simu()
 {
   reset();
@@ -28,38 +79,36 @@ void data_statistics_simu::reset()
 void data_statistics_simu::_reset_()
 {
   // Histogram ptr :
-  for (unsigned int icol = 0; icol < hc_constants::NUMBER_OF_CALO_COLUMNS_USED; icol++) {
-    for (unsigned int irow = 0; irow < hc_constants::NUMBER_OF_CALO_PER_COLUMN; irow++) {
-      // calo_energy_TH1F[icalo] = nullptr;
-      calo_ht_energy_TH1F[icol][irow] = nullptr;
-      // calo_no_ht_energy_TH1F[icalo] = nullptr;
-    }
-  }
+  // calo_energy_TH1F[icalo] = nullptr;
+  calo_ht_energy.reset();
+  // calo_no_ht_energy_TH1F[icalo] = nullptr;
 
   // calo_distrib_TH2F = nullptr;
-  calo_distrib_ht_TH2F = nullptr;
+  calo_distrib_ht.reset();
   // calo_distrib_no_ht_TH2F = nullptr;
 
   // calo_total_energy_TH1F = nullptr;
-  calo_ht_total_energy_TH1F = nullptr;;
+  calo_ht_total_energy.reset();
   // calo_no_ht_total_energy_TH1F = nullptr;;
 
-  calo_delta_t_calo_tref_TH1F = nullptr;
+  calo_delta_t_calo_tref.reset();
 
   // one_calo_energy_TH1F = nullptr;
   // one_calo_distribution_TH2F = nullptr;
 
-  tracker_total_distribution_TH2F = nullptr;
+  tracker_total_distribution.reset();
+
+  calo_tracker_calo_distrib.reset();
+  calo_tracker_calo_ht_distrib.reset();
+  calo_tracker_tracker_distrib.reset();
 
-  calo_tracker_calo_distrib_TH2F = nullptr;
-  calo_tracker_calo_ht_distrib_TH2F = nullptr;
-  calo_tracker_tracker_distrib_TH2F = nullptr;
+  calo_tracker_delta_t_calo_tref.reset();
+  calo_tracker_delta_t_anode_tref.reset();
+  calo_tracker_delta_t_anode_anode.reset();
+  calo_tracker_delta_t_cathode_tref.reset();
+  calo_tracker_delta_t_anode_cathode_same_hit.reset();
 
-  calo_tracker_delta_t_calo_tref_TH1F = nullptr;
-  calo_tracker_delta_t_anode_tref_TH1F = nullptr;
-  calo_tracker_delta_t_anode_anode_TH1F = nullptr;
-  calo_tracker_delta_t_cathode_tref_TH1F = nullptr;
-  calo_tracker_delta_t_anode_cathode_same_hit_TH1F = nullptr;
+  statistics.reset();
 
   initialized = false;
 
@@ -71,25 +120,19 @@ void data_statistics_simu::initialize()
 
   // Initialize all histograms :
   std::string string_buffer = "";
-  for (unsigned int icol = 0; icol < hc_constants::NUMBER_OF_CALO_COLUMNS_USED; icol++) {
-
-    for (unsigned int irow = 0; irow < hc_constants::NUMBER_OF_CALO_PER_COLUMN; irow++) {
-      // string_buffer = "calo_energy_" + std::to_string(icalo);
-      // calo_energy_TH1F[icalo] = new TH1F(string_buffer.c_str(),
-      // 				       Form("Calorimeter energy, row %i", icalo),
-      // 				       1000, 0, 3000);
-
-      string_buffer = "calo_ht_energy_col" + std::to_string(icol) + "_row" + std::to_string(irow);
-      calo_ht_energy_TH1F[icol][irow] = new TH1F(string_buffer.c_str(),
-						 Form("Calorimeter HT energy, column %i, row %i", icol, irow),
-						 1000, 0, 3000);
-
-      // string_buffer = "calo_no_ht_energy_" + std::to_string(icalo);
-      // calo_no_ht_energy_TH1F[icalo] = new TH1F(string_buffer.c_str(),
-      // 				       Form("Calorimeter no HT energy, row %i", icalo),
-      // 				       1000, 0, 3000);
-    } // end of irow
-  } // end of for icol
+  // string_buffer = "calo_energy_" + std::to_string(icalo);
+  // calo_energy_TH1F[icalo] = new TH1F(string_buffer.c_str(),
+  // 				       Form("Calorimeter energy, row %i", icalo),
+  // 				       1000, 0, 3000);
+
+  // Single OM spectra, named and booked as ROOT histograms at save time :
+  calo_ht_energy.initialize(calo_hit_accumulator::NUMBER_OF_OMS,
+			    1000, 0, 3000);
+
+  // string_buffer = "calo_no_ht_energy_" + std::to_string(icalo);
+  // calo_no_ht_energy_TH1F[icalo] = new TH1F(string_buffer.c_str(),
+  // 				       Form("Calorimeter no HT energy, row %i", icalo),
+  // 				       1000, 0, 3000);
 
   // string_buffer = "calo_distrib_TH2F";
   // calo_distrib_TH2F =  new TH2F(string_buffer.c_str(),
@@ -98,10 +141,10 @@ void data_statistics_simu::initialize()
   // 				14, 0, 14);
 
   string_buffer = "calo_distrib_ht_TH2F";
-  calo_distrib_ht_TH2F =  new TH2F(string_buffer.c_str(),
-				   Form("Calo HT distribution"),
-				   20, 0, 20,
-				   14, 0, 14);
+  calo_distrib_ht.initialize(string_buffer,
+			     Form("Calo HT distribution"),
+			     20, 0, 20,
+			     14, 0, 14);
 
   // string_buffer = "calo_distrib_no_ht_TH2F";
   // calo_distrib_no_ht_TH2F =  new TH2F(string_buffer.c_str(),
@@ -116,9 +159,9 @@ void data_statistics_simu::initialize()
 
 
   string_buffer = "calo_ht_total_energy_TH1F";
-  calo_ht_total_energy_TH1F = new TH1F(string_buffer.c_str(),
-				       Form("Calorimeter HT total energy"),
-				       1000, 0, 3000);
+  calo_ht_total_energy.initialize(string_buffer,
+				  Form("Calorimeter HT total energy"),
+				  1000, 0, 3000);
 
   // string_buffer = "calo_no_ht_total_energy_TH1F";
   // calo_no_ht_total_energy_TH1F = new TH1F(string_buffer.c_str(),
@@ -126,102 +169,252 @@ void data_statistics_simu::initialize()
   // 					  1000, 0, 3000);
 
   string_buffer = "calo_delta_t_calo_tref_TH1F";
-  calo_delta_t_calo_tref_TH1F = new TH1F(string_buffer.c_str(),
-					 Form("Calo events 2+ calo HT, DT(calo_X - calo_tref)"),
-					 100, 0, 100);
+  calo_delta_t_calo_tref.initialize(string_buffer,
+				    Form("Calo events 2+ calo HT, DT(calo_X - calo_tref)"),
+				    100, 0, 100);
 
   string_buffer = "tracker_total_distribution_TH2F";
-  tracker_total_distribution_TH2F = new TH2F(string_buffer.c_str(),
-					     Form("Tracker cell total distribution"),
-					     6, 0, 6,
-					     10, 0, 10);
+  tracker_total_distribution.initialize(string_buffer,
+					Form("Tracker cell total distribution"),
+					6, 0, 6,
+					10, 0, 10);
 
   string_buffer = "calo_tracker_calo_distrib_TH2F";
-  calo_tracker_calo_distrib_TH2F  = new TH2F(string_buffer.c_str(),
-					     Form("Calo distribution if calo + tracker events"),
-					     20, 0, 20,
-					     14, 0, 14);
+  calo_tracker_calo_distrib.initialize(string_buffer,
+				       Form("Calo distribution if calo + tracker events"),
+				       20, 0, 20,
+				       14, 0, 14);
 
   string_buffer = "calo_tracker_calo_ht_distrib_TH2F";
-  calo_tracker_calo_ht_distrib_TH2F  = new TH2F(string_buffer.c_str(),
-						Form("Calo distribution if calo HT + tracker events"),
-						20, 0, 20,
-						14, 0, 14);
+  calo_tracker_calo_ht_distrib.initialize(string_buffer,
+					  Form("Calo distribution if calo HT + tracker events"),
+					  20, 0, 20,
+					  14, 0, 14);
 
   string_buffer = "calo_tracker_tracker_distrib_TH2F";
-  calo_tracker_tracker_distrib_TH2F  = new TH2F(string_buffer.c_str(),
-						Form("Tracker cell distribution if calo + tracker events"),
-						6, 0, 6,
-						10, 0, 10);
+  calo_tracker_tracker_distrib.initialize(string_buffer,
+					  Form("Tracker cell distribution if calo + tracker events"),
+					  6, 0, 6,
+					  10, 0, 10);
 
   string_buffer = "calo_tracker_delta_t_calo_tref_TH1F";
-  calo_tracker_delta_t_calo_tref_TH1F = new TH1F(string_buffer.c_str(),
-						 Form("Calo + tracker events, DT(calo_X - calo_tref)"),
-						 1000, 0, 1000);
+  calo_tracker_delta_t_calo_tref.initialize(string_buffer,
+					    Form("Calo + tracker events, DT(calo_X - calo_tref)"),
+					    1000, 0, 1000);
 
   string_buffer = "calo_tracker_delta_t_anode_tref_TH1F";
-  calo_tracker_delta_t_anode_tref_TH1F = new TH1F(string_buffer.c_str(),
-						  Form("Calo + tracker events, DT(anode_X - calo_tref)"),
-						  1000, 0, 200000);
+  calo_tracker_delta_t_anode_tref.initialize(string_buffer,
+					     Form("Calo + tracker events, DT(anode_X - calo_tref)"),
+					     1000, 0, 200000);
 
   string_buffer = "calo_tracker_delta_t_anode_anode_TH1F";
-  calo_tracker_delta_t_anode_anode_TH1F = new TH1F(string_buffer.c_str(),
-						   Form("Calo + tracker events, DT(anode_X - anode_Y)"),
-						   1000, 0, 200000);
+  calo_tracker_delta_t_anode_anode.initialize(string_buffer,
+					      Form("Calo + tracker events, DT(anode_X - anode_Y)"),
+					      1000, 0, 200000);
 
   string_buffer = "calo_tracker_delta_t_cathode_tref_TH1F";
-  calo_tracker_delta_t_cathode_tref_TH1F = new TH1F(string_buffer.c_str(),
-						    Form("Calo + tracker events, DT(cathode_X - calo_tref)"),
-						    1000, 0, 200000);
+  calo_tracker_delta_t_cathode_tref.initialize(string_buffer,
+					       Form("Calo + tracker events, DT(cathode_X - calo_tref)"),
+					       1000, 0, 200000);
 
   string_buffer = "calo_tracker_delta_t_anode_cathode_same_hit_TH1F";
-  calo_tracker_delta_t_anode_cathode_same_hit_TH1F = new TH1F(string_buffer.c_str(),
-							      Form("Calo + tracker events, DT(anode_X - cathode_X)"),
-							      1000, 0, 10000);
+  calo_tracker_delta_t_anode_cathode_same_hit.initialize(string_buffer,
+							 Form("Calo + tracker events, DT(anode_X - cathode_X)"),
+							 1000, 0, 10000);
 
 
   initialized = true;
   return;
 }
 
-void data_statistics_simu::save_in_root_file(TFile * root_file_)
+void data_statistics_simu::merge(const data_statistics_simu & other_, bool other_job_)
 {
-  root_file_->cd("single_calo_energy");
+  calo_ht_energy.merge(other_.calo_ht_energy);
 
-  for (unsigned int icol = 0; icol < hc_constants::NUMBER_OF_CALO_COLUMNS_USED; icol++) {
-    for (unsigned int irow = 0; irow < hc_constants::NUMBER_OF_CALO_PER_COLUMN; irow++) {
-      calo_ht_energy_TH1F[icol][irow]->Write("", TObject::kOverwrite);
-    }
+  calo_distrib_ht.merge(other_.calo_distrib_ht);
+  calo_ht_total_energy.merge(other_.calo_ht_total_energy);
+  calo_delta_t_calo_tref.merge(other_.calo_delta_t_calo_tref);
+
+  tracker_total_distribution.merge(other_.tracker_total_distribution);
+
+  calo_tracker_calo_distrib.merge(other_.calo_tracker_calo_distrib);
+  calo_tracker_calo_ht_distrib.merge(other_.calo_tracker_calo_ht_distrib);
+  calo_tracker_tracker_distrib.merge(other_.calo_tracker_tracker_distrib);
+  calo_tracker_delta_t_calo_tref.merge(other_.calo_tracker_delta_t_calo_tref);
+  calo_tracker_delta_t_anode_tref.merge(other_.calo_tracker_delta_t_anode_tref);
+  calo_tracker_delta_t_anode_anode.merge(other_.calo_tracker_delta_t_anode_anode);
+  calo_tracker_delta_t_cathode_tref.merge(other_.calo_tracker_delta_t_cathode_tref);
+  calo_tracker_delta_t_anode_cathode_same_hit.merge(other_.calo_tracker_delta_t_anode_cathode_same_hit);
+
+  if (other_job_) statistics.merge_job(other_.statistics);
+  else statistics.merge(other_.statistics);
+
+  return;
+}
+
+void data_statistics_simu::save_in_root_file(TDirectory * directory_)
+{
+  TDirectory * single_calo_directory = directory_->GetDirectory(SINGLE_CALO_DIRECTORY.c_str());
+  if (single_calo_directory == nullptr) single_calo_directory = directory_->mkdir(SINGLE_CALO_DIRECTORY.c_str(),
+										   "Single calorimeter energy distribution");
+  single_calo_directory->cd();
+
+  // Only the OMs which fired have a spectrum :
+  const std::vector<std::size_t> fired_oms = calo_ht_energy.get_filled_channels();
+  for (std::size_t i = 0; i < fired_oms.size(); i++) {
+    uint32_t side = 0, column = 0, row = 0;
+    calo_hit_accumulator::om_address(fired_oms[i], side, column, row);
+    const std::string name = "calo_ht_energy_side" + std::to_string(side) + "_col" + std::to_string(column) + "_row" + std::to_string(row);
+    std::unique_ptr<TH1F> spectrum(calo_ht_energy.make_TH1F(fired_oms[i], name,
+							     Form("Calorimeter HT energy, side %u, column %u, row %u", side, column, row)));
+    spectrum->Write("", TObject::kOverwrite);
   }
 
-  root_file_->cd();
+  directory_->cd();
 
-  calo_distrib_ht_TH2F->Write("", TObject::kOverwrite);
-  calo_ht_total_energy_TH1F->Write("", TObject::kOverwrite);;
-  calo_delta_t_calo_tref_TH1F->Write("", TObject::kOverwrite);
+  calo_distrib_ht.write();
+  calo_ht_total_energy.write();
+  calo_delta_t_calo_tref.write();
 
   // Segfault because histograms are not initialized
   // one_calo_energy_TH1F->Write("", TObject::kOverwrite);
   // one_calo_distribution_TH2F->Write("", TObject::kOverwrite);
 
 
-  tracker_total_distribution_TH2F->Write("", TObject::kOverwrite);
+  tracker_total_distribution.write();
 
-  calo_tracker_calo_distrib_TH2F->Write("", TObject::kOverwrite);
-  calo_tracker_calo_ht_distrib_TH2F->Write("", TObject::kOverwrite);
-  calo_tracker_tracker_distrib_TH2F->Write("", TObject::kOverwrite);
-  calo_tracker_delta_t_calo_tref_TH1F->Write("", TObject::kOverwrite);
-  calo_tracker_delta_t_anode_tref_TH1F->Write("", TObject::kOverwrite);
-  calo_tracker_delta_t_anode_anode_TH1F->Write("", TObject::kOverwrite);
-  calo_tracker_delta_t_cathode_tref_TH1F->Write("", TObject::kOverwrite);
-  calo_tracker_delta_t_anode_cathode_same_hit_TH1F->Write("", TObject::kOverwrite);
+  calo_tracker_calo_distrib.write();
+  calo_tracker_calo_ht_distrib.write();
+  calo_tracker_tracker_distrib.write();
+  calo_tracker_delta_t_calo_tref.write();
+  calo_tracker_delta_t_anode_tref.write();
+  calo_tracker_delta_t_anode_anode.write();
+  calo_tracker_delta_t_cathode_tref.write();
+  calo_tracker_delta_t_anode_cathode_same_hit.write();
 
   return;
 }
 
+void data_statistics_simu::merge_from_root_file(TDirectory * directory_)
+{
+  DT_THROW_IF(!initialized, std::logic_error, "Data statistics are not initialized !");
+
+  // Single calo spectra, the OM is given by the histogram name :
+  TDirectory * single_calo_directory = directory_->GetDirectory(SINGLE_CALO_DIRECTORY.c_str());
+  DT_THROW_IF(single_calo_directory == nullptr, std::logic_error,
+	      "Missing '" << SINGLE_CALO_DIRECTORY << "' in directory '" << directory_->GetName() << "' !");
+  TIter next_key(single_calo_directory->GetListOfKeys());
+  while (TKey * key = static_cast<TKey *>(next_key()))
+    {
+      unsigned int side = 0, column = 0, row = 0;
+      char trailing = 0;
+      if (std::sscanf(key->GetName(), "calo_ht_energy_side%u_col%u_row%u%c", &side, &column, &row, &trailing) != 3) continue;
+      DT_THROW_IF(side >= hc_constants::NUMBER_OF_SIDES
+		  || column >= hc_constants::NUMBER_OF_CALO_COLUMNS
+		  || row >= hc_constants::NUMBER_OF_CALO_PER_COLUMN, std::logic_error,
+		  "Invalid OM in single calo spectrum '" << key->GetName() << "' !");
+      std::unique_ptr<TObject> object(key->ReadObj());
+      const TH1 * spectrum = dynamic_cast<const TH1 *>(object.get());
+      DT_THROW_IF(spectrum == nullptr, std::logic_error, "Single calo spectrum '" << key->GetName() << "' is not a histogram !");
+      const std::size_t om = (side * hc_constants::NUMBER_OF_CALO_COLUMNS + column) * hc_constants::NUMBER_OF_CALO_PER_COLUMN + row;
+      calo_ht_energy.merge(om, *spectrum);
+    }
+
+  merge_histogram(directory_, calo_distrib_ht);
+  merge_histogram(directory_, calo_ht_total_energy);
+  merge_histogram(directory_, calo_delta_t_calo_tref);
+
+  merge_histogram(directory_, tracker_total_distribution);
+
+  merge_histogram(directory_, calo_tracker_calo_distrib);
+  merge_histogram(directory_, calo_tracker_calo_ht_distrib);
+  merge_histogram(directory_, calo_tracker_tracker_distrib);
+  merge_histogram(directory_, calo_tracker_delta_t_calo_tref);
+  merge_histogram(directory_, calo_tracker_delta_t_anode_tref);
+  merge_histogram(directory_, calo_tracker_delta_t_anode_anode);
+  merge_histogram(directory_, calo_tracker_delta_t_cathode_tref);
+  merge_histogram(directory_, calo_tracker_delta_t_anode_cathode_same_hit);
+
+  return;
+}
+
+void data_statistics_simu::save_statistics_in_root_file(TDirectory * directory_) const
+{
+  TDirectory * statistics_directory = directory_->GetDirectory(STATISTICS_DIRECTORY.c_str());
+  if (statistics_directory == nullptr) statistics_directory = directory_->mkdir(STATISTICS_DIRECTORY.c_str(),
+										 "Timers and counters of the event loop");
+  statistics_directory->cd();
+  write_counter("number_of_events", statistics.number_of_events);
+  write_counter("number_of_calo_step_hits", statistics.number_of_calo_step_hits);
+  write_counter("number_of_geiger_step_hits", statistics.number_of_geiger_step_hits);
+  write_counter("run_wall_ns", statistics.run_wall_ns);
+  for (std::size_t i = 0; i < statistics.stages.size(); i++) {
+    const std::string stage = processing_statistics::stage_name(static_cast<processing_statistics::stage_type>(i));
+    write_counter(stage + "_calls", statistics.stages[i].calls);
+    write_counter(stage + "_wall_ns", statistics.stages[i].wall_ns);
+    write_counter(stage + "_cpu_ns", statistics.stages[i].cpu_ns);
+  }
+
+  TDirectory * selections_directory = statistics_directory->GetDirectory(SELECTIONS_DIRECTORY.c_str());
+  if (selections_directory == nullptr) selections_directory = statistics_directory->mkdir(SELECTIONS_DIRECTORY.c_str(),
+											   "Events accepted and rejected by the selections");
+  selections_directory->cd();
+  for (std::size_t i = 0; i < statistics.selections.size(); i++) {
+    write_counter(statistics.selections[i].name + "_accepted", statistics.selections[i].accepted);
+    write_counter(statistics.selections[i].name + "_rejected", statistics.selections[i].rejected);
+  }
+
+  directory_->cd();
+  return;
+}
+
+void data_statistics_simu::merge_statistics_from_root_file(TDirectory * directory_)
+{
+  TDirectory * statistics_directory = directory_->GetDirectory(STATISTICS_DIRECTORY.c_str());
+  if (statistics_directory == nullptr) return;
+  processing_statistics file_statistics;
+  file_statistics.number_of_events = read_counter(statistics_directory, "number_of_events");
+  file_statistics.number_of_calo_step_hits = read_counter(statistics_directory, "number_of_calo_step_hits");
+  file_statistics.number_of_geiger_step_hits = read_counter(statistics_directory, "number_of_geiger_step_hits");
+  file_statistics.run_wall_ns = read_counter(statistics_directory, "run_wall_ns");
+  for (std::size_t i = 0; i < file_statistics.stages.size(); i++) {
+    const std::string stage = processing_statistics::stage_name(static_cast<processing_statistics::stage_type>(i));
+    file_statistics.stages[i].calls = read_counter(statistics_directory, stage + "_calls");
+    file_statistics.stages[i].wall_ns = read_counter(statistics_directory, stage + "_wall_ns");
+    file_statistics.stages[i].cpu_ns = read_counter(statistics_directory, stage + "_cpu_ns");
+  }
+
+  // Selections in the order they were saved :
+  TDirectory * selections_directory = statistics_directory->GetDirectory(SELECTIONS_DIRECTORY.c_str());
+  if (selections_directory != nullptr) {
+    const std::string accepted_suffix = "_accepted";
+    TIter next_key(selections_directory->GetListOfKeys());
+    while (TKey * key = static_cast<TKey *>(next_key()))
+      {
+	const std::string key_name = key->GetName();
+	if (key_name.size() <= accepted_suffix.size()
+	    || key_name.compare(key_name.size() - accepted_suffix.size(), accepted_suffix.size(), accepted_suffix) != 0) continue;
+	const std::string name = key_name.substr(0, key_name.size() - accepted_suffix.size());
+	processing_statistics::selection_counter & selection = file_statistics.selections[file_statistics.add_selection(name)];
+	selection.accepted = read_counter(selections_directory, name + "_accepted");
+	selection.rejected = read_counter(selections_directory, name + "_rejected");
+      }
+  }
+
+  statistics.merge_job(file_statistics);
+  return;
+}
+
 void data_statistics_simu::print(std::ostream & out_)
 {
   out_ << std::endl;
+  out_ << "Data statistics :" << std::endl;
+  // The total calo energy is filled for every analyzed event, with or without calo hits :
+  out_ << "  Analyzed events              : " << calo_ht_total_energy.get_entries() << std::endl;
+  out_ << "  OMs with an energy spectrum  : " << calo_ht_energy.get_filled_channels().size() << std::endl;
+  out_ << "  Geiger cells hit             : " << tracker_total_distribution.get_entries() << std::endl;
+  statistics.print(out_);
+  out_ << std::endl;
 
   return;
 }
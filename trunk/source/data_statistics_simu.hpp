@@ -2,8 +2,9 @@
 //
 // Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
 //
-// Class containing root histograms for
-// half commissioning simulation analysis
+// Class containing the histograms for
+// half commissioning simulation analysis,
+// converted to root histograms when saved
 //
 
 #ifndef DATA_STATISTICS_SIMU_HPP
@@ -12,16 +13,14 @@
 // Standard library:
 #include <string>
 #include <iostream>
-#include <array>
 
 // Root :
 #include "TFile.h"
-#include "TTree.h"
-#include "TH1F.h"
-#include "TH2F.h"
 
 // This project :
+#include "fixed_histogram.hpp"
 #include "hc_constants.hpp"
+#include "processing_statistics.hpp"
 
 //! \brief
 struct data_statistics_simu
@@ -38,10 +37,22 @@ struct data_statistics_simu
 	/// Initialize
 	void initialize();
 
-  // Save histograms in root file
-  void save_in_root_file(TFile * root_file_);
+  /// Add the histograms of another (initialized) data statistics, of another thread or of another job
+  void merge(const data_statistics_simu & other_, bool other_job_ = false);
 
-  /// Print in a text file data statistics
+  // Save histograms in a directory of a root file (single calo spectra in its 'single_calo_energy' sub-directory)
+  void save_in_root_file(TDirectory * directory_);
+
+  /// Add the histograms saved by save_in_root_file in a directory of a root file (initialized data statistics)
+  void merge_from_root_file(TDirectory * directory_);
+
+  /// Save the processing statistics in the 'processing_statistics' sub-directory of a directory
+  void save_statistics_in_root_file(TDirectory * directory_) const;
+
+  /// Add the processing statistics saved by save_statistics_in_root_file in a directory, if any, as another job
+  void merge_statistics_from_root_file(TDirectory * directory_);
+
+  /// Print in a text file data statistics and processing statistics
   virtual void print(std::ostream & out_);
 
 private :
@@ -58,17 +69,18 @@ public :
 
   // Calorimeter (only ht in simulation)
   // std::array<TH1F *, hc_constants::NUMBER_OF_CALO_PER_COLUMN> calo_energy_TH1F{};
-	std::array<std::array<TH1F *, hc_constants::NUMBER_OF_CALO_PER_COLUMN>, hc_constants::NUMBER_OF_CALO_COLUMNS_USED> calo_ht_energy_TH1F{{}};
+	// One channel per OM, indexed as calo_hit_accumulator::om_index (side, column, row) :
+	fixed_histogram_1d_array calo_ht_energy;
   // std::array<TH1F *, hc_constants::NUMBER_OF_CALO_PER_COLUMN> calo_no_ht_energy_TH1F{};
 	//  TH2F * calo_distrib_TH2F;
-  TH2F * calo_distrib_ht_TH2F;
+  fixed_histogram_2d calo_distrib_ht;
   // TH2F * calo_distrib_no_ht_TH2F;
 
   // TH1F * calo_total_energy_TH1F;
-  TH1F * calo_ht_total_energy_TH1F;
+  fixed_histogram_1d calo_ht_total_energy;
   // TH1F * calo_no_ht_total_energy_TH1F;
 
-  TH1F * calo_delta_t_calo_tref_TH1F;
+  fixed_histogram_1d calo_delta_t_calo_tref;
 
   // One calo (HT) :
   // TH1F * one_calo_energy_TH1F;
@@ -76,20 +88,23 @@ public :
 
 
   // Tracker :
-  TH2F * tracker_total_distribution_TH2F;
+  fixed_histogram_2d tracker_total_distribution;
 
 
 	// Calo tracker :
 
-	TH2F * calo_tracker_calo_distrib_TH2F;
-	TH2F * calo_tracker_calo_ht_distrib_TH2F;
-	TH2F * calo_tracker_tracker_distrib_TH2F;
+	fixed_histogram_2d calo_tracker_calo_distrib;
+	fixed_histogram_2d calo_tracker_calo_ht_distrib;
+	fixed_histogram_2d calo_tracker_tracker_distrib;
+
+	fixed_histogram_1d calo_tracker_delta_t_calo_tref;
+	fixed_histogram_1d calo_tracker_delta_t_anode_tref;
+	fixed_histogram_1d calo_tracker_delta_t_anode_anode;
+	fixed_histogram_1d calo_tracker_delta_t_cathode_tref;
+	fixed_histogram_1d calo_tracker_delta_t_anode_cathode_same_hit;
 
-	TH1F * calo_tracker_delta_t_calo_tref_TH1F;
-	TH1F * calo_tracker_delta_t_anode_tref_TH1F;
-	TH1F * calo_tracker_delta_t_anode_anode_TH1F;
-	TH1F * calo_tracker_delta_t_cathode_tref_TH1F;
-	TH1F * calo_tracker_delta_t_anode_cathode_same_hit_TH1F;
+	// Timers and counters of the event loop :
+	processing_statistics statistics;
 
 };
 
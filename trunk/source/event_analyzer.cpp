@@ -0,0 +1,231 @@
+//! \file event_analyzer.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <bitset>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/utils.h>
+
+// Ourselves:
+#include <event_analyzer.hpp>
+
+event_analyzer::event_analyzer()
+{
+  datatools::invalidate(geiger_dead_time);
+  clear();
+}
+
+void event_analyzer::clear()
+{
+  calo_hits.clear();
+  datatools::invalidate(calo_tref);
+  calo_total_energy = 0;
+  geiger_hit_set.clear();
+  geiger_hits.clear();
+  collection_position_last_geiger_hit.clear();
+  is_calo = false;
+  is_tracker = false;
+  full_track_event = false;
+  return;
+}
+
+void event_analyzer::process(const mctools::simulated_data & SD_)
+{
+  clear();
+
+  // First loop on all calo hits to merge each calo hit in the same OM :
+  calo_oms.reset();
+  geiger_fired_hits.clear();
+  if (SD_.has_step_hits("calo"))
+    {
+      processing_statistics::scoped_timer timer(statistics, processing_statistics::STAGE_CALO_MERGE);
+      const mctools::simulated_data::hit_handle_collection_type & BSHC = SD_.get_step_hits("calo");
+      DT_LOG_TRACE(logging, "BSCH calo step hits # = " << BSHC.size());
+      if (statistics != nullptr) statistics->number_of_calo_step_hits += BSHC.size();
+
+      for (mctools::simulated_data::hit_handle_collection_type::const_iterator i = BSHC.begin();
+	   i != BSHC.end();
+	   i++)
+	{
+	  calo_oms.add(i->get());
+	} // end of for i BSHC
+
+      DT_LOG_TRACE(logging, "Number of calo OM hit :" << calo_oms.get_number_of_touched());
+
+      // Keep calorimeters matching selector rules (from commissioning) and passing the threshold
+      if (calo_selector != nullptr) calo_oms.extract(*calo_selector, calo_threshold_kev, calo_hits);
+
+    } // end of if has step hits "calo"
+
+  std::size_t geiger_last_layer = hc_constants::NUMBER_OF_GEIGER_LAYERS - 1;
+
+  if (SD_.has_step_hits("gg"))
+    {
+      processing_statistics::scoped_timer timer(statistics, processing_statistics::STAGE_GEIGER_FLAG);
+      const mctools::simulated_data::hit_handle_collection_type & BSHC_gg = SD_.get_step_hits("gg");
+      const size_t number_of_gg_hits = BSHC_gg.size();
+      DT_LOG_TRACE(logging, "BSCH geiger step hits # = " << number_of_gg_hits);
+      if (statistics != nullptr) statistics->number_of_geiger_step_hits += number_of_gg_hits;
+
+      // First pass : collect the hits of each Geiger cell, and select the ones firing it
+      geiger_cells.reset();
+      geiger_hit_cells.resize(number_of_gg_hits);
+      for (size_t ihit = 0; ihit < number_of_gg_hits; ihit++)
+	{
+	  const mctools::base_step_hit & BSH = BSHC_gg[ihit].get();
+	  const std::size_t cell = geiger_cell_table::cell_index(BSH.get_geom_id());
+	  geiger_hit_cells[ihit] = cell;
+	  if (cell != geiger_cell_table::INVALID_CELL) geiger_cells.add_hit(cell, ihit, BSH.get_time_start());
+	}
+      geiger_cells.select_fires(geiger_dead_time);
+
+      // Second pass on Geiger hits, ignore the re-hits of cells already fired (within the dead time if any)
+      for (size_t ihit = 0; ihit < number_of_gg_hits; ihit++)
+	{
+	  const mctools::base_step_hit & BSH = BSHC_gg[ihit].get();
+	  const std::size_t cell = geiger_hit_cells[ihit];
+	  if (cell != geiger_cell_table::INVALID_CELL && geiger_cells.is_rehit(ihit)) continue;
+	  if (cell != geiger_cell_table::INVALID_CELL) geiger_fired_hits.push_back(ihit);
+
+	  const geomtools::geom_id & geiger_gid = BSH.get_geom_id();
+
+	  // Add in the map tracker only if they match selector rules (from commissioning)
+	  if (geiger_selector != nullptr && geiger_selector->match(geiger_gid)) {
+	    geiger_hit_set.insert(geiger_gid);
+	    geiger_hit_summary geiger_hit;
+	    geiger_hit.geom_id = geiger_gid;
+	    geiger_hit.time = BSH.get_time_start();
+	    geiger_hit.position_stop = BSH.get_position_stop();
+	    geiger_hits.push_back(geiger_hit);
+	    // If the last Geiger at layer 8 is hit, push back position for calorimeter association
+	    if (geiger_gid.get(2) == geiger_last_layer) // last layer
+	      {
+		collection_position_last_geiger_hit.push_back(BSH.get_position_stop());
+	      }
+	  } // end of selector match
+	} // end of for ihit
+    } // end of if has step hits "gg"
+
+  _finalize_();
+  return;
+}
+
+void event_analyzer::process(const event_cache_event_view & event_)
+{
+  clear();
+  calo_oms.reset();
+  geiger_fired_hits.clear();
+
+  // Calo hits are cached in the OM order, same cuts as calo_hit_accumulator::extract :
+  for (std::size_t ihit = 0; ihit < event_.number_of_calo_hits; ihit++)
+    {
+      const event_cache_calo_hit & cached = event_.calo_hits[ihit];
+      if (cached.energy * 1000 < calo_threshold_kev) continue;
+      uint32_t side = 0, column = 0, row = 0;
+      calo_hit_accumulator::om_address(cached.om_index, side, column, row);
+      if (calo_selector == nullptr || !calo_selector->match(0, side, column, row)) continue;
+      calo_hit_summary calo_hit;
+      calo_hit.geom_id = geomtools::geom_id(event_.calo_type, 0, side, column, row, cached.part);
+      calo_hit.energy = cached.energy;
+      calo_hit.time = cached.time;
+      calo_hit.left_most_hit_position.set(cached.left_most_position[0],
+					  cached.left_most_position[1],
+					  cached.left_most_position[2]);
+      calo_hits.push_back(calo_hit);
+    }
+
+  const std::size_t geiger_last_layer = hc_constants::NUMBER_OF_GEIGER_LAYERS - 1;
+  for (std::size_t ihit = 0; ihit < event_.number_of_geiger_hits; ihit++)
+    {
+      const event_cache_geiger_hit & cached = event_.geiger_hits[ihit];
+      uint32_t side = 0, layer = 0, row = 0;
+      geiger_cell_table::cell_address(cached.cell_index, side, layer, row);
+      if (geiger_selector == nullptr || !geiger_selector->match(0, side, layer, row)) continue;
+      geiger_hit_summary geiger_hit;
+      geiger_hit.geom_id = geomtools::geom_id(event_.geiger_type, 0, side, layer, row);
+      geiger_hit.time = cached.time;
+      geiger_hit.position_stop.set(cached.position_stop[0],
+				   cached.position_stop[1],
+				   cached.position_stop[2]);
+      geiger_hit_set.insert(geiger_hit.geom_id);
+      geiger_hits.push_back(geiger_hit);
+      if (layer == geiger_last_layer) collection_position_last_geiger_hit.push_back(geiger_hit.position_stop);
+    }
+
+  _finalize_();
+  return;
+}
+
+void event_analyzer::apply_calo_threshold(double calo_threshold_kev_)
+{
+  calo_hits.clear();
+  datatools::invalidate(calo_tref);
+  calo_total_energy = 0;
+  if (calo_selector != nullptr) calo_oms.extract(*calo_selector, calo_threshold_kev_, calo_hits);
+  _finalize_();
+  return;
+}
+
+void event_analyzer::_finalize_()
+{
+  for (std::size_t ihit = 0; ihit < calo_hits.size(); ihit++)
+    {
+      if (ihit == 0 || calo_hits[ihit].time < calo_tref) calo_tref = calo_hits[ihit].time;
+      calo_total_energy += calo_hits[ihit].energy;
+    }
+
+  // Calorimeter 'exists' only if E_calo > threshold
+  is_calo = !calo_hits.empty();
+  is_tracker = !geiger_hit_set.empty();
+
+  std::bitset<hc_constants::NUMBER_OF_GEIGER_LAYERS> layer_projection = 0x0;
+  for (std::set<geomtools::geom_id>::const_iterator it_geiger = geiger_hit_set.begin();
+       it_geiger != geiger_hit_set.end();
+       it_geiger++)
+    {
+      layer_projection.set(it_geiger->get(2), true);
+    }
+  if (layer_projection.count() == hc_constants::NUMBER_OF_GEIGER_LAYERS) full_track_event = true;
+
+  return;
+}
+
+void event_analyzer::fill(data_statistics_simu & dss_) const
+{
+  // For each calorimeter, add it in the histogram
+  for (std::size_t ihit = 0; ihit < calo_hits.size(); ihit++)
+    {
+      const calo_hit_summary & calo_hit = calo_hits[ihit];
+      int column = calo_hit.geom_id.get(2);
+      int row = calo_hit.geom_id.get(3);
+
+      dss_.calo_distrib_ht.fill(column, row);
+      const std::size_t om = calo_hit_accumulator::om_index(calo_hit.geom_id);
+      if (om != calo_hit_accumulator::INVALID_OM) dss_.calo_ht_energy.fill(om, calo_hit.energy * 1000);
+    }
+
+  dss_.calo_ht_total_energy.fill(calo_total_energy * 1000);
+
+  // Second loop for timing Tcalo_X - Tcalo_ref
+  for (std::size_t ihit = 0; ihit < calo_hits.size(); ihit++)
+    {
+      double delta_t = calo_hits[ihit].time - calo_tref;
+      if (delta_t != 0) dss_.calo_delta_t_calo_tref.fill(delta_t);
+    }
+
+  // For each Geiger cell, add it in the histogram
+  for (std::set<geomtools::geom_id>::const_iterator it_geiger = geiger_hit_set.begin();
+       it_geiger != geiger_hit_set.end();
+       it_geiger++)
+    {
+      int layer = it_geiger->get(2);
+      int row   = it_geiger->get(3);
+      dss_.tracker_total_distribution.fill(row, layer);
+    }
+
+  return;
+}
@@ -0,0 +1,109 @@
+//! \file event_analyzer.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Per event analysis of a simulated data bank :
+// calo hits merged by OM, Geiger cells hit once,
+// and filling of the data statistics histograms
+//
+
+#ifndef EVENT_ANALYZER_HPP
+#define EVENT_ANALYZER_HPP
+
+// Standard library:
+#include <set>
+#include <vector>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+// - Bayeux/mctools:
+#include <mctools/simulated_data.h>
+
+// This project :
+#include "calo_hit_accumulator.hpp"
+#include "compiled_id_selector.hpp"
+#include "data_statistics_simu.hpp"
+#include "event_cache.hpp"
+#include "geiger_cell_table.hpp"
+#include "hc_constants.hpp"
+#include "processing_statistics.hpp"
+
+/// Geiger cell fired in an event, matching the selector rules
+struct geiger_hit_summary
+{
+  geomtools::geom_id geom_id;
+  double time = 0;
+  geomtools::vector_3d position_stop;
+};
+
+//! \brief Analysis of one simulated event
+//
+// The analyzer holds no reference to the event record and never copies
+// it, one instance per thread can be used to process events concurrently.
+struct event_analyzer
+{
+  /// Default constructor
+  event_analyzer();
+
+  /// Reset the event products
+  void clear();
+
+  /// Build the calo hits and the Geiger hit set from a SD bank
+  void process(const mctools::simulated_data & SD_);
+
+  /// Build the calo hits and the Geiger hit set from the raw hits of an event cache
+  ///
+  /// Threshold and selector cuts are applied as for a SD bank, the
+  /// Geiger dead time is the one used when the cache was produced.
+  void process(const event_cache_event_view & event_);
+
+  /// Select again the calo hits of the last SD bank with another threshold
+  ///
+  /// Calo products and event flags are updated from the OM sums of the
+  /// last process(SD_), the step hits are not read again.
+  void apply_calo_threshold(double calo_threshold_kev_);
+
+  /// Fill histograms with the event products
+  void fill(data_statistics_simu & dss_) const;
+
+  // Configuration :
+  const compiled_id_selector * calo_selector = nullptr;
+  const compiled_id_selector * geiger_selector = nullptr;
+  double calo_threshold_kev = hc_constants::CALO_COMMISSIONING_HIGH_THRESHOLD_KEV;
+  double geiger_dead_time; ///< Invalid : a Geiger cell fires only once per event
+  datatools::logger::priority logging = datatools::logger::PRIO_FATAL;
+  processing_statistics * statistics = nullptr; ///< Step hit counters and calo / Geiger stage timers, if any
+
+  // Working structures reused from one event to the other,
+  // the SD bank is only read through const references :
+  calo_hit_accumulator calo_oms;           ///< Calo step hits merged by OM
+  geiger_cell_table geiger_cells;          ///< Hits and fires of each Geiger cell
+  std::vector<std::size_t> geiger_hit_cells; ///< Cell index of each gg step hit
+  std::vector<std::size_t> geiger_fired_hits; ///< gg step hits firing a cell, before the selector
+
+  // Event products :
+  std::vector<calo_hit_summary> calo_hits; ///< OM hits above threshold, in OM order
+  double calo_tref;                        ///< Earliest OM hit time
+  double calo_total_energy = 0;
+  std::set<geomtools::geom_id> geiger_hit_set;
+  std::vector<geiger_hit_summary> geiger_hits; ///< Selected Geiger cell fires, in step hit order
+  std::vector<geomtools::vector_3d> collection_position_last_geiger_hit;
+  bool is_calo = false;
+  bool is_tracker = false;
+  bool full_track_event = false;
+
+private :
+
+  /// Calo reference time, total energy and event flags from the selected hits
+  void _finalize_();
+
+};
+
+#endif // EVENT_ANALYZER_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
@@ -0,0 +1,283 @@
+//! \file event_cache.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+// System:
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+
+// Ourselves:
+#include <event_cache.hpp>
+
+// This project :
+#include "event_analyzer.hpp"
+
+namespace {
+  const char CACHE_MAGIC[8] = {'H', 'C', 'E', 'V', 'T', 'C', 'A', 'C'};
+  const uint32_t CACHE_VERSION = 1;
+  const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+  // Records are packed one after the other, every field must stay aligned :
+  static_assert(sizeof(event_cache_header) == 48, "Unexpected event cache header layout");
+  static_assert(sizeof(event_cache_event) % 8 == 0, "Unexpected event cache record layout");
+  static_assert(sizeof(event_cache_calo_hit) == 32, "Unexpected event cache calo hit layout");
+  static_assert(sizeof(event_cache_geiger_hit) == 24, "Unexpected event cache Geiger hit layout");
+
+  template <class T>
+  T * append(std::vector<char> & record_, std::size_t count_)
+  {
+    const std::size_t offset = record_.size();
+    record_.resize(offset + count_ * sizeof(T));
+    return reinterpret_cast<T *>(record_.data() + offset);
+  }
+}
+
+void event_cache_writer::encode(const event_analyzer & analyzer_,
+				const mctools::simulated_data & SD_,
+				std::vector<char> & record_)
+{
+  record_.clear();
+  const std::vector<std::size_t> & touched_oms = analyzer_.calo_oms.get_touched_oms();
+  const std::vector<std::size_t> & fired_hits = analyzer_.geiger_fired_hits;
+
+  event_cache_event * counts = append<event_cache_event>(record_, 1);
+  counts->number_of_calo_hits = touched_oms.size();
+  counts->number_of_geiger_hits = fired_hits.size();
+
+  // Calo hits in the OM order, as calo_hit_accumulator::extract :
+  event_cache_calo_hit * calo_hits = append<event_cache_calo_hit>(record_, touched_oms.size());
+  for (std::size_t i = 0; i < touched_oms.size(); i++)
+    {
+      const calo_hit_summary & calo_hit = analyzer_.calo_oms.get_om(touched_oms[i]);
+      event_cache_calo_hit & cached = calo_hits[i];
+      cached.om_index = touched_oms[i];
+      cached.part = calo_hit.geom_id.get_depth() > 4 ? calo_hit.geom_id.get(4) : 0;
+      cached.left_most_position[0] = calo_hit.left_most_hit_position.x();
+      cached.left_most_position[1] = calo_hit.left_most_hit_position.y();
+      cached.left_most_position[2] = calo_hit.left_most_hit_position.z();
+      cached.energy = calo_hit.energy;
+      cached.time = calo_hit.time;
+    }
+  std::sort(calo_hits, calo_hits + touched_oms.size(),
+	    [] (const event_cache_calo_hit & a_, const event_cache_calo_hit & b_) {
+	      return a_.om_index < b_.om_index;
+	    });
+
+  if (fired_hits.empty()) return;
+
+  // Geiger fires in the step hit order :
+  const mctools::simulated_data::hit_handle_collection_type & BSHC_gg = SD_.get_step_hits("gg");
+  event_cache_geiger_hit * geiger_hits = append<event_cache_geiger_hit>(record_, fired_hits.size());
+  for (std::size_t i = 0; i < fired_hits.size(); i++)
+    {
+      const mctools::base_step_hit & BSH = BSHC_gg[fired_hits[i]].get();
+      event_cache_geiger_hit & cached = geiger_hits[i];
+      cached.cell_index = analyzer_.geiger_hit_cells[fired_hits[i]];
+      cached.position_stop[0] = BSH.get_position_stop().x();
+      cached.position_stop[1] = BSH.get_position_stop().y();
+      cached.position_stop[2] = BSH.get_position_stop().z();
+      cached.time = BSH.get_time_start();
+    }
+  return;
+}
+
+void event_cache_writer::concatenate(const std::vector<std::string> & input_filenames_,
+				     const std::string & output_filename_)
+{
+  DT_THROW_IF(input_filenames_.empty(), std::logic_error, "No event cache to concatenate in '" << output_filename_ << "' !");
+  event_cache_writer writer;
+  event_cache_reader reader;
+  for (std::size_t ifile = 0; ifile < input_filenames_.size(); ifile++)
+    {
+      reader.open(input_filenames_[ifile]);
+      const event_cache_header & header = reader.get_header();
+      if (ifile == 0) writer.initialize(output_filename_, header.calo_type, header.geiger_type, header.geiger_dead_time);
+      const double dead_time = writer._header_.geiger_dead_time;
+      const bool same_dead_time = std::isnan(dead_time) ? std::isnan(header.geiger_dead_time) : header.geiger_dead_time == dead_time;
+      DT_THROW_IF(header.calo_type != writer._header_.calo_type
+		  || header.geiger_type != writer._header_.geiger_type
+		  || !same_dead_time,
+		  std::logic_error,
+		  "Event cache '" << input_filenames_[ifile] << "' has other hit types or Geiger dead time than '"
+		  << input_filenames_[0] << "' !");
+
+      // The records follow the header in the mapped file, they are copied as a whole :
+      const char * records = reinterpret_cast<const char *>(&header) + sizeof(event_cache_header);
+      DT_THROW_IF(std::fwrite(records, 1, header.data_size, writer._file_) != header.data_size,
+		  std::runtime_error, "Cannot write event cache file '" << output_filename_ << "' !");
+      writer._header_.number_of_events += header.number_of_events;
+      writer._header_.data_size += header.data_size;
+      reader.close();
+    }
+  writer.terminate();
+  return;
+}
+
+event_cache_writer::event_cache_writer()
+{
+  std::memset(&_header_, 0, sizeof(_header_));
+}
+
+event_cache_writer::~event_cache_writer()
+{
+  if (is_initialized()) terminate();
+}
+
+bool event_cache_writer::is_initialized() const
+{
+  return _file_ != nullptr;
+}
+
+void event_cache_writer::initialize(const std::string & filename_,
+				    uint32_t calo_type_,
+				    uint32_t geiger_type_,
+				    double geiger_dead_time_)
+{
+  DT_THROW_IF(is_initialized(), std::logic_error, "Event cache writer is already initialized !");
+  _filename_ = filename_;
+  _file_ = std::fopen(_filename_.c_str(), "wb");
+  DT_THROW_IF(_file_ == nullptr, std::runtime_error, "Cannot create event cache file '" << _filename_ << "' !");
+
+  std::memset(&_header_, 0, sizeof(_header_));
+  std::memcpy(_header_.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  _header_.version = CACHE_VERSION;
+  _header_.byte_order = BYTE_ORDER_MARK;
+  _header_.calo_type = calo_type_;
+  _header_.geiger_type = geiger_type_;
+  _header_.geiger_dead_time = geiger_dead_time_;
+
+  // The header is written again with the counts at the end :
+  DT_THROW_IF(std::fwrite(&_header_, sizeof(_header_), 1, _file_) != 1,
+	      std::runtime_error, "Cannot write event cache file '" << _filename_ << "' !");
+  return;
+}
+
+void event_cache_writer::write(const std::vector<char> & record_)
+{
+  DT_THROW_IF(!is_initialized(), std::logic_error, "Event cache writer is not initialized !");
+  DT_THROW_IF(std::fwrite(record_.data(), 1, record_.size(), _file_) != record_.size(),
+	      std::runtime_error, "Cannot write event cache file '" << _filename_ << "' !");
+  _header_.number_of_events++;
+  _header_.data_size += record_.size();
+  return;
+}
+
+void event_cache_writer::terminate()
+{
+  if (!is_initialized()) return;
+  const bool header_ok = std::fseek(_file_, 0, SEEK_SET) == 0
+    && std::fwrite(&_header_, sizeof(_header_), 1, _file_) == 1;
+  const bool close_ok = std::fclose(_file_) == 0;
+  _file_ = nullptr;
+  DT_THROW_IF(!header_ok || !close_ok, std::runtime_error, "Cannot finalize event cache file '" << _filename_ << "' !");
+  return;
+}
+
+std::size_t event_cache_writer::get_number_of_events() const
+{
+  return _header_.number_of_events;
+}
+
+event_cache_reader::event_cache_reader()
+{
+}
+
+event_cache_reader::~event_cache_reader()
+{
+  close();
+}
+
+void event_cache_reader::open(const std::string & filename_)
+{
+  close();
+  _filename_ = filename_;
+  const int fd = ::open(_filename_.c_str(), O_RDONLY);
+  DT_THROW_IF(fd < 0, std::runtime_error, "Cannot open event cache file '" << _filename_ << "' !");
+  struct stat file_stat;
+  if (::fstat(fd, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(sizeof(event_cache_header))) {
+    ::close(fd);
+    DT_THROW(std::runtime_error, "File '" << _filename_ << "' is too short for an event cache !");
+  }
+  void * data = ::mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  DT_THROW_IF(data == MAP_FAILED, std::runtime_error, "Cannot map event cache file '" << _filename_ << "' !");
+  ::madvise(data, file_stat.st_size, MADV_SEQUENTIAL);
+  _data_ = static_cast<const char *>(data);
+  _size_ = file_stat.st_size;
+
+  const event_cache_header & header = get_header();
+  const bool valid = std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0
+    && header.version == CACHE_VERSION
+    && header.byte_order == BYTE_ORDER_MARK
+    && header.data_size == _size_ - sizeof(event_cache_header);
+  if (!valid) {
+    close();
+    DT_THROW(std::logic_error, "File '" << filename_ << "' is not a complete event cache (version " << CACHE_VERSION << ") !");
+  }
+  rewind();
+  return;
+}
+
+bool event_cache_reader::is_open() const
+{
+  return _data_ != nullptr;
+}
+
+void event_cache_reader::close()
+{
+  if (_data_ != nullptr) {
+    ::munmap(const_cast<char *>(_data_), _size_);
+    _data_ = nullptr;
+  }
+  _size_ = 0;
+  _offset_ = 0;
+  return;
+}
+
+const event_cache_header & event_cache_reader::get_header() const
+{
+  DT_THROW_IF(!is_open(), std::logic_error, "Event cache is not open !");
+  return *reinterpret_cast<const event_cache_header *>(_data_);
+}
+
+void event_cache_reader::rewind()
+{
+  _offset_ = sizeof(event_cache_header);
+  return;
+}
+
+bool event_cache_reader::next(event_cache_event_view & event_)
+{
+  if (!is_open() || _offset_ >= _size_) return false;
+  DT_THROW_IF(_size_ - _offset_ < sizeof(event_cache_event), std::runtime_error,
+	      "Truncated event record in event cache '" << _filename_ << "' !");
+  const event_cache_event & counts = *reinterpret_cast<const event_cache_event *>(_data_ + _offset_);
+  const std::size_t record_size = sizeof(event_cache_event)
+    + counts.number_of_calo_hits * sizeof(event_cache_calo_hit)
+    + counts.number_of_geiger_hits * sizeof(event_cache_geiger_hit);
+  DT_THROW_IF(_size_ - _offset_ < record_size, std::runtime_error,
+	      "Truncated event record in event cache '" << _filename_ << "' !");
+
+  const char * hits = _data_ + _offset_ + sizeof(event_cache_event);
+  event_.calo_type = get_header().calo_type;
+  event_.geiger_type = get_header().geiger_type;
+  event_.number_of_calo_hits = counts.number_of_calo_hits;
+  event_.calo_hits = reinterpret_cast<const event_cache_calo_hit *>(hits);
+  event_.number_of_geiger_hits = counts.number_of_geiger_hits;
+  event_.geiger_hits = reinterpret_cast<const event_cache_geiger_hit *>(hits + counts.number_of_calo_hits * sizeof(event_cache_calo_hit));
+  _offset_ += record_size;
+  return true;
+}
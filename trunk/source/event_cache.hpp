@@ -0,0 +1,164 @@
+//! \file event_cache.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Binary cache of the reduced events : calo hits merged by OM and
+// Geiger cell fires, before the threshold and selector cuts.
+// The cache is read back through mmap without any copy.
+//
+
+#ifndef EVENT_CACHE_HPP
+#define EVENT_CACHE_HPP
+
+// Standard library:
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Third party:
+// - Bayeux/mctools:
+#include <mctools/simulated_data.h>
+
+struct event_analyzer;
+
+/// Header at the beginning of an event cache file
+struct event_cache_header
+{
+  char magic[8];                ///< "HCEVTCAC"
+  uint32_t version;
+  uint32_t byte_order;          ///< BYTE_ORDER_MARK as written by the producer
+  uint64_t number_of_events;
+  uint64_t data_size;           ///< Bytes of event records after the header
+  uint32_t calo_type;           ///< Geom type of the calo hits
+  uint32_t geiger_type;         ///< Geom type of the Geiger hits
+  double geiger_dead_time;      ///< Dead time applied to the Geiger fires (NaN : one fire per cell)
+};
+
+/// Event record : counts, followed by the calo hits and the Geiger hits
+struct event_cache_event
+{
+  uint32_t number_of_calo_hits;
+  uint32_t number_of_geiger_hits;
+};
+
+/// Calo hit merged by OM, before threshold and selector
+struct event_cache_calo_hit
+{
+  uint16_t om_index;            ///< calo_hit_accumulator::om_index
+  uint16_t part;                ///< Calorimeter block part of the first step hit
+  float left_most_position[3];
+  double energy;
+  double time;
+};
+
+/// Geiger cell fire, before selector
+struct event_cache_geiger_hit
+{
+  uint32_t cell_index;          ///< geiger_cell_table::cell_index
+  float position_stop[3];
+  double time;
+};
+
+/// Event read from a cache, pointing into the mapped file
+struct event_cache_event_view
+{
+  uint32_t calo_type = 0;
+  uint32_t geiger_type = 0;
+  std::size_t number_of_calo_hits = 0;
+  const event_cache_calo_hit * calo_hits = nullptr;
+  std::size_t number_of_geiger_hits = 0;
+  const event_cache_geiger_hit * geiger_hits = nullptr;
+};
+
+//! \brief Writer of an event cache file
+class event_cache_writer
+{
+public :
+
+  /// Encode the raw hits of an analyzed event in a record
+  static void encode(const event_analyzer & analyzer_,
+		     const mctools::simulated_data & SD_,
+		     std::vector<char> & record_);
+
+  /// Write the events of cache files with the same hit types and dead time one after the other
+  static void concatenate(const std::vector<std::string> & input_filenames_,
+			  const std::string & output_filename_);
+
+  /// Default constructor
+  event_cache_writer();
+
+  /// Destructor
+  ~event_cache_writer();
+
+  /// Create the cache file
+  void initialize(const std::string & filename_,
+		  uint32_t calo_type_,
+		  uint32_t geiger_type_,
+		  double geiger_dead_time_);
+
+  /// Check initialization
+  bool is_initialized() const;
+
+  /// Append an encoded event record
+  void write(const std::vector<char> & record_);
+
+  /// Write the final header and close the file
+  void terminate();
+
+  /// Return the number of events written
+  std::size_t get_number_of_events() const;
+
+private :
+
+  std::string _filename_;
+  std::FILE * _file_ = nullptr;
+  event_cache_header _header_;
+
+};
+
+//! \brief Reader of an event cache file
+class event_cache_reader
+{
+public :
+
+  /// Default constructor
+  event_cache_reader();
+
+  /// Destructor
+  ~event_cache_reader();
+
+  /// Map a cache file and check its header
+  void open(const std::string & filename_);
+
+  /// Check if a file is mapped
+  bool is_open() const;
+
+  /// Unmap the file
+  void close();
+
+  /// Return the header
+  const event_cache_header & get_header() const;
+
+  /// Go back to the first event
+  void rewind();
+
+  /// Point to the next event, return false at the end of the file
+  bool next(event_cache_event_view & event_);
+
+private :
+
+  std::string _filename_;
+  const char * _data_ = nullptr;
+  std::size_t _size_ = 0;
+  std::size_t _offset_ = 0;
+
+};
+
+#endif // EVENT_CACHE_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
@@ -0,0 +1,136 @@
+//! \file event_index.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+
+// Ourselves:
+#include <event_index.hpp>
+
+namespace {
+  const std::string & index_format_tag()
+  {
+    static const std::string _tag("#@hc_event_index");
+    return _tag;
+  }
+  const int INDEX_FORMAT_VERSION = 1;
+}
+
+void event_index::clear()
+{
+  filenames.clear();
+  selector_names.clear();
+  entries.clear();
+  return;
+}
+
+uint32_t event_index::add_file(const std::string & filename_)
+{
+  filenames.push_back(filename_);
+  return filenames.size() - 1;
+}
+
+std::size_t event_index::add_selector(const std::string & name_)
+{
+  DT_THROW_IF(selector_names.size() >= MAX_NUMBER_OF_SELECTORS, std::logic_error,
+	      "Too many selectors in the event index (max " << MAX_NUMBER_OF_SELECTORS << ") !");
+  DT_THROW_IF(name_.empty() || name_.find_first_of(" \t") != std::string::npos, std::logic_error,
+	      "Invalid selector name '" << name_ << "' !");
+  selector_names.push_back(name_);
+  return selector_names.size() - 1;
+}
+
+std::size_t event_index::get_selector_bit(const std::string & name_) const
+{
+  for (std::size_t ibit = 0; ibit < selector_names.size(); ibit++) {
+    if (selector_names[ibit] == name_) return ibit;
+  }
+  DT_THROW(std::logic_error, "No selector '" << name_ << "' in the event index !");
+}
+
+void event_index::add_entry(uint32_t file_index_, uint64_t record_number_, uint64_t selector_mask_)
+{
+  event_index_entry entry;
+  entry.file_index = file_index_;
+  entry.record_number = record_number_;
+  entry.selector_mask = selector_mask_;
+  entries.push_back(entry);
+  return;
+}
+
+void event_index::store(const std::string & filename_) const
+{
+  std::ofstream out(filename_.c_str());
+  DT_THROW_IF(!out, std::runtime_error, "Cannot open event index file '" << filename_ << "' !");
+  out << index_format_tag() << ' ' << INDEX_FORMAT_VERSION << '\n';
+  for (std::size_t ifile = 0; ifile < filenames.size(); ifile++) {
+    out << "file " << ifile << ' ' << filenames[ifile] << '\n';
+  }
+  for (std::size_t ibit = 0; ibit < selector_names.size(); ibit++) {
+    out << "selector " << ibit << ' ' << selector_names[ibit] << '\n';
+  }
+  for (std::size_t ientry = 0; ientry < entries.size(); ientry++) {
+    const event_index_entry & entry = entries[ientry];
+    out << entry.file_index << ' ' << entry.record_number << ' ' << entry.selector_mask << '\n';
+  }
+  DT_THROW_IF(!out, std::runtime_error, "Error while writing event index file '" << filename_ << "' !");
+  return;
+}
+
+void event_index::load(const std::string & filename_)
+{
+  clear();
+  std::ifstream in(filename_.c_str());
+  DT_THROW_IF(!in, std::runtime_error, "Cannot open event index file '" << filename_ << "' !");
+
+  std::string line;
+  std::getline(in, line);
+  std::istringstream header(line);
+  std::string tag;
+  int version = 0;
+  header >> tag >> version;
+  DT_THROW_IF(tag != index_format_tag() || version != INDEX_FORMAT_VERSION, std::logic_error,
+	      "File '" << filename_ << "' is not an event index (version " << INDEX_FORMAT_VERSION << ") !");
+
+  std::size_t line_number = 1;
+  while (std::getline(in, line)) {
+    line_number++;
+    if (line.empty()) continue;
+    std::istringstream line_in(line);
+    if (line.compare(0, 5, "file ") == 0) {
+      std::string keyword;
+      std::size_t ifile = 0;
+      line_in >> keyword >> ifile >> std::ws;
+      std::string filename;
+      std::getline(line_in, filename);
+      DT_THROW_IF(ifile != filenames.size() || filename.empty(), std::logic_error,
+		  "Invalid file line " << line_number << " in event index '" << filename_ << "' !");
+      add_file(filename);
+    }
+    else if (line.compare(0, 9, "selector ") == 0) {
+      std::string keyword;
+      std::size_t ibit = 0;
+      std::string name;
+      line_in >> keyword >> ibit >> name;
+      DT_THROW_IF(ibit != selector_names.size(), std::logic_error,
+		  "Invalid selector line " << line_number << " in event index '" << filename_ << "' !");
+      add_selector(name);
+    }
+    else {
+      event_index_entry entry;
+      line_in >> entry.file_index >> entry.record_number >> entry.selector_mask;
+      DT_THROW_IF(!line_in || entry.file_index >= filenames.size(), std::logic_error,
+		  "Invalid entry line " << line_number << " in event index '" << filename_ << "' !");
+      entries.push_back(entry);
+    }
+  }
+  return;
+}
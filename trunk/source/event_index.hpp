@@ -0,0 +1,74 @@
+//! \file event_index.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Skim list of accepted events : source file, record number in the
+// file and the selectors matched by the event
+//
+
+#ifndef EVENT_INDEX_HPP
+#define EVENT_INDEX_HPP
+
+// Standard library:
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// One accepted event
+struct event_index_entry
+{
+  uint32_t file_index = 0;    ///< Index in the list of source files
+  uint64_t record_number = 0; ///< Record number in the source file (from 0)
+  uint64_t selector_mask = 0; ///< Bit i is set if the selector i matched
+};
+
+//! \brief Compact index of accepted events
+//
+// ASCII format, one line per entry :
+//
+//   #@hc_event_index 1
+//   file 0 /path/to/simu_0.brio
+//   selector 0 output_sorted
+//   selector 1 output_sorted_with_geiger
+//   0 12 3
+//   0 57 1
+//
+struct event_index
+{
+  /// Maximum number of selectors
+  static const std::size_t MAX_NUMBER_OF_SELECTORS = 64;
+
+  /// Clear the index
+  void clear();
+
+  /// Add a source file, return its index
+  uint32_t add_file(const std::string & filename_);
+
+  /// Add a selector, return its bit
+  std::size_t add_selector(const std::string & name_);
+
+  /// Return the bit of a selector, throw if it does not exist
+  std::size_t get_selector_bit(const std::string & name_) const;
+
+  /// Add an entry
+  void add_entry(uint32_t file_index_, uint64_t record_number_, uint64_t selector_mask_);
+
+  /// Write the index in an ASCII file
+  void store(const std::string & filename_) const;
+
+  /// Read the index from an ASCII file
+  void load(const std::string & filename_);
+
+  std::vector<std::string> filenames;
+  std::vector<std::string> selector_names;
+  std::vector<event_index_entry> entries;
+
+};
+
+#endif // EVENT_INDEX_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
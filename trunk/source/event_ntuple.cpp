@@ -0,0 +1,259 @@
+//! \file event_ntuple.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <algorithm>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+
+// Root :
+#include "TChain.h"
+
+// Ourselves:
+#include <event_ntuple.hpp>
+
+namespace {
+  template <class T>
+  void copy_array(const std::vector<T> & from_, std::vector<T> & to_)
+  {
+    std::copy(from_.begin(), from_.end(), to_.begin());
+    return;
+  }
+}
+
+void event_ntuple_row::clear()
+{
+  calo_total_energy = 0;
+  is_calo = false;
+  is_tracker = false;
+  full_track = false;
+  calo_side.clear();
+  calo_column.clear();
+  calo_row.clear();
+  calo_energy.clear();
+  calo_time.clear();
+  calo_left_most_x.clear();
+  gg_side.clear();
+  gg_layer.clear();
+  gg_row.clear();
+  gg_time.clear();
+  gg_stop_x.clear();
+  gg_stop_y.clear();
+  gg_stop_z.clear();
+  return;
+}
+
+void event_ntuple_row::set(const event_analyzer & analyzer_)
+{
+  clear();
+  calo_total_energy = analyzer_.calo_total_energy * 1000;
+  is_calo = analyzer_.is_calo;
+  is_tracker = analyzer_.is_tracker;
+  full_track = analyzer_.full_track_event;
+
+  for (std::size_t ihit = 0; ihit < analyzer_.calo_hits.size(); ihit++)
+    {
+      const calo_hit_summary & calo_hit = analyzer_.calo_hits[ihit];
+      calo_side.push_back(calo_hit.geom_id.get(1));
+      calo_column.push_back(calo_hit.geom_id.get(2));
+      calo_row.push_back(calo_hit.geom_id.get(3));
+      calo_energy.push_back(calo_hit.energy * 1000);
+      calo_time.push_back(calo_hit.time);
+      calo_left_most_x.push_back(calo_hit.left_most_hit_position.x());
+    }
+
+  for (std::size_t ihit = 0; ihit < analyzer_.geiger_hits.size(); ihit++)
+    {
+      const geiger_hit_summary & geiger_hit = analyzer_.geiger_hits[ihit];
+      gg_side.push_back(geiger_hit.geom_id.get(1));
+      gg_layer.push_back(geiger_hit.geom_id.get(2));
+      gg_row.push_back(geiger_hit.geom_id.get(3));
+      gg_time.push_back(geiger_hit.time);
+      gg_stop_x.push_back(geiger_hit.position_stop.x());
+      gg_stop_y.push_back(geiger_hit.position_stop.y());
+      gg_stop_z.push_back(geiger_hit.position_stop.z());
+    }
+  return;
+}
+
+const std::string & event_ntuple_writer::tree_name()
+{
+  static const std::string _name("hc_events");
+  return _name;
+}
+
+event_ntuple_writer::event_ntuple_writer()
+{
+}
+
+event_ntuple_writer::~event_ntuple_writer()
+{
+  if (is_initialized()) terminate();
+}
+
+bool event_ntuple_writer::is_initialized() const
+{
+  return _tree_ != nullptr;
+}
+
+void event_ntuple_writer::concatenate(const std::vector<std::string> & input_filenames_,
+				      const std::string & output_filename_)
+{
+  TChain chain(tree_name().c_str());
+  for (std::size_t ifile = 0; ifile < input_filenames_.size(); ifile++) {
+    DT_THROW_IF(chain.Add(input_filenames_[ifile].c_str(), 0) == 0, std::runtime_error,
+		"No '" << tree_name() << "' tree in ntuple file '" << input_filenames_[ifile] << "' !");
+  }
+
+  TDirectory * current_directory = gDirectory;
+  std::unique_ptr<TFile> file(new TFile(output_filename_.c_str(), "RECREATE", "Half commissioning event ntuple", COMPRESSION_SETTINGS));
+  DT_THROW_IF(file->IsZombie(), std::runtime_error, "Cannot create ntuple file '" << output_filename_ << "' !");
+  file->cd();
+
+  // The baskets are copied without being uncompressed, the tree is owned by the file :
+  TTree * tree = chain.CloneTree(-1, "fast");
+  DT_THROW_IF(tree == nullptr, std::runtime_error, "Cannot copy the ntuples in '" << output_filename_ << "' !");
+  tree->Write("", TObject::kOverwrite);
+  file->Close();
+
+  if (current_directory != nullptr) current_directory->cd();
+  return;
+}
+
+void event_ntuple_writer::initialize(const std::string & filename_)
+{
+  DT_THROW_IF(is_initialized(), std::logic_error, "Event ntuple is already initialized !");
+
+  // Histograms booked later must stay in the current directory :
+  TDirectory * current_directory = gDirectory;
+  _file_.reset(new TFile(filename_.c_str(), "RECREATE", "Half commissioning event ntuple", COMPRESSION_SETTINGS));
+  DT_THROW_IF(_file_->IsZombie(), std::runtime_error, "Cannot create ntuple file '" << filename_ << "' !");
+  _file_->cd();
+
+  _tree_ = new TTree(tree_name().c_str(), "Half commissioning analyzed events");
+  _tree_->SetAutoFlush(-AUTO_FLUSH_BYTES);
+  _tree_->Branch("event_id", &_event_id_, "event_id/l", BASKET_SIZE);
+  _tree_->Branch("calo_total_energy", &_calo_total_energy_, "calo_total_energy/F", BASKET_SIZE);
+  _tree_->Branch("is_calo", &_is_calo_, "is_calo/O", BASKET_SIZE);
+  _tree_->Branch("is_tracker", &_is_tracker_, "is_tracker/O", BASKET_SIZE);
+  _tree_->Branch("full_track", &_full_track_, "full_track/O", BASKET_SIZE);
+  _tree_->Branch("calo_n", &_calo_n_, "calo_n/I", BASKET_SIZE);
+  _tree_->Branch("gg_n", &_gg_n_, "gg_n/I", BASKET_SIZE);
+
+  _buffer_.clear();
+  _reserve_(calo_hit_accumulator::NUMBER_OF_OMS, hc_constants::NUMBER_OF_GEIGER_CELLS);
+  _book_array_branches_();
+  _number_of_entries_ = 0;
+
+  if (current_directory != nullptr) current_directory->cd();
+  return;
+}
+
+void event_ntuple_writer::fill(uint64_t event_id_, const event_ntuple_row & row_)
+{
+  DT_THROW_IF(!is_initialized(), std::logic_error, "Event ntuple is not initialized !");
+  const std::size_t number_of_calo_hits = row_.calo_energy.size();
+  const std::size_t number_of_geiger_hits = row_.gg_time.size();
+  if (number_of_calo_hits > _buffer_.calo_energy.size()
+      || number_of_geiger_hits > _buffer_.gg_time.size())
+    {
+      // Arrays are moved, branches have to follow :
+      _reserve_(number_of_calo_hits, number_of_geiger_hits);
+      _book_array_branches_();
+    }
+
+  _event_id_ = event_id_;
+  _calo_total_energy_ = row_.calo_total_energy;
+  _is_calo_ = row_.is_calo;
+  _is_tracker_ = row_.is_tracker;
+  _full_track_ = row_.full_track;
+
+  _calo_n_ = number_of_calo_hits;
+  copy_array(row_.calo_side, _buffer_.calo_side);
+  copy_array(row_.calo_column, _buffer_.calo_column);
+  copy_array(row_.calo_row, _buffer_.calo_row);
+  copy_array(row_.calo_energy, _buffer_.calo_energy);
+  copy_array(row_.calo_time, _buffer_.calo_time);
+  copy_array(row_.calo_left_most_x, _buffer_.calo_left_most_x);
+
+  _gg_n_ = number_of_geiger_hits;
+  copy_array(row_.gg_side, _buffer_.gg_side);
+  copy_array(row_.gg_layer, _buffer_.gg_layer);
+  copy_array(row_.gg_row, _buffer_.gg_row);
+  copy_array(row_.gg_time, _buffer_.gg_time);
+  copy_array(row_.gg_stop_x, _buffer_.gg_stop_x);
+  copy_array(row_.gg_stop_y, _buffer_.gg_stop_y);
+  copy_array(row_.gg_stop_z, _buffer_.gg_stop_z);
+
+  _tree_->Fill();
+  _number_of_entries_++;
+  return;
+}
+
+void event_ntuple_writer::terminate()
+{
+  if (!is_initialized()) return;
+  _tree_->Write("", TObject::kOverwrite);
+  _file_->Close();
+  _file_.reset();
+  _tree_ = nullptr;
+  return;
+}
+
+std::size_t event_ntuple_writer::get_number_of_entries() const
+{
+  return _number_of_entries_;
+}
+
+void event_ntuple_writer::_book_array_branches_()
+{
+  // Arrays are booked once, then only their address is updated :
+  const bool book = _tree_->GetBranch("calo_side") == nullptr;
+  auto address = [&] (const char * name_, void * data_, const char * leaflist_)
+    {
+      if (book) _tree_->Branch(name_, data_, leaflist_, BASKET_SIZE);
+      else _tree_->SetBranchAddress(name_, data_);
+    };
+  address("calo_side", _buffer_.calo_side.data(), "calo_side[calo_n]/b");
+  address("calo_column", _buffer_.calo_column.data(), "calo_column[calo_n]/b");
+  address("calo_row", _buffer_.calo_row.data(), "calo_row[calo_n]/b");
+  address("calo_energy", _buffer_.calo_energy.data(), "calo_energy[calo_n]/F");
+  address("calo_time", _buffer_.calo_time.data(), "calo_time[calo_n]/F");
+  address("calo_left_most_x", _buffer_.calo_left_most_x.data(), "calo_left_most_x[calo_n]/F");
+  address("gg_side", _buffer_.gg_side.data(), "gg_side[gg_n]/b");
+  address("gg_layer", _buffer_.gg_layer.data(), "gg_layer[gg_n]/b");
+  address("gg_row", _buffer_.gg_row.data(), "gg_row[gg_n]/b");
+  address("gg_time", _buffer_.gg_time.data(), "gg_time[gg_n]/F");
+  address("gg_stop_x", _buffer_.gg_stop_x.data(), "gg_stop_x[gg_n]/F");
+  address("gg_stop_y", _buffer_.gg_stop_y.data(), "gg_stop_y[gg_n]/F");
+  address("gg_stop_z", _buffer_.gg_stop_z.data(), "gg_stop_z[gg_n]/F");
+  return;
+}
+
+void event_ntuple_writer::_reserve_(std::size_t number_of_calo_hits_, std::size_t number_of_geiger_hits_)
+{
+  const std::size_t calo_size = std::max(number_of_calo_hits_, _buffer_.calo_energy.size());
+  _buffer_.calo_side.resize(calo_size);
+  _buffer_.calo_column.resize(calo_size);
+  _buffer_.calo_row.resize(calo_size);
+  _buffer_.calo_energy.resize(calo_size);
+  _buffer_.calo_time.resize(calo_size);
+  _buffer_.calo_left_most_x.resize(calo_size);
+
+  // Several fires of the same cell with a dead time, keep some margin :
+  std::size_t geiger_size = _buffer_.gg_time.size();
+  if (number_of_geiger_hits_ > geiger_size) geiger_size = std::max(number_of_geiger_hits_, 2 * geiger_size);
+  _buffer_.gg_side.resize(geiger_size);
+  _buffer_.gg_layer.resize(geiger_size);
+  _buffer_.gg_row.resize(geiger_size);
+  _buffer_.gg_time.resize(geiger_size);
+  _buffer_.gg_stop_x.resize(geiger_size);
+  _buffer_.gg_stop_y.resize(geiger_size);
+  _buffer_.gg_stop_z.resize(geiger_size);
+  return;
+}
@@ -0,0 +1,134 @@
+//! \file event_ntuple.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Flat ntuple of the analyzed events : one TTree entry per event,
+// one variable length array per calo hit and Geiger cell quantity
+//
+
+#ifndef EVENT_NTUPLE_HPP
+#define EVENT_NTUPLE_HPP
+
+// Standard library:
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Root :
+#include "TFile.h"
+#include "TTree.h"
+
+// This project :
+#include "event_analyzer.hpp"
+
+/// Summary of one analyzed event, as written in the ntuple
+struct event_ntuple_row
+{
+  /// Reset the row
+  void clear();
+
+  /// Copy the products of an event analyzer
+  void set(const event_analyzer & analyzer_);
+
+  float calo_total_energy = 0; ///< keV
+  bool is_calo = false;
+  bool is_tracker = false;
+  bool full_track = false;
+
+  // Calo hits merged by OM, above threshold :
+  std::vector<uint8_t> calo_side;
+  std::vector<uint8_t> calo_column;
+  std::vector<uint8_t> calo_row;
+  std::vector<float> calo_energy;      ///< keV
+  std::vector<float> calo_time;        ///< ns
+  std::vector<float> calo_left_most_x; ///< mm
+
+  // Geiger cells fired, matching the selector rules :
+  std::vector<uint8_t> gg_side;
+  std::vector<uint8_t> gg_layer;
+  std::vector<uint8_t> gg_row;
+  std::vector<float> gg_time;   ///< ns
+  std::vector<float> gg_stop_x; ///< mm
+  std::vector<float> gg_stop_y; ///< mm
+  std::vector<float> gg_stop_z; ///< mm
+};
+
+//! \brief Writer of the flat event ntuple
+//
+// The tree has only basic type branches (leaf lists), so it can be read
+// back without Falaise nor dictionaries. Baskets are large and clusters
+// are flushed every few tens of MB to favour sequential reads of a few
+// columns over the whole file.
+class event_ntuple_writer
+{
+public :
+
+  /// Name of the tree
+  static const std::string & tree_name();
+
+  /// Compression settings of the ntuple file (LZ4, level 4)
+  static const int COMPRESSION_SETTINGS = 404;
+
+  /// Basket size of each branch in bytes
+  static const int BASKET_SIZE = 256000;
+
+  /// Bytes written between two flushes of the baskets (one cluster)
+  static const Long64_t AUTO_FLUSH_BYTES = 32000000;
+
+  /// Copy the trees of ntuple files one after the other in a new ntuple file
+  static void concatenate(const std::vector<std::string> & input_filenames_,
+			  const std::string & output_filename_);
+
+  /// Default constructor
+  event_ntuple_writer();
+
+  /// Destructor
+  ~event_ntuple_writer();
+
+  /// Open the ntuple file and book the tree
+  void initialize(const std::string & filename_);
+
+  /// Check initialization
+  bool is_initialized() const;
+
+  /// Add one event
+  void fill(uint64_t event_id_, const event_ntuple_row & row_);
+
+  /// Write the tree and close the ntuple file
+  void terminate();
+
+  /// Return the number of events written
+  std::size_t get_number_of_entries() const;
+
+private :
+
+  void _book_array_branches_();
+
+  void _reserve_(std::size_t number_of_calo_hits_, std::size_t number_of_geiger_hits_);
+
+private :
+
+  std::unique_ptr<TFile> _file_;
+  TTree * _tree_ = nullptr; ///< Owned by the file
+  std::size_t _number_of_entries_ = 0;
+
+  // Branch buffers, arrays are sized to their capacity :
+  ULong64_t _event_id_ = 0;
+  Float_t _calo_total_energy_ = 0;
+  Bool_t _is_calo_ = false;
+  Bool_t _is_tracker_ = false;
+  Bool_t _full_track_ = false;
+  Int_t _calo_n_ = 0;
+  Int_t _gg_n_ = 0;
+  event_ntuple_row _buffer_;
+
+};
+
+#endif // EVENT_NTUPLE_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
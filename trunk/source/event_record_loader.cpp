@@ -0,0 +1,61 @@
+//! \file event_record_loader.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/utils.h>
+
+// Ourselves:
+#include <event_record_loader.hpp>
+
+event_record_loader::event_record_loader(const std::vector<std::string> & filenames_,
+					 datatools::logger::priority logging_)
+  : _filenames_(filenames_),
+    _logging_(logging_)
+{
+}
+
+event_record_loader::~event_record_loader()
+{
+  _close_file_();
+}
+
+void event_record_loader::load(uint32_t file_index_, uint64_t record_number_, datatools::things & record_)
+{
+  DT_THROW_IF(file_index_ >= _filenames_.size(), std::logic_error,
+	      "Invalid file #" << file_index_ << " for " << _filenames_.size() << " input files !");
+  if (!_reader_ || file_index_ != _file_index_) {
+    _close_file_();
+    _open_file_(file_index_);
+  }
+  DT_THROW_IF(!_reader_->load_record(record_, record_number_),
+	      std::runtime_error,
+	      "Cannot load record #" << record_number_ << " from file '" << _filenames_[_file_index_] << "' !");
+  return;
+}
+
+void event_record_loader::_open_file_(uint32_t file_index_)
+{
+  _file_index_ = file_index_;
+  std::string filename = _filenames_[_file_index_];
+  datatools::fetch_path_with_env(filename);
+  DT_LOG_DEBUG(_logging_, "Opening input file '" << filename << "'");
+  _reader_.reset(new dpp::simple_brio_data_source(_logging_));
+  _reader_->set(filename);
+  _reader_->open();
+  return;
+}
+
+void event_record_loader::_close_file_()
+{
+  if (_reader_) {
+    if (_reader_->is_open()) _reader_->close();
+    _reader_.reset();
+  }
+  return;
+}
@@ -0,0 +1,66 @@
+//! \file event_record_loader.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Random access decoding of the event records of a list of brio files,
+// one loader per thread decoding records
+//
+
+#ifndef EVENT_RECORD_LOADER_HPP
+#define EVENT_RECORD_LOADER_HPP
+
+// Standard library:
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+#include <datatools/things.h>
+// - Bayeux/dpp:
+#include <dpp/simple_brio_data_source.h>
+
+//! \brief Decoder of the records at given positions
+//
+// The loader keeps its own brio reader on the file of the last record,
+// so the records handed out by an event_source in positions only mode
+// are deserialized in parallel by the worker threads, each with its
+// own loader. Records are cheaper to load in increasing order.
+class event_record_loader
+{
+public :
+
+  /// Constructor
+  event_record_loader(const std::vector<std::string> & filenames_,
+		      datatools::logger::priority logging_ = datatools::logger::PRIO_FATAL);
+
+  /// Destructor
+  ~event_record_loader();
+
+  /// Decode a record of a file in the given record
+  void load(uint32_t file_index_, uint64_t record_number_, datatools::things & record_);
+
+private :
+
+  void _open_file_(uint32_t file_index_);
+
+  void _close_file_();
+
+private :
+
+  std::vector<std::string> _filenames_;
+  datatools::logger::priority _logging_;
+  uint32_t _file_index_ = 0;
+  std::unique_ptr<dpp::simple_brio_data_source> _reader_;
+
+};
+
+#endif // EVENT_RECORD_LOADER_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
@@ -0,0 +1,59 @@
+//! \file event_sorter.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Ourselves:
+#include <event_sorter.hpp>
+
+void event_sorter::clear()
+{
+  match_rules_event = false;
+  match_rules_with_geiger = false;
+  return;
+}
+
+void event_sorter::process(const mctools::simulated_data & SD_)
+{
+  clear();
+
+  // Main calo hits :
+  if (calo_selector != nullptr && SD_.has_step_hits("calo"))
+    {
+      const mctools::simulated_data::hit_handle_collection_type & BSHC = SD_.get_step_hits("calo");
+      DT_LOG_DEBUG(logging, "BSCH calo step hits # = " << BSHC.size());
+
+      for (mctools::simulated_data::hit_handle_collection_type::const_iterator i = BSHC.begin();
+	   i != BSHC.end() && !match_rules_event;
+	   i++)
+	{
+	  // extract the corresponding geom ID:
+	  const geomtools::geom_id & main_calo_gid = i->get().get_geom_id();
+	  if (calo_selector->match(main_calo_gid)) match_rules_event = true;
+	} // end of for i BSHC
+
+    } // end of if has step hits "calo"
+
+  if (geiger_selector != nullptr && SD_.has_step_hits("gg"))
+    {
+      const mctools::simulated_data::hit_handle_collection_type & BSHC_gg = SD_.get_step_hits("gg");
+      DT_LOG_DEBUG(logging, "BSCH geiger step hits # = " << BSHC_gg.size());
+
+      for (mctools::simulated_data::hit_handle_collection_type::const_iterator i = BSHC_gg.begin();
+	   i != BSHC_gg.end() && !match_rules_with_geiger;
+	   i++)
+	{
+	  const mctools::base_step_hit & BSH = i->get();
+	  if (logging >= datatools::logger::PRIO_TRACE) BSH.tree_dump(std::clog, "A Geiger Base Step Hit : ", "INFO : ");
+	  const geomtools::geom_id & geiger_gid = BSH.get_geom_id();
+
+	  if (geiger_selector->match(geiger_gid))
+	    {
+	      match_rules_event = true;
+	      match_rules_with_geiger = true;
+	    }
+	} // end of i bsh
+    } // end of if has step hits "gg"
+
+  return;
+}
@@ -0,0 +1,47 @@
+//! \file event_sorter.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Half commissioning sorting rules : events have to touch
+// GG cells or OMs in given zones to be saved
+//
+
+#ifndef EVENT_SORTER_HPP
+#define EVENT_SORTER_HPP
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+// - Bayeux/mctools:
+#include <mctools/simulated_data.h>
+
+// This project :
+#include "compiled_id_selector.hpp"
+
+//! \brief Sorting rules decision for one simulated event
+struct event_sorter
+{
+  /// Reset the decision
+  void clear();
+
+  /// Apply the sorting rules on a SD bank
+  void process(const mctools::simulated_data & SD_);
+
+  // Configuration :
+  const compiled_id_selector * calo_selector = nullptr;
+  const compiled_id_selector * geiger_selector = nullptr;
+  datatools::logger::priority logging = datatools::logger::PRIO_FATAL;
+
+  // Decision :
+  bool match_rules_event = false;       ///< A calo or a GG cell match the rules
+  bool match_rules_with_geiger = false; ///< A GG cell match the rules
+
+};
+
+#endif // EVENT_SORTER_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
@@ -0,0 +1,448 @@
+//! \file event_source.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+// POSIX :
+#include <fcntl.h>
+#include <unistd.h>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/utils.h>
+#include <datatools/properties.h>
+
+// Root :
+#include "TROOT.h"
+
+// Ourselves:
+#include <event_source.hpp>
+
+event_source::event_source()
+{
+}
+
+event_source::~event_source()
+{
+  _stop_prefetch_();
+  _close_file_();
+}
+
+void event_source::set_prefetch(std::size_t capacity_,
+				std::size_t readahead_bytes_)
+{
+  DT_THROW_IF(is_prefetching(), std::logic_error, "Records are already prefetched !");
+  _prefetch_capacity_ = capacity_;
+  _readahead_bytes_ = readahead_bytes_;
+  return;
+}
+
+bool event_source::is_prefetching() const
+{
+  return _prefetched_records_ != nullptr;
+}
+
+void event_source::set_record_range(uint64_t first_record_, uint64_t last_record_)
+{
+  DT_THROW_IF(last_record_ != 0 && last_record_ <= first_record_, std::logic_error,
+	      "Invalid record range [" << first_record_ << ", " << last_record_ << ") !");
+  _first_record_ = first_record_;
+  _last_record_ = last_record_;
+  _shard_ = 0;
+  _number_of_shards_ = 0;
+  return;
+}
+
+void event_source::set_shard(uint32_t shard_, uint32_t number_of_shards_)
+{
+  DT_THROW_IF(number_of_shards_ == 0 || shard_ >= number_of_shards_, std::logic_error,
+	      "Invalid shard " << shard_ << "/" << number_of_shards_ << " !");
+  _shard_ = shard_;
+  _number_of_shards_ = number_of_shards_;
+  _first_record_ = 0;
+  _last_record_ = 0;
+  return;
+}
+
+bool event_source::is_ranged() const
+{
+  return _number_of_shards_ > 0 || _first_record_ > 0 || _last_record_ > 0;
+}
+
+void event_source::set_positions_only(bool positions_only_)
+{
+  DT_THROW_IF(is_prefetching(), std::logic_error, "Records are already prefetched !");
+  _positions_only_ = positions_only_;
+  return;
+}
+
+bool event_source::is_positions_only() const
+{
+  return _positions_only_;
+}
+
+void event_source::set_start_position(uint32_t file_index_, uint64_t record_number_)
+{
+  _start_file_index_ = file_index_;
+  _start_record_number_ = record_number_;
+  return;
+}
+
+std::string event_source::get_range_tag() const
+{
+  std::ostringstream tag;
+  if (_number_of_shards_ > 0) tag << "shard_" << _shard_ << "_of_" << _number_of_shards_ << '_';
+  else if (is_ranged()) {
+    tag << "records_" << _first_record_ << '_';
+    if (_last_record_ > 0) tag << _last_record_ << '_';
+    else tag << "end_";
+  }
+  return tag.str();
+}
+
+void event_source::parse_shard(const std::string & token_,
+			       uint32_t & shard_,
+			       uint32_t & number_of_shards_)
+{
+  std::istringstream token_in(token_);
+  char separator = 0;
+  token_in >> shard_ >> separator >> number_of_shards_;
+  DT_THROW_IF(!token_in || !token_in.eof() || separator != '/' || number_of_shards_ == 0 || shard_ >= number_of_shards_,
+	      std::logic_error, "Invalid shard '" << token_ << "', expected 'k/N' with 0 <= k < N !");
+  return;
+}
+
+void event_source::set_logging(datatools::logger::priority logging_)
+{
+  _logging_ = logging_;
+  return;
+}
+
+void event_source::initialize(const std::vector<std::string> & filenames_,
+			      std::size_t max_records_per_file_)
+{
+  DT_THROW_IF(filenames_.empty(), std::logic_error, "No input file(s) ! ");
+  _stop_prefetch_();
+  _close_file_();
+  _filenames_ = filenames_;
+  _max_records_per_file_ = max_records_per_file_;
+  _indexed_ = false;
+  _entries_.clear();
+  _next_entry_ = 0;
+  DT_THROW_IF(_start_file_index_ >= _filenames_.size(), std::logic_error,
+	      "Invalid start file #" << _start_file_index_ << " for " << _filenames_.size() << " input files !");
+  _file_index_ = _start_file_index_;
+
+  // The first file is opened now to get the metadata :
+  if (_is_random_access_()) _load_metadata_(_filenames_[0]);
+  _open_file_(_file_index_);
+  if (!_is_random_access_()) _metadata_store_ = _reader_->get_metadata_store();
+  if (_prefetch_capacity_ > 0 && !_positions_only_) _start_prefetch_();
+  return;
+}
+
+void event_source::initialize(const event_index & index_,
+			      uint64_t selector_mask_)
+{
+  DT_THROW_IF(index_.filenames.empty(), std::logic_error, "No input file(s) in the event index ! ");
+  DT_THROW_IF(is_ranged(), std::logic_error, "Record ranges and shards are not used with an event index !");
+  _stop_prefetch_();
+  _close_file_();
+  _filenames_ = index_.filenames;
+  _max_records_per_file_ = 0;
+  _indexed_ = true;
+  _entries_.clear();
+  for (std::size_t ientry = 0; ientry < index_.entries.size(); ientry++) {
+    const event_index_entry & entry = index_.entries[ientry];
+    if (selector_mask_ == 0 || (entry.selector_mask & selector_mask_)) _entries_.push_back(entry);
+  }
+  // Read the files one after the other, records in increasing order :
+  std::stable_sort(_entries_.begin(), _entries_.end(),
+		   [] (const event_index_entry & a_, const event_index_entry & b_) {
+		     if (a_.file_index != b_.file_index) return a_.file_index < b_.file_index;
+		     return a_.record_number < b_.record_number;
+		   });
+  // Entries before the start position are skipped :
+  _next_entry_ = 0;
+  while (_next_entry_ < _entries_.size()
+	 && (_entries_[_next_entry_].file_index < _start_file_index_
+	     || (_entries_[_next_entry_].file_index == _start_file_index_
+		 && _entries_[_next_entry_].record_number < _start_record_number_))) _next_entry_++;
+  _file_index_ = _entries_.empty() ? 0 : _entries_.front().file_index;
+
+  _load_metadata_(_filenames_[_file_index_]);
+
+  DT_LOG_INFORMATION(_logging_, "Event index : " << _entries_.size() << " / " << index_.entries.size() << " selected records");
+  if (_prefetch_capacity_ > 0 && !_positions_only_) _start_prefetch_();
+  return;
+}
+
+bool event_source::read(datatools::things & record_)
+{
+  DT_THROW_IF(_positions_only_, std::logic_error, "Only the positions of the records are read !");
+  DT_THROW_IF(is_prefetching(), std::logic_error, "Prefetched records are only exchanged, not copied !");
+  return _read_next_(record_, _record_file_index_, _record_number_);
+}
+
+bool event_source::read(std::unique_ptr<datatools::things> & record_)
+{
+  DT_THROW_IF(_positions_only_, std::logic_error, "Only the positions of the records are read !");
+  if (!is_prefetching()) return _read_next_(*record_, _record_file_index_, _record_number_);
+
+  _prefetched_record_ a_prefetched;
+  if (!_prefetched_records_->pop(a_prefetched)) {
+    std::lock_guard<std::mutex> lock(_prefetch_error_mutex_);
+    if (_prefetch_error_) std::rethrow_exception(_prefetch_error_);
+    return false;
+  }
+  // The caller record is cleared and reused by the prefetch thread :
+  std::unique_ptr<datatools::things> used_record = std::move(record_);
+  record_ = std::move(a_prefetched.record);
+  _free_records_->push(std::move(used_record));
+  _record_file_index_ = a_prefetched.file_index;
+  _record_number_ = a_prefetched.record_number;
+  return true;
+}
+
+bool event_source::read_position(uint32_t & file_index_, uint64_t & record_number_)
+{
+  DT_THROW_IF(!_positions_only_, std::logic_error, "Records are decoded by the source !");
+  if (!_next_position_(_record_file_index_, _record_number_)) return false;
+  file_index_ = _record_file_index_;
+  record_number_ = _record_number_;
+  return true;
+}
+
+bool event_source::_read_next_(datatools::things & record_,
+			       uint32_t & file_index_,
+			       uint64_t & record_number_)
+{
+  if (_is_random_access_())
+    {
+      if (!_next_position_(file_index_, record_number_)) return false;
+      DT_THROW_IF(!_random_reader_->load_record(record_, record_number_),
+		  std::runtime_error,
+		  "Cannot load record #" << record_number_ << " from file '" << _filenames_[_file_index_] << "' !");
+      return true;
+    }
+
+  while (_file_index_ < _filenames_.size())
+    {
+      if (!_reader_) _open_file_(_file_index_);
+      if (!_reader_->is_terminated()) {
+	_reader_->process(record_);
+	file_index_ = _file_index_;
+	record_number_ = _next_record_number_++;
+	return true;
+      }
+      _close_file_();
+      _file_index_++;
+    }
+  return false;
+}
+
+bool event_source::_next_position_(uint32_t & file_index_,
+				   uint64_t & record_number_)
+{
+  if (_indexed_)
+    {
+      if (_next_entry_ >= _entries_.size()) {
+	_close_file_();
+	return false;
+      }
+      const event_index_entry & entry = _entries_[_next_entry_++];
+      if (!_random_reader_ || entry.file_index != _file_index_) {
+	_close_file_();
+	_open_file_(entry.file_index);
+      }
+      file_index_ = entry.file_index;
+      record_number_ = entry.record_number;
+      return true;
+    }
+
+  while (_file_index_ < _filenames_.size())
+    {
+      if (!_random_reader_) _open_file_(_file_index_);
+      // Record range of the file :
+      if (_next_record_number_ < _end_record_number_) {
+	file_index_ = _file_index_;
+	record_number_ = _next_record_number_++;
+	return true;
+      }
+      _close_file_();
+      _file_index_++;
+    }
+  return false;
+}
+
+const std::vector<std::string> & event_source::get_filenames() const
+{
+  return _filenames_;
+}
+
+const datatools::multi_properties & event_source::get_metadata_store() const
+{
+  return _metadata_store_;
+}
+
+uint32_t event_source::get_file_index() const
+{
+  return _record_file_index_;
+}
+
+uint64_t event_source::get_record_number() const
+{
+  return _record_number_;
+}
+
+void event_source::_start_prefetch_()
+{
+  // Brio files are read by this thread while the program writes its ROOT files :
+  ROOT::EnableThreadSafety();
+  _prefetch_error_ = nullptr;
+  _prefetched_records_.reset(new bounded_queue<_prefetched_record_>(_prefetch_capacity_));
+  _free_records_.reset(new bounded_queue<std::unique_ptr<datatools::things> >(_prefetch_capacity_ + 1));
+  for (std::size_t irecord = 0; irecord < _prefetch_capacity_; irecord++) {
+    _free_records_->push(std::unique_ptr<datatools::things>(new datatools::things));
+  }
+
+  _prefetch_thread_ = std::thread([this] {
+      try {
+	std::unique_ptr<datatools::things> a_record;
+	while (_free_records_->pop(a_record)) {
+	  a_record->clear();
+	  _prefetched_record_ a_prefetched;
+	  if (!_read_next_(*a_record, a_prefetched.file_index, a_prefetched.record_number)) break;
+	  a_prefetched.record = std::move(a_record);
+	  if (!_prefetched_records_->push(std::move(a_prefetched))) break;
+	}
+      }
+      catch (...) {
+	std::lock_guard<std::mutex> lock(_prefetch_error_mutex_);
+	_prefetch_error_ = std::current_exception();
+      }
+      // The remaining prefetched records are still read :
+      _prefetched_records_->close();
+    });
+  return;
+}
+
+void event_source::_stop_prefetch_()
+{
+  if (!is_prefetching()) return;
+  _free_records_->close();
+  _prefetched_records_->close();
+  if (_prefetch_thread_.joinable()) _prefetch_thread_.join();
+  _prefetched_records_.reset();
+  _free_records_.reset();
+  return;
+}
+
+void event_source::_read_ahead_next_file_() const
+{
+  if (_readahead_bytes_ == 0) return;
+  std::size_t next_file_index = _file_index_ + 1;
+  if (_indexed_) {
+    // Next file with selected records :
+    next_file_index = _filenames_.size();
+    for (std::size_t ientry = _next_entry_; ientry < _entries_.size(); ientry++) {
+      if (_entries_[ientry].file_index != _file_index_) {
+	next_file_index = _entries_[ientry].file_index;
+	break;
+      }
+    }
+  }
+  if (next_file_index >= _filenames_.size()) return;
+
+  // Only a hint : the page cache is filled in background, errors are ignored
+  std::string filename = _filenames_[next_file_index];
+  datatools::fetch_path_with_env(filename);
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) return;
+  ::posix_fadvise(fd, 0, _readahead_bytes_, POSIX_FADV_WILLNEED);
+  ::close(fd);
+  DT_LOG_DEBUG(_logging_, "Read ahead of input file '" << filename << "'");
+  return;
+}
+
+void event_source::_load_metadata_(const std::string & filename_)
+{
+  // Metadata are read with a dpp::input_module :
+  dpp::input_module metadata_reader;
+  datatools::properties metadata_reader_config;
+  metadata_reader_config.store("logging.priority", "fatal");
+  metadata_reader_config.store("files.mode", "single");
+  metadata_reader_config.store("files.single.filename", filename_);
+  metadata_reader.initialize_standalone(metadata_reader_config);
+  _metadata_store_ = metadata_reader.get_metadata_store();
+  metadata_reader.reset();
+  return;
+}
+
+bool event_source::_is_random_access_() const
+{
+  return _indexed_ || _positions_only_ || is_ranged() || _start_file_index_ > 0 || _start_record_number_ > 0;
+}
+
+void event_source::_open_file_(std::size_t file_index_)
+{
+  _file_index_ = file_index_;
+  _next_record_number_ = 0;
+  DT_LOG_DEBUG(_logging_, "Opening input file '" << _filenames_[_file_index_] << "'");
+
+  if (_is_random_access_())
+    {
+      std::string filename = _filenames_[_file_index_];
+      datatools::fetch_path_with_env(filename);
+      _random_reader_.reset(new dpp::simple_brio_data_source(_logging_));
+      _random_reader_->set(filename);
+      _random_reader_->open();
+      if (!_indexed_) {
+	// Record range of this file, at most max_records_per_file_ records :
+	DT_THROW_IF(!_random_reader_->has_number_of_records(), std::runtime_error,
+		    "Cannot count the records of file '" << _filenames_[_file_index_] << "' !");
+	const uint64_t number_of_records = _random_reader_->get_number_of_records();
+	uint64_t first_record = std::min(_first_record_, number_of_records);
+	uint64_t end_record = _last_record_ == 0 ? number_of_records : std::min(_last_record_, number_of_records);
+	if (_number_of_shards_ > 0) {
+	  first_record = number_of_records * _shard_ / _number_of_shards_;
+	  end_record = number_of_records * (_shard_ + 1) / _number_of_shards_;
+	}
+	if (_max_records_per_file_ > 0) end_record = std::min<uint64_t>(end_record, first_record + _max_records_per_file_);
+	_next_record_number_ = first_record;
+	if (file_index_ == _start_file_index_) _next_record_number_ = std::max(first_record, _start_record_number_);
+	_end_record_number_ = end_record;
+	DT_LOG_DEBUG(_logging_, "Records [" << first_record << ", " << end_record << ") of " << number_of_records);
+      }
+    }
+  else
+    {
+      datatools::properties reader_config;
+      reader_config.store("logging.priority", "debug");
+      reader_config.store("files.mode", "single");
+      reader_config.store("files.single.filename", _filenames_[_file_index_]);
+      reader_config.store("max_record_total", static_cast<int>(_max_records_per_file_));
+      _reader_.reset(new dpp::input_module);
+      _reader_->initialize_standalone(reader_config);
+    }
+  if (_prefetch_capacity_ > 0) _read_ahead_next_file_();
+  return;
+}
+
+void event_source::_close_file_()
+{
+  if (_reader_) {
+    _reader_->reset();
+    _reader_.reset();
+  }
+  if (_random_reader_) {
+    if (_random_reader_->is_open()) _random_reader_->close();
+    _random_reader_.reset();
+  }
+  return;
+}
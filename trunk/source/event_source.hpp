@@ -0,0 +1,217 @@
+//! \file event_source.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Event records read file by file from a list of simulated data files,
+// keeping track of the source file and record number of each record
+//
+
+#ifndef EVENT_SOURCE_HPP
+#define EVENT_SOURCE_HPP
+
+// Standard library:
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+#include <datatools/multi_properties.h>
+#include <datatools/things.h>
+// - Bayeux/dpp:
+#include <dpp/input_module.h>
+#include <dpp/simple_brio_data_source.h>
+
+// This project :
+#include "bounded_queue.hpp"
+#include "event_index.hpp"
+
+//! \brief Source of event records
+//
+// Sequential mode reads the first records of each file with a
+// dpp::input_module, as the programs did in 'list' mode.
+// Index mode loads only the records listed in an event index,
+// with random access in the brio files.
+//
+// A record range or a shard restricts the sequential mode to a part of
+// each file, also read with random access, so a large file can be
+// split over several jobs. A start position skips the records before
+// it without reading them, in sequential or index mode.
+//
+// With prefetch, the records are decoded in advance by a background
+// thread, up to a fixed number of records (the memory budget), and the
+// OS is asked to read ahead the beginning of the next file, so the
+// event loop does not stall at the file boundaries. Prefetched records
+// are exchanged with the caller records, never copied.
+//
+// In positions only mode, the source hands out the file index and
+// record number of the records without decoding them, so several
+// threads can decode them in parallel with their own
+// event_record_loader. The records are then loaded with random access.
+class event_source
+{
+public :
+
+  /// Default constructor
+  event_source();
+
+  /// Destructor
+  ~event_source();
+
+  /// Default size read ahead in the next file (bytes)
+  static const std::size_t DEFAULT_READAHEAD_BYTES = 64 * 1024 * 1024;
+
+  /// Decode up to capacity_ records in advance (0 : no prefetch), set before initialize
+  void set_prefetch(std::size_t capacity_,
+		    std::size_t readahead_bytes_ = DEFAULT_READAHEAD_BYTES);
+
+  /// Check if the records are prefetched by a background thread
+  bool is_prefetching() const;
+
+  /// Read only the records [first_record_, last_record_) of each file (last_record_ = 0 : up to the end), set before initialize
+  void set_record_range(uint64_t first_record_, uint64_t last_record_);
+
+  /// Read only the shard shard_ (from 0) of number_of_shards_ equal parts of each file, set before initialize
+  void set_shard(uint32_t shard_, uint32_t number_of_shards_);
+
+  /// Check if only a part of each file is read
+  bool is_ranged() const;
+
+  /// Only return the positions of the records, decoded by the caller, set before initialize
+  void set_positions_only(bool positions_only_ = true);
+
+  /// Check if only the positions of the records are returned
+  bool is_positions_only() const;
+
+  /// Start at a record of a file (ex: resume an interrupted run), the previous records are skipped, set before initialize
+  void set_start_position(uint32_t file_index_, uint64_t record_number_);
+
+  /// Return the prefix of the output files of a record range or a shard, empty for whole files
+  std::string get_range_tag() const;
+
+  /// Parse a shard 'k/N'
+  static void parse_shard(const std::string & token_,
+			  uint32_t & shard_,
+			  uint32_t & number_of_shards_);
+
+  /// Read up to max_records_per_file_ records of each file in sequence
+  void initialize(const std::vector<std::string> & filenames_,
+		  std::size_t max_records_per_file_);
+
+  /// Read the records of an event index matching a selector mask (0 : all entries)
+  void initialize(const event_index & index_,
+		  uint64_t selector_mask_ = 0);
+
+  /// Set the logging priority
+  void set_logging(datatools::logger::priority logging_);
+
+  /// Read the next record, return false when there is no more record (not with prefetch)
+  bool read(datatools::things & record_);
+
+  /// Read the next record by exchanging it with the given one, return false when there is no more record
+  bool read(std::unique_ptr<datatools::things> & record_);
+
+  /// Return the position of the next record without decoding it, false when there is no more record (positions only mode)
+  bool read_position(uint32_t & file_index_, uint64_t & record_number_);
+
+  /// Return the list of source files
+  const std::vector<std::string> & get_filenames() const;
+
+  /// Return the metadata store of the first source file
+  const datatools::multi_properties & get_metadata_store() const;
+
+  /// Return the index of the file of the last record read
+  uint32_t get_file_index() const;
+
+  /// Return the record number in its file of the last record read
+  uint64_t get_record_number() const;
+
+private :
+
+  /// Record decoded in advance
+  struct _prefetched_record_
+  {
+    std::unique_ptr<datatools::things> record;
+    uint32_t file_index = 0;
+    uint64_t record_number = 0;
+  };
+
+  /// Read the next record from the files, with its file index and record number
+  bool _read_next_(datatools::things & record_,
+		   uint32_t & file_index_,
+		   uint64_t & record_number_);
+
+  /// Return the position of the next record in random access mode, the file of the record is open
+  bool _next_position_(uint32_t & file_index_,
+		       uint64_t & record_number_);
+
+  /// Start the prefetch thread
+  void _start_prefetch_();
+
+  /// Stop the prefetch thread
+  void _stop_prefetch_();
+
+  /// Ask the OS to read ahead the file following the current one
+  void _read_ahead_next_file_() const;
+
+  /// Check if the records are loaded with random access in the files
+  bool _is_random_access_() const;
+
+  /// Load the metadata store of a file
+  void _load_metadata_(const std::string & filename_);
+
+  void _open_file_(std::size_t file_index_);
+
+  void _close_file_();
+
+private :
+
+  datatools::logger::priority _logging_ = datatools::logger::PRIO_FATAL;
+  std::vector<std::string> _filenames_;
+  std::size_t _max_records_per_file_ = 0;
+  bool _indexed_ = false;
+  uint64_t _first_record_ = 0;
+  uint64_t _last_record_ = 0;
+  uint32_t _shard_ = 0;
+  uint32_t _number_of_shards_ = 0;
+  bool _positions_only_ = false;
+  uint32_t _start_file_index_ = 0;
+  uint64_t _start_record_number_ = 0;
+  std::vector<event_index_entry> _entries_;
+  std::size_t _next_entry_ = 0;
+  datatools::multi_properties _metadata_store_;
+
+  // Current file :
+  std::size_t _file_index_ = 0;
+  uint64_t _next_record_number_ = 0;
+  uint64_t _end_record_number_ = 0; ///< End of the record range of the current file
+  std::unique_ptr<dpp::input_module> _reader_;
+  std::unique_ptr<dpp::simple_brio_data_source> _random_reader_;
+
+  // Last record read :
+  uint32_t _record_file_index_ = 0;
+  uint64_t _record_number_ = 0;
+
+  // Prefetch :
+  std::size_t _prefetch_capacity_ = 0;
+  std::size_t _readahead_bytes_ = 0;
+  std::unique_ptr<bounded_queue<_prefetched_record_> > _prefetched_records_;
+  std::unique_ptr<bounded_queue<std::unique_ptr<datatools::things> > > _free_records_;
+  std::thread _prefetch_thread_;
+  std::exception_ptr _prefetch_error_;
+  std::mutex _prefetch_error_mutex_;
+
+};
+
+#endif // EVENT_SOURCE_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
@@ -0,0 +1,414 @@
+//! \file fixed_histogram.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+
+// Ourselves:
+#include <fixed_histogram.hpp>
+
+namespace {
+  /// Histograms made at save time are owned by the caller, not by the current directory
+  class no_directory_booking
+  {
+  public :
+    no_directory_booking() : _add_directory_(TH1::AddDirectoryStatus())
+    {
+      TH1::AddDirectory(kFALSE);
+    }
+    ~no_directory_booking()
+    {
+      TH1::AddDirectory(_add_directory_);
+    }
+  private :
+    Bool_t _add_directory_;
+  };
+
+  /// Check that a ROOT axis has the binning of a fixed axis
+  bool same_binning(const TAxis & root_axis_, const fixed_axis & axis_)
+  {
+    return root_axis_.GetNbins() >= 0
+      && static_cast<std::size_t>(root_axis_.GetNbins()) == axis_.number_of_bins
+      && root_axis_.GetXmin() == axis_.min
+      && root_axis_.GetXmax() == axis_.max;
+  }
+
+  /// Set the statistics of a ROOT 1D histogram from the counts of its regular bins, as TH1::ResetStats
+  void put_bin_statistics(TH1 & histogram_, const fixed_axis & axis_, const uint64_t * counts_)
+  {
+    Double_t stats[4] = {0, 0, 0, 0};
+    for (std::size_t bin = 1; bin <= axis_.number_of_bins; bin++) {
+      if (counts_[bin] == 0) continue;
+      const double w = counts_[bin];
+      const double x = axis_.get_bin_center(bin);
+      stats[0] += w;
+      stats[1] += w;
+      stats[2] += w * x;
+      stats[3] += w * x * x;
+    }
+    histogram_.PutStats(stats);
+    return;
+  }
+
+  /// Convert a bin content or a number of entries of a ROOT histogram to a count
+  uint64_t to_count(double value_, const TH1 & histogram_)
+  {
+    DT_THROW_IF(!(value_ >= 0), std::logic_error,
+		"Invalid count " << value_ << " in ROOT histogram '" << histogram_.GetName() << "' !");
+    return static_cast<uint64_t>(std::llround(value_));
+  }
+}
+
+fixed_histogram_1d::fixed_histogram_1d()
+{
+}
+
+void fixed_histogram_1d::initialize(const std::string & name_, const std::string & title_,
+				    std::size_t number_of_bins_, double min_, double max_)
+{
+  DT_THROW_IF(number_of_bins_ == 0 || !(min_ < max_), std::logic_error,
+	      "Invalid binning for histogram '" << name_ << "' !");
+  _name_ = name_;
+  _title_ = title_;
+  _axis_.number_of_bins = number_of_bins_;
+  _axis_.min = min_;
+  _axis_.max = max_;
+  _counts_.assign(number_of_bins_ + 2, 0);
+  reset();
+  return;
+}
+
+bool fixed_histogram_1d::is_initialized() const
+{
+  return !_counts_.empty();
+}
+
+void fixed_histogram_1d::reset()
+{
+  std::fill(_counts_.begin(), _counts_.end(), 0);
+  _entries_ = 0;
+  return;
+}
+
+void fixed_histogram_1d::fill(const double * x_, std::size_t number_of_values_)
+{
+  for (std::size_t i = 0; i < number_of_values_; i++) fill(x_[i]);
+  return;
+}
+
+void fixed_histogram_1d::merge(const fixed_histogram_1d & other_)
+{
+  DT_THROW_IF(!(_axis_ == other_._axis_), std::logic_error,
+	      "Cannot merge histogram '" << other_._name_ << "' in '" << _name_ << "' with another binning !");
+  for (std::size_t bin = 0; bin < _counts_.size(); bin++) _counts_[bin] += other_._counts_[bin];
+  _entries_ += other_._entries_;
+  return;
+}
+
+void fixed_histogram_1d::merge(const TH1 & histogram_)
+{
+  DT_THROW_IF(histogram_.GetDimension() != 1 || !same_binning(*histogram_.GetXaxis(), _axis_), std::logic_error,
+	      "Cannot merge ROOT histogram '" << histogram_.GetName() << "' in '" << _name_ << "' with another binning !");
+  for (std::size_t bin = 0; bin < _counts_.size(); bin++) _counts_[bin] += to_count(histogram_.GetBinContent(bin), histogram_);
+  _entries_ += to_count(histogram_.GetEntries(), histogram_);
+  return;
+}
+
+const std::string & fixed_histogram_1d::get_name() const
+{
+  return _name_;
+}
+
+const fixed_axis & fixed_histogram_1d::get_axis() const
+{
+  return _axis_;
+}
+
+uint64_t fixed_histogram_1d::get_bin_content(std::size_t bin_) const
+{
+  return _counts_.at(bin_);
+}
+
+uint64_t fixed_histogram_1d::get_entries() const
+{
+  return _entries_;
+}
+
+TH1F * fixed_histogram_1d::make_TH1F() const
+{
+  DT_THROW_IF(!is_initialized(), std::logic_error, "Histogram is not initialized !");
+  no_directory_booking booking;
+  TH1F * histogram = new TH1F(_name_.c_str(), _title_.c_str(), _axis_.number_of_bins, _axis_.min, _axis_.max);
+  for (std::size_t bin = 0; bin < _counts_.size(); bin++) {
+    if (_counts_[bin] != 0) histogram->SetBinContent(bin, _counts_[bin]);
+  }
+  // Bin contents changed the entries and statistics, they are set last :
+  histogram->SetEntries(_entries_);
+  put_bin_statistics(*histogram, _axis_, _counts_.data());
+  return histogram;
+}
+
+void fixed_histogram_1d::write() const
+{
+  std::unique_ptr<TH1F> histogram(make_TH1F());
+  histogram->Write("", TObject::kOverwrite);
+  return;
+}
+
+fixed_histogram_2d::fixed_histogram_2d()
+{
+}
+
+void fixed_histogram_2d::initialize(const std::string & name_, const std::string & title_,
+				    std::size_t number_of_x_bins_, double x_min_, double x_max_,
+				    std::size_t number_of_y_bins_, double y_min_, double y_max_)
+{
+  DT_THROW_IF(number_of_x_bins_ == 0 || !(x_min_ < x_max_)
+	      || number_of_y_bins_ == 0 || !(y_min_ < y_max_), std::logic_error,
+	      "Invalid binning for histogram '" << name_ << "' !");
+  _name_ = name_;
+  _title_ = title_;
+  _x_axis_.number_of_bins = number_of_x_bins_;
+  _x_axis_.min = x_min_;
+  _x_axis_.max = x_max_;
+  _y_axis_.number_of_bins = number_of_y_bins_;
+  _y_axis_.min = y_min_;
+  _y_axis_.max = y_max_;
+  _counts_.assign((number_of_x_bins_ + 2) * (number_of_y_bins_ + 2), 0);
+  reset();
+  return;
+}
+
+bool fixed_histogram_2d::is_initialized() const
+{
+  return !_counts_.empty();
+}
+
+void fixed_histogram_2d::reset()
+{
+  std::fill(_counts_.begin(), _counts_.end(), 0);
+  _entries_ = 0;
+  return;
+}
+
+void fixed_histogram_2d::fill(const double * x_, const double * y_, std::size_t number_of_points_)
+{
+  for (std::size_t i = 0; i < number_of_points_; i++) fill(x_[i], y_[i]);
+  return;
+}
+
+void fixed_histogram_2d::merge(const fixed_histogram_2d & other_)
+{
+  DT_THROW_IF(!(_x_axis_ == other_._x_axis_) || !(_y_axis_ == other_._y_axis_), std::logic_error,
+	      "Cannot merge histogram '" << other_._name_ << "' in '" << _name_ << "' with another binning !");
+  for (std::size_t bin = 0; bin < _counts_.size(); bin++) _counts_[bin] += other_._counts_[bin];
+  _entries_ += other_._entries_;
+  return;
+}
+
+void fixed_histogram_2d::merge(const TH1 & histogram_)
+{
+  DT_THROW_IF(histogram_.GetDimension() != 2
+	      || !same_binning(*histogram_.GetXaxis(), _x_axis_)
+	      || !same_binning(*histogram_.GetYaxis(), _y_axis_), std::logic_error,
+	      "Cannot merge ROOT histogram '" << histogram_.GetName() << "' in '" << _name_ << "' with another binning !");
+  for (std::size_t y_bin = 0; y_bin < _y_axis_.number_of_bins + 2; y_bin++) {
+    for (std::size_t x_bin = 0; x_bin < _x_axis_.number_of_bins + 2; x_bin++) {
+      _counts_[y_bin * (_x_axis_.number_of_bins + 2) + x_bin] += to_count(histogram_.GetBinContent(x_bin, y_bin), histogram_);
+    }
+  }
+  _entries_ += to_count(histogram_.GetEntries(), histogram_);
+  return;
+}
+
+const std::string & fixed_histogram_2d::get_name() const
+{
+  return _name_;
+}
+
+uint64_t fixed_histogram_2d::get_bin_content(std::size_t x_bin_, std::size_t y_bin_) const
+{
+  DT_THROW_IF(x_bin_ > _x_axis_.number_of_bins + 1 || y_bin_ > _y_axis_.number_of_bins + 1,
+	      std::range_error, "Invalid bin in histogram '" << _name_ << "' !");
+  return _counts_[y_bin_ * (_x_axis_.number_of_bins + 2) + x_bin_];
+}
+
+uint64_t fixed_histogram_2d::get_entries() const
+{
+  return _entries_;
+}
+
+TH2F * fixed_histogram_2d::make_TH2F() const
+{
+  DT_THROW_IF(!is_initialized(), std::logic_error, "Histogram is not initialized !");
+  no_directory_booking booking;
+  TH2F * histogram = new TH2F(_name_.c_str(), _title_.c_str(),
+			      _x_axis_.number_of_bins, _x_axis_.min, _x_axis_.max,
+			      _y_axis_.number_of_bins, _y_axis_.min, _y_axis_.max);
+  // Statistics of the regular bins, as TH2::ResetStats :
+  Double_t stats[7] = {0, 0, 0, 0, 0, 0, 0};
+  for (std::size_t y_bin = 0; y_bin < _y_axis_.number_of_bins + 2; y_bin++) {
+    for (std::size_t x_bin = 0; x_bin < _x_axis_.number_of_bins + 2; x_bin++) {
+      const uint64_t count = _counts_[y_bin * (_x_axis_.number_of_bins + 2) + x_bin];
+      if (count == 0) continue;
+      histogram->SetBinContent(x_bin, y_bin, count);
+      if (x_bin == 0 || x_bin > _x_axis_.number_of_bins || y_bin == 0 || y_bin > _y_axis_.number_of_bins) continue;
+      const double w = count;
+      const double x = _x_axis_.get_bin_center(x_bin);
+      const double y = _y_axis_.get_bin_center(y_bin);
+      stats[0] += w;
+      stats[1] += w;
+      stats[2] += w * x;
+      stats[3] += w * x * x;
+      stats[4] += w * y;
+      stats[5] += w * y * y;
+      stats[6] += w * x * y;
+    }
+  }
+  // Bin contents changed the entries and statistics, they are set last :
+  histogram->SetEntries(_entries_);
+  histogram->PutStats(stats);
+  return histogram;
+}
+
+void fixed_histogram_2d::write() const
+{
+  std::unique_ptr<TH2F> histogram(make_TH2F());
+  histogram->Write("", TObject::kOverwrite);
+  return;
+}
+
+fixed_histogram_1d_array::fixed_histogram_1d_array()
+{
+}
+
+void fixed_histogram_1d_array::initialize(std::size_t number_of_channels_,
+					  std::size_t number_of_bins_, double min_, double max_)
+{
+  DT_THROW_IF(number_of_channels_ == 0 || number_of_bins_ == 0 || !(min_ < max_), std::logic_error,
+	      "Invalid channels or binning for histogram array !");
+  _axis_.number_of_bins = number_of_bins_;
+  _axis_.min = min_;
+  _axis_.max = max_;
+  _slots_.assign(number_of_channels_, -1);
+  reset();
+  return;
+}
+
+bool fixed_histogram_1d_array::is_initialized() const
+{
+  return !_slots_.empty();
+}
+
+void fixed_histogram_1d_array::reset()
+{
+  for (std::size_t slot = 0; slot < _channels_.size(); slot++) _slots_[_channels_[slot]] = -1;
+  _channels_.clear();
+  _counts_.clear();
+  _entries_.clear();
+  return;
+}
+
+int32_t fixed_histogram_1d_array::_allocate_(std::size_t channel_)
+{
+  const int32_t slot = _channels_.size();
+  _slots_[channel_] = slot;
+  _channels_.push_back(channel_);
+  _counts_.resize(_counts_.size() + _axis_.number_of_bins + 2, 0);
+  _entries_.push_back(0);
+  return slot;
+}
+
+void fixed_histogram_1d_array::merge(const fixed_histogram_1d_array & other_)
+{
+  DT_THROW_IF(_slots_.size() != other_._slots_.size() || !(_axis_ == other_._axis_), std::logic_error,
+	      "Cannot merge histogram arrays with other channels or binning !");
+  const std::size_t row_size = _axis_.number_of_bins + 2;
+  for (std::size_t other_slot = 0; other_slot < other_._channels_.size(); other_slot++) {
+    const std::size_t channel = other_._channels_[other_slot];
+    int32_t slot = _slots_[channel];
+    if (slot < 0) slot = _allocate_(channel);
+    const uint64_t * other_row = &other_._counts_[other_slot * row_size];
+    uint64_t * row = &_counts_[slot * row_size];
+    for (std::size_t bin = 0; bin < row_size; bin++) row[bin] += other_row[bin];
+    _entries_[slot] += other_._entries_[other_slot];
+  }
+  return;
+}
+
+void fixed_histogram_1d_array::merge(std::size_t channel_, const TH1 & histogram_)
+{
+  DT_THROW_IF(channel_ >= _slots_.size(), std::range_error, "Invalid channel " << channel_ << " !");
+  DT_THROW_IF(histogram_.GetDimension() != 1 || !same_binning(*histogram_.GetXaxis(), _axis_), std::logic_error,
+	      "Cannot merge ROOT histogram '" << histogram_.GetName() << "' in channel " << channel_ << " with another binning !");
+  int32_t slot = _slots_[channel_];
+  if (slot < 0) slot = _allocate_(channel_);
+  const std::size_t row_size = _axis_.number_of_bins + 2;
+  uint64_t * row = &_counts_[slot * row_size];
+  for (std::size_t bin = 0; bin < row_size; bin++) row[bin] += to_count(histogram_.GetBinContent(bin), histogram_);
+  _entries_[slot] += to_count(histogram_.GetEntries(), histogram_);
+  return;
+}
+
+std::size_t fixed_histogram_1d_array::get_number_of_channels() const
+{
+  return _slots_.size();
+}
+
+const fixed_axis & fixed_histogram_1d_array::get_axis() const
+{
+  return _axis_;
+}
+
+bool fixed_histogram_1d_array::is_filled(std::size_t channel_) const
+{
+  return _slots_.at(channel_) >= 0;
+}
+
+std::vector<std::size_t> fixed_histogram_1d_array::get_filled_channels() const
+{
+  std::vector<std::size_t> channels = _channels_;
+  std::sort(channels.begin(), channels.end());
+  return channels;
+}
+
+uint64_t fixed_histogram_1d_array::get_bin_content(std::size_t channel_, std::size_t bin_) const
+{
+  DT_THROW_IF(bin_ > _axis_.number_of_bins + 1, std::range_error, "Invalid bin " << bin_ << " !");
+  const int32_t slot = _slots_.at(channel_);
+  if (slot < 0) return 0;
+  return _counts_[slot * (_axis_.number_of_bins + 2) + bin_];
+}
+
+uint64_t fixed_histogram_1d_array::get_entries(std::size_t channel_) const
+{
+  const int32_t slot = _slots_.at(channel_);
+  if (slot < 0) return 0;
+  return _entries_[slot];
+}
+
+TH1F * fixed_histogram_1d_array::make_TH1F(std::size_t channel_, const std::string & name_, const std::string & title_) const
+{
+  DT_THROW_IF(!is_initialized(), std::logic_error, "Histogram array is not initialized !");
+  no_directory_booking booking;
+  TH1F * histogram = new TH1F(name_.c_str(), title_.c_str(), _axis_.number_of_bins, _axis_.min, _axis_.max);
+  const int32_t slot = _slots_.at(channel_);
+  if (slot < 0) return histogram;
+  const std::size_t row_size = _axis_.number_of_bins + 2;
+  for (std::size_t bin = 0; bin < row_size; bin++) {
+    const uint64_t count = _counts_[slot * row_size + bin];
+    if (count != 0) histogram->SetBinContent(bin, count);
+  }
+  histogram->SetEntries(_entries_[slot]);
+  put_bin_statistics(*histogram, _axis_, &_counts_[slot * row_size]);
+  return histogram;
+}
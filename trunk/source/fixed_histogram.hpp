@@ -0,0 +1,267 @@
+//! \file fixed_histogram.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Fixed binning 1D and 2D histograms with contiguous counters, filled
+// in the event loop and converted to ROOT TH1F / TH2F only when saved
+//
+
+#ifndef FIXED_HISTOGRAM_HPP
+#define FIXED_HISTOGRAM_HPP
+
+// Standard library:
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Root :
+#include "TH1F.h"
+#include "TH2F.h"
+
+//! \brief Fixed binning axis, same bin numbering as a ROOT TAxis
+//
+// Bin 0 is the underflow, bins 1 to N the regular bins and bin N+1
+// the overflow.
+struct fixed_axis
+{
+  /// Return the bin of a value
+  std::size_t find_bin(double x_) const
+  {
+    if (x_ < min) return 0;
+    if (!(x_ < max)) return number_of_bins + 1;
+    return 1 + static_cast<std::size_t>(number_of_bins * (x_ - min) / (max - min));
+  }
+
+  /// Return the center of a regular bin, as TAxis::GetBinCenter
+  double get_bin_center(std::size_t bin_) const
+  {
+    const double width = (max - min) / number_of_bins;
+    return min + (bin_ - 0.5) * width;
+  }
+
+  /// Check if two axis have the same binning
+  bool operator==(const fixed_axis & other_) const
+  {
+    return number_of_bins == other_.number_of_bins && min == other_.min && max == other_.max;
+  }
+
+  std::size_t number_of_bins = 0;
+  double min = 0;
+  double max = 0;
+};
+
+//! \brief Fixed binning 1D histogram
+//
+// No virtual call and no lock : each thread fills its own histograms,
+// merged at the end. Entries follow TH1::Fill. The statistics (sum of
+// w, w2, wx, wx2 in the regular bins) are computed from the bin centers
+// when the TH1F is made, as TH1::ResetStats does : mean and RMS are
+// the same whatever the order of the fills and of the thread merges.
+class fixed_histogram_1d
+{
+public :
+
+  /// Default constructor
+  fixed_histogram_1d();
+
+  /// Book the histogram
+  void initialize(const std::string & name_, const std::string & title_,
+		  std::size_t number_of_bins_, double min_, double max_);
+
+  /// Check initialization
+  bool is_initialized() const;
+
+  /// Clear the contents
+  void reset();
+
+  /// Fill a value
+  void fill(double x_)
+  {
+    _counts_[_axis_.find_bin(x_)]++;
+    _entries_++;
+  }
+
+  /// Fill several values
+  void fill(const double * x_, std::size_t number_of_values_);
+
+  /// Add the contents of a histogram with the same binning
+  void merge(const fixed_histogram_1d & other_);
+
+  /// Add the contents and entries of a ROOT 1D histogram with the same binning
+  void merge(const TH1 & histogram_);
+
+  /// Return the name
+  const std::string & get_name() const;
+
+  /// Return the axis
+  const fixed_axis & get_axis() const;
+
+  /// Return the content of a bin (0 : underflow, N+1 : overflow)
+  uint64_t get_bin_content(std::size_t bin_) const;
+
+  /// Return the number of entries
+  uint64_t get_entries() const;
+
+  /// Make a TH1F with the same contents, entries and statistics, not attached to any directory
+  TH1F * make_TH1F() const;
+
+  /// Write a TH1F with the same contents in the current ROOT directory
+  void write() const;
+
+private :
+
+  std::string _name_;
+  std::string _title_;
+  fixed_axis _axis_;
+  std::vector<uint64_t> _counts_;
+  uint64_t _entries_ = 0;
+
+};
+
+//! \brief Fixed binning 2D histogram
+//
+// Same as fixed_histogram_1d, statistics computed from the bin centers
+// as TH2::ResetStats does.
+class fixed_histogram_2d
+{
+public :
+
+  /// Default constructor
+  fixed_histogram_2d();
+
+  /// Book the histogram
+  void initialize(const std::string & name_, const std::string & title_,
+		  std::size_t number_of_x_bins_, double x_min_, double x_max_,
+		  std::size_t number_of_y_bins_, double y_min_, double y_max_);
+
+  /// Check initialization
+  bool is_initialized() const;
+
+  /// Clear the contents
+  void reset();
+
+  /// Fill a point
+  void fill(double x_, double y_)
+  {
+    const std::size_t x_bin = _x_axis_.find_bin(x_);
+    const std::size_t y_bin = _y_axis_.find_bin(y_);
+    _counts_[y_bin * (_x_axis_.number_of_bins + 2) + x_bin]++;
+    _entries_++;
+  }
+
+  /// Fill several points
+  void fill(const double * x_, const double * y_, std::size_t number_of_points_);
+
+  /// Add the contents of a histogram with the same binning
+  void merge(const fixed_histogram_2d & other_);
+
+  /// Add the contents and entries of a ROOT 2D histogram with the same binning
+  void merge(const TH1 & histogram_);
+
+  /// Return the name
+  const std::string & get_name() const;
+
+  /// Return the content of a bin (0 : underflow, N+1 : overflow on each axis)
+  uint64_t get_bin_content(std::size_t x_bin_, std::size_t y_bin_) const;
+
+  /// Return the number of entries
+  uint64_t get_entries() const;
+
+  /// Make a TH2F with the same contents, entries and statistics, not attached to any directory
+  TH2F * make_TH2F() const;
+
+  /// Write a TH2F with the same contents in the current ROOT directory
+  void write() const;
+
+private :
+
+  std::string _name_;
+  std::string _title_;
+  fixed_axis _x_axis_;
+  fixed_axis _y_axis_;
+  std::vector<uint64_t> _counts_;
+  uint64_t _entries_ = 0;
+
+};
+
+//! \brief Fixed binning 1D histograms of many channels in one matrix
+//
+// All channels share the same binning. The bins of a channel are a row
+// of a single contiguous channel x bin matrix, allocated the first time
+// the channel is filled : channels never filled cost no memory and are
+// not exported. Entries of each channel follow TH1::Fill, statistics
+// are computed from the bin centers as for fixed_histogram_1d.
+class fixed_histogram_1d_array
+{
+public :
+
+  /// Default constructor
+  fixed_histogram_1d_array();
+
+  /// Book the channels
+  void initialize(std::size_t number_of_channels_,
+		  std::size_t number_of_bins_, double min_, double max_);
+
+  /// Check initialization
+  bool is_initialized() const;
+
+  /// Clear the contents, channels are released
+  void reset();
+
+  /// Fill a value in a channel
+  void fill(std::size_t channel_, double x_)
+  {
+    int32_t slot = _slots_[channel_];
+    if (slot < 0) slot = _allocate_(channel_);
+    _counts_[slot * (_axis_.number_of_bins + 2) + _axis_.find_bin(x_)]++;
+    _entries_[slot]++;
+  }
+
+  /// Add the contents of an array with the same channels and binning
+  void merge(const fixed_histogram_1d_array & other_);
+
+  /// Add the contents and entries of a ROOT 1D histogram with the same binning in a channel
+  void merge(std::size_t channel_, const TH1 & histogram_);
+
+  /// Return the number of channels
+  std::size_t get_number_of_channels() const;
+
+  /// Return the axis
+  const fixed_axis & get_axis() const;
+
+  /// Check if a channel has been filled
+  bool is_filled(std::size_t channel_) const;
+
+  /// Return the filled channels, in increasing order
+  std::vector<std::size_t> get_filled_channels() const;
+
+  /// Return the content of a bin of a channel (0 : underflow, N+1 : overflow)
+  uint64_t get_bin_content(std::size_t channel_, std::size_t bin_) const;
+
+  /// Return the number of entries of a channel
+  uint64_t get_entries(std::size_t channel_) const;
+
+  /// Make a TH1F with the contents of a channel, not attached to any directory
+  TH1F * make_TH1F(std::size_t channel_, const std::string & name_, const std::string & title_) const;
+
+private :
+
+  /// Allocate the bins of a channel and return its slot
+  int32_t _allocate_(std::size_t channel_);
+
+  fixed_axis _axis_;
+  std::vector<int32_t> _slots_;        ///< Row of each channel in the matrix, -1 if not allocated
+  std::vector<std::size_t> _channels_; ///< Channel of each row
+  std::vector<uint64_t> _counts_;      ///< Channel x bin matrix, one row per filled channel
+  std::vector<uint64_t> _entries_;     ///< Entries of each row
+
+};
+
+#endif // FIXED_HISTOGRAM_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
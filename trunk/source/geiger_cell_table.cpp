@@ -0,0 +1,95 @@
+//! \file geiger_cell_table.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <algorithm>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/utils.h>
+
+// Ourselves:
+#include <geiger_cell_table.hpp>
+
+geiger_cell_table::geiger_cell_table()
+  : _cells_(hc_constants::NUMBER_OF_GEIGER_CELLS)
+{
+  _touched_cells_.reserve(hc_constants::NUMBER_OF_GEIGER_CELLS);
+}
+
+std::size_t geiger_cell_table::cell_index(const geomtools::geom_id & geiger_gid_)
+{
+  const uint32_t side  = geiger_gid_.get(1);
+  const uint32_t layer = geiger_gid_.get(2);
+  const uint32_t row   = geiger_gid_.get(3);
+  if (side >= hc_constants::NUMBER_OF_SIDES
+      || layer >= hc_constants::NUMBER_OF_GEIGER_LAYERS
+      || row >= hc_constants::NUMBER_OF_GEIGER_ROWS) return INVALID_CELL;
+  return (side * hc_constants::NUMBER_OF_GEIGER_LAYERS + layer) * hc_constants::NUMBER_OF_GEIGER_ROWS + row;
+}
+
+void geiger_cell_table::cell_address(std::size_t cell_, uint32_t & side_, uint32_t & layer_, uint32_t & row_)
+{
+  row_ = cell_ % hc_constants::NUMBER_OF_GEIGER_ROWS;
+  layer_ = (cell_ / hc_constants::NUMBER_OF_GEIGER_ROWS) % hc_constants::NUMBER_OF_GEIGER_LAYERS;
+  side_ = cell_ / (hc_constants::NUMBER_OF_GEIGER_ROWS * hc_constants::NUMBER_OF_GEIGER_LAYERS);
+  return;
+}
+
+void geiger_cell_table::reset()
+{
+  // Hit lists are cleared, not released, their capacity is reused by the next events :
+  for (std::size_t i = 0; i < _touched_cells_.size(); i++) {
+    _cells_[_touched_cells_[i]].clear();
+  }
+  _touched_cells_.clear();
+  _fires_.clear();
+  return;
+}
+
+void geiger_cell_table::add_hit(std::size_t cell_, std::size_t hit_index_, double time_)
+{
+  cell_hits & hits = _cells_[cell_];
+  if (hits.empty()) _touched_cells_.push_back(cell_);
+  hits.push_back(std::make_pair(time_, hit_index_));
+  if (hit_index_ >= _fires_.size()) _fires_.resize(hit_index_ + 1, 0);
+  return;
+}
+
+void geiger_cell_table::select_fires(double dead_time_)
+{
+  const bool has_dead_time = datatools::is_valid(dead_time_);
+  for (std::size_t i = 0; i < _touched_cells_.size(); i++) {
+    cell_hits & hits = _cells_[_touched_cells_[i]];
+    // Few hits per cell, the step hits are mostly already in time order :
+    if (hits.size() > 1) std::sort(hits.begin(), hits.end());
+    double rearm_time = hits.front().first;
+    _fires_[hits.front().second] = 1;
+    if (!has_dead_time) continue;
+    rearm_time += dead_time_;
+    for (std::size_t ihit = 1; ihit < hits.size(); ihit++) {
+      if (hits[ihit].first <= rearm_time) continue;
+      _fires_[hits[ihit].second] = 1;
+      rearm_time = hits[ihit].first + dead_time_;
+    }
+  }
+  return;
+}
+
+bool geiger_cell_table::is_rehit(std::size_t hit_index_) const
+{
+  return hit_index_ < _fires_.size() && !_fires_[hit_index_];
+}
+
+double geiger_cell_table::get_first_hit_time(std::size_t cell_) const
+{
+  const cell_hits & hits = _cells_[cell_];
+  double time;
+  datatools::invalidate(time);
+  for (std::size_t ihit = 0; ihit < hits.size(); ihit++) {
+    if (ihit == 0 || hits[ihit].first < time) time = hits[ihit].first;
+  }
+  return time;
+}
@@ -0,0 +1,80 @@
+//! \file geiger_cell_table.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Dense side x layer x row table of the hits of each Geiger cell in an
+// event, used to flag the hits firing a cell and the re-hits
+//
+
+#ifndef GEIGER_CELL_TABLE_HPP
+#define GEIGER_CELL_TABLE_HPP
+
+// Standard library:
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Third party:
+// - Bayeux/geomtools:
+#include <bayeux/geomtools/geom_id.h>
+
+// This project :
+#include "hc_constants.hpp"
+
+//! \brief Hits of each Geiger cell, and the fires they make
+//
+// Only the cells touched since the last reset are cleared, the table
+// is meant to be reused from one event to the other.
+struct geiger_cell_table
+{
+  /// Index returned for a geom ID outside of the table
+  static const std::size_t INVALID_CELL = static_cast<std::size_t>(-1);
+
+  /// Default constructor
+  geiger_cell_table();
+
+  /// Return the cell index of a drift cell geom ID (module, side, layer, row)
+  static std::size_t cell_index(const geomtools::geom_id & geiger_gid_);
+
+  /// Return the side, layer and row of a cell index
+  static void cell_address(std::size_t cell_, uint32_t & side_, uint32_t & layer_, uint32_t & row_);
+
+  /// Reset the cells touched since the last reset
+  void reset();
+
+  /// Record a hit of a cell
+  void add_hit(std::size_t cell_, std::size_t hit_index_, double time_);
+
+  /// Select the hits firing their cell, once all hits are recorded
+  ///
+  /// The hits of each cell are taken in time order (lowest hit index on
+  /// equal times). Without a valid dead time, only the first one fires
+  /// the cell. With a dead time, the cell is re-armed at the last fire
+  /// + dead time : a hit arriving later fires it again, a hit within
+  /// the dead time of the last fire is a re-hit.
+  void select_fires(double dead_time_);
+
+  /// Check if a hit is a re-hit of an already fired cell, after select_fires
+  bool is_rehit(std::size_t hit_index_) const;
+
+  /// Return the first hit time of a cell
+  double get_first_hit_time(std::size_t cell_) const;
+
+private :
+
+  /// Hits of a cell, as (time, hit index)
+  typedef std::vector<std::pair<double, std::size_t> > cell_hits;
+
+  std::vector<cell_hits> _cells_;
+  std::vector<std::size_t> _touched_cells_;
+  std::vector<char> _fires_; ///< Fire flag of each hit index
+
+};
+
+#endif // GEIGER_CELL_TABLE_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
@@ -0,0 +1,98 @@
+//! \file geometry_context.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+#include <datatools/properties.h>
+#include <datatools/utils.h>
+
+// Ourselves:
+#include <geometry_context.hpp>
+
+// This project :
+#include "compiled_id_selector.hpp"
+
+const std::string & geometry_context::default_manager_config()
+{
+  static const std::string _config("@falaise:config/snemo/demonstrator/geometry/4.0/manager.conf");
+  return _config;
+}
+
+const std::vector<std::string> & geometry_context::used_categories()
+{
+  static const std::vector<std::string> _categories = {compiled_id_selector::calo_category(),
+						       compiled_id_selector::geiger_category()};
+  return _categories;
+}
+
+geometry_context::geometry_context()
+{
+}
+
+geometry_context::~geometry_context()
+{
+}
+
+void geometry_context::initialize(bool full_geometry_,
+				  const std::string & manager_config_file_)
+{
+  DT_THROW_IF(is_initialized(), std::logic_error, "Geometry is already initialized !");
+  std::string manager_config_file = manager_config_file_;
+  datatools::fetch_path_with_env(manager_config_file);
+  datatools::properties manager_config;
+  datatools::properties::read_config (manager_config_file,
+				      manager_config);
+
+  if (full_geometry_)
+    {
+      // Mapping only for the categories used by the programs :
+      _manager_.reset(new geomtools::manager);
+      manager_config.update ("build_mapping", true);
+      if (manager_config.has_key ("mapping.excluded_categories")) manager_config.erase ("mapping.excluded_categories");
+      manager_config.update ("mapping.only_categories", used_categories());
+      _manager_->initialize (manager_config);
+      return;
+    }
+
+  // Geom ID categories only, the geometry models are not built :
+  std::vector<std::string> categories_lists;
+  if (manager_config.has_key("id_mgr.categories_lists")) manager_config.fetch("id_mgr.categories_lists", categories_lists);
+  else if (manager_config.has_key("id_mgr.categories_list")) categories_lists.push_back(manager_config.fetch_string("id_mgr.categories_list"));
+  DT_THROW_IF(categories_lists.empty(), std::logic_error, "No geom ID categories in '" << manager_config_file << "' !");
+  _id_mgr_.reset(new geomtools::id_mgr);
+  for (std::size_t ilist = 0; ilist < categories_lists.size(); ilist++) {
+    std::string categories_file = categories_lists[ilist];
+    datatools::fetch_path_with_env(categories_file);
+    _id_mgr_->load(categories_file);
+  }
+  return;
+}
+
+bool geometry_context::is_initialized() const
+{
+  return _id_mgr_ || _manager_;
+}
+
+bool geometry_context::has_manager() const
+{
+  return _manager_ != nullptr;
+}
+
+const geomtools::id_mgr & geometry_context::get_id_mgr() const
+{
+  DT_THROW_IF(!is_initialized(), std::logic_error, "Geometry is not initialized !");
+  if (_manager_) return _manager_->get_id_mgr();
+  return *_id_mgr_;
+}
+
+const geomtools::manager & geometry_context::get_manager() const
+{
+  DT_THROW_IF(!has_manager(), std::logic_error, "Full geometry manager is not built !");
+  return *_manager_;
+}
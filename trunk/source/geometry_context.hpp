@@ -0,0 +1,71 @@
+//! \file geometry_context.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Demonstrator geometry needed by the programs : only the geom ID
+// manager by default, the full geometry manager on demand
+//
+
+#ifndef GEOMETRY_CONTEXT_HPP
+#define GEOMETRY_CONTEXT_HPP
+
+// Standard library:
+#include <memory>
+#include <string>
+#include <vector>
+
+// Third party:
+// - Bayeux/geomtools:
+#include <bayeux/geomtools/id_mgr.h>
+#include <bayeux/geomtools/manager.h>
+
+//! \brief Geom ID manager, and geometry manager if needed
+//
+// Decoding geom IDs and compiling the mapping rules only need the geom
+// ID categories, loaded in milliseconds. The full geometry manager
+// (models and mapping, needed by the locators) takes much longer and
+// is only built on demand, with the mapping of the used categories.
+struct geometry_context
+{
+  /// Default geometry manager configuration of the demonstrator
+  static const std::string & default_manager_config();
+
+  /// Categories used by the programs (calo blocks and drift cells)
+  static const std::vector<std::string> & used_categories();
+
+  /// Default constructor
+  geometry_context();
+
+  /// Destructor
+  ~geometry_context();
+
+  /// Load the geom ID categories only, or build the full geometry manager
+  void initialize(bool full_geometry_,
+		  const std::string & manager_config_file_ = default_manager_config());
+
+  /// Check initialization
+  bool is_initialized() const;
+
+  /// Check if the full geometry manager is built
+  bool has_manager() const;
+
+  /// Return the geom ID manager
+  const geomtools::id_mgr & get_id_mgr() const;
+
+  /// Return the full geometry manager
+  const geomtools::manager & get_manager() const;
+
+private :
+
+  std::unique_ptr<geomtools::id_mgr> _id_mgr_;    ///< Geom ID categories only
+  std::unique_ptr<geomtools::manager> _manager_;  ///< Full geometry
+
+};
+
+#endif // GEOMETRY_CONTEXT_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
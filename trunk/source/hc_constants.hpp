@@ -18,6 +18,10 @@
 
 struct hc_constants
 {
+	// Demonstrator :
+	static const uint16_t NUMBER_OF_MODULES = 1;
+	static const uint16_t NUMBER_OF_SIDES = 2;
+
 	// Calo :
   static const uint16_t NUMBER_OF_CALO_PER_COLUMN = 13;
 	static const uint16_t NUMBER_OF_CALO_COLUMNS    = 20;
@@ -26,6 +30,7 @@ struct hc_constants
 	// Geiger :
 	static const uint16_t NUMBER_OF_GEIGER_LAYERS = 9;
 	static const uint16_t NUMBER_OF_GEIGER_ROWS   = 113;
+	static const uint16_t NUMBER_OF_GEIGER_CELLS  = NUMBER_OF_SIDES * NUMBER_OF_GEIGER_LAYERS * NUMBER_OF_GEIGER_ROWS;
 
 	// Electronics :
 	static const std::size_t CALO_COMMISSIONING_HIGH_THRESHOLD_KEV = 15;
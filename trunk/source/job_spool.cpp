@@ -0,0 +1,220 @@
+//! \file job_spool.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+// POSIX :
+#include <dirent.h>
+#include <sys/stat.h>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+#include <datatools/utils.h>
+
+// Ourselves:
+#include <job_spool.hpp>
+
+namespace {
+
+  volatile std::sig_atomic_t stop_signal = 0;
+
+  void on_stop_signal(int signal_)
+  {
+    stop_signal = 1;
+    // The job in progress finishes first, a second signal stops the program at once :
+    std::signal(signal_, SIG_DFL);
+  }
+
+  const std::string JOB_EXTENSION = ".job";
+
+  bool has_extension(const std::string & filename_, const std::string & extension_)
+  {
+    return filename_.size() > extension_.size()
+      && filename_.compare(filename_.size() - extension_.size(), extension_.size(), extension_) == 0;
+  }
+
+  /// Standard outputs sent in a file, restored on destruction
+  struct output_redirection
+  {
+    output_redirection(std::ostream & stream_, std::streambuf * buffer_)
+      : stream(stream_), saved_buffer(stream_.rdbuf(buffer_))
+    {
+    }
+
+    ~output_redirection()
+    {
+      stream.flush();
+      stream.rdbuf(saved_buffer);
+    }
+
+    std::ostream & stream;
+    std::streambuf * saved_buffer;
+  };
+
+}
+
+void job_context::initialize_geometry(bool full_geometry_)
+{
+  if (geometry.is_initialized()) {
+    DT_THROW_IF(full_geometry_ && !geometry.has_manager(), std::logic_error,
+		"The full geometry is not loaded, the spool has to be served with --full-geometry !");
+    return;
+  }
+  geometry.initialize(full_geometry_);
+  return;
+}
+
+void job_context::load_snapshot(const std::string & filename_)
+{
+  if (filename_.empty()) return;
+  std::string filename = filename_;
+  datatools::fetch_path_with_env(filename);
+  if (filename == snapshot_filename) return;
+  snapshot.load(filename);
+  snapshot_filename = filename;
+  return;
+}
+
+void job_context::store_snapshot() const
+{
+  if (snapshot_filename.empty() || !snapshot.is_modified()) return;
+  snapshot.store(snapshot_filename);
+  return;
+}
+
+job_spool::job_spool()
+{
+}
+
+void job_spool::initialize(const std::string & directory_, double poll_interval_)
+{
+  DT_THROW_IF(_initialized_, std::logic_error, "Job spool is already initialized !");
+  DT_THROW_IF(poll_interval_ <= 0, std::logic_error, "Invalid polling interval " << poll_interval_ << " s !");
+  _directory_ = directory_;
+  datatools::fetch_path_with_env(_directory_);
+  struct stat directory_stat;
+  DT_THROW_IF(::stat(_directory_.c_str(), &directory_stat) != 0 || !S_ISDIR(directory_stat.st_mode),
+	      std::logic_error, "Spool directory '" << _directory_ << "' does not exist !");
+  _poll_interval_ = poll_interval_;
+  stop_signal = 0;
+  std::signal(SIGINT, on_stop_signal);
+  std::signal(SIGTERM, on_stop_signal);
+  _initialized_ = true;
+  return;
+}
+
+bool job_spool::is_initialized() const
+{
+  return _initialized_;
+}
+
+bool job_spool::is_stop_requested() const
+{
+  if (stop_signal) return true;
+  struct stat stop_stat;
+  return ::stat(_path_("stop").c_str(), &stop_stat) == 0;
+}
+
+bool job_spool::next_job(job & job_)
+{
+  DT_THROW_IF(!_initialized_, std::logic_error, "Job spool is not initialized !");
+  while (!is_stop_requested())
+    {
+      std::vector<std::string> job_filenames;
+      DIR * directory = ::opendir(_directory_.c_str());
+      DT_THROW_IF(directory == nullptr, std::runtime_error, "Cannot read spool directory '" << _directory_ << "' !");
+      while (const struct dirent * an_entry = ::readdir(directory)) {
+	const std::string filename = an_entry->d_name;
+	if (has_extension(filename, JOB_EXTENSION)) job_filenames.push_back(filename);
+      }
+      ::closedir(directory);
+      std::sort(job_filenames.begin(), job_filenames.end());
+
+      for (std::size_t ijob = 0; ijob < job_filenames.size(); ijob++) {
+	const std::string name = job_filenames[ijob].substr(0, job_filenames[ijob].size() - JOB_EXTENSION.size());
+	// The rename is atomic, only one program of the spool claims the job :
+	if (std::rename(_path_(job_filenames[ijob]).c_str(), _path_(name + ".running").c_str()) != 0) continue;
+	std::ifstream job_file(_path_(name + ".running").c_str());
+	job_.name = name;
+	job_.arguments = parse_arguments(job_file);
+	return true;
+      }
+
+      std::this_thread::sleep_for(std::chrono::duration<double>(_poll_interval_));
+    }
+  return false;
+}
+
+void job_spool::finish_job(const job & job_, bool success_)
+{
+  const std::string status = success_ ? ".done" : ".failed";
+  DT_THROW_IF(std::rename(_path_(job_.name + ".running").c_str(), _path_(job_.name + status).c_str()) != 0,
+	      std::runtime_error, "Cannot rename job '" << job_.name << "' as " << status << " !");
+  return;
+}
+
+std::size_t job_spool::serve(const job_processor & processor_)
+{
+  std::size_t number_of_jobs = 0;
+  std::size_t number_of_failed_jobs = 0;
+  job a_job;
+  while (next_job(a_job))
+    {
+      std::clog << "INFO : Processing job '" << a_job.name << "'" << std::endl;
+      int exit_code = EXIT_FAILURE;
+      {
+	std::ofstream job_log(_path_(a_job.name + ".log").c_str());
+	output_redirection cout_redirection(std::cout, job_log.rdbuf());
+	output_redirection clog_redirection(std::clog, job_log.rdbuf());
+	output_redirection cerr_redirection(std::cerr, job_log.rdbuf());
+	try {
+	  exit_code = processor_(a_job.arguments);
+	}
+	catch (std::exception & error) {
+	  std::cerr << "ERROR : " << error.what() << std::endl;
+	}
+	catch (...) {
+	  std::cerr << "ERROR : Unexpected error !" << std::endl;
+	}
+      }
+      const bool success = exit_code == EXIT_SUCCESS;
+      finish_job(a_job, success);
+      number_of_jobs++;
+      if (!success) number_of_failed_jobs++;
+      std::clog << "INFO : Job '" << a_job.name << "' " << (success ? "done" : "FAILED") << std::endl;
+    }
+  std::clog << "INFO : Spool '" << _directory_ << "' stopped after " << number_of_jobs << " jobs ("
+	    << number_of_failed_jobs << " failed)" << std::endl;
+  return number_of_failed_jobs;
+}
+
+std::vector<std::string> job_spool::parse_arguments(std::istream & in_)
+{
+  std::vector<std::string> arguments;
+  std::string line;
+  while (std::getline(in_, line)) {
+    const std::size_t comment = line.find('#');
+    if (comment != std::string::npos) line.erase(comment);
+    std::istringstream line_in(line);
+    std::string an_argument;
+    while (line_in >> an_argument) arguments.push_back(an_argument);
+  }
+  return arguments;
+}
+
+std::string job_spool::_path_(const std::string & filename_) const
+{
+  return _directory_ + "/" + filename_;
+}
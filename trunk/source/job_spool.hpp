@@ -0,0 +1,108 @@
+//! \file job_spool.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Spool directory of jobs, processed one after the other by a long-lived
+// program keeping the geometry and the compiled mapping rules warm
+//
+
+#ifndef JOB_SPOOL_HPP
+#define JOB_SPOOL_HPP
+
+// Standard library:
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// This project :
+#include "geometry_context.hpp"
+#include "mapping_snapshot.hpp"
+
+//! \brief Geometry and compiled mapping rules shared by the jobs of a program
+struct job_context
+{
+  geometry_context geometry;
+  mapping_snapshot snapshot;
+  std::string snapshot_filename; ///< Cache file of the loaded snapshot
+  bool serving = false;          ///< Jobs of a spool are processed
+
+  /// Initialize the geometry, only for the first job (a full geometry has to be loaded by the first one)
+  void initialize_geometry(bool full_geometry_);
+
+  /// Load the snapshot of a mapping cache file, only if not already loaded
+  void load_snapshot(const std::string & filename_);
+
+  /// Store the snapshot in its mapping cache file if selectors were compiled
+  void store_snapshot() const;
+};
+
+//! \brief Spool directory of job files
+//
+// A job is a 'name.job' text file holding the command line options of
+// the program (one or more per line, '#' starts a comment). It is claimed
+// by renaming it 'name.running', so several programs can serve the same
+// spool, then renamed 'name.done' or 'name.failed'. Its output goes in
+// 'name.log'. The jobs are taken in the order of their names.
+//
+// Serving stops on SIGINT / SIGTERM or when a 'stop' file is created in
+// the spool, after the job in progress. A second SIGINT / SIGTERM stops
+// the program at once, the job in progress is left as 'name.running'.
+// The stop file is left in place to stop every program of the
+// spool, it has to be removed before serving again.
+class job_spool
+{
+public :
+
+  /// Job read from a spool
+  struct job
+  {
+    std::string name;                   ///< Name of the job file without extension
+    std::vector<std::string> arguments; ///< Command line options
+  };
+
+  /// Process the options of a job, return the exit code
+  typedef std::function<int(const std::vector<std::string> &)> job_processor;
+
+  /// Default constructor
+  job_spool();
+
+  /// Initialize with the spool directory and the polling interval in seconds
+  void initialize(const std::string & directory_, double poll_interval_ = 1.0);
+
+  /// Check initialization
+  bool is_initialized() const;
+
+  /// Check if a stop was requested by a signal or the stop file
+  bool is_stop_requested() const;
+
+  /// Wait for the next job and claim it, return false when stopped
+  bool next_job(job & job_);
+
+  /// Rename the claimed job as done or failed
+  void finish_job(const job & job_, bool success_);
+
+  /// Process the jobs until stopped, with the standard outputs in the job logs, return the number of failed jobs
+  std::size_t serve(const job_processor & processor_);
+
+  /// Read the options of a job file
+  static std::vector<std::string> parse_arguments(std::istream & in_);
+
+private :
+
+  /// Path of a file of the spool
+  std::string _path_(const std::string & filename_) const;
+
+  std::string _directory_;
+  double _poll_interval_ = 1.0;
+  bool _initialized_ = false;
+
+};
+
+#endif // JOB_SPOOL_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
@@ -0,0 +1,61 @@
+//! \file mapping_layout.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+
+// Ourselves:
+#include <mapping_layout.hpp>
+
+const std::string & mapping_layout::default_name()
+{
+  static const std::string _name("output");
+  return _name;
+}
+
+mapping_layout mapping_layout::parse(const std::string & description_)
+{
+  const std::size_t first_colon = description_.find(':');
+  const std::size_t second_colon = first_colon == std::string::npos ? std::string::npos : description_.find(':', first_colon + 1);
+  DT_THROW_IF(second_colon == std::string::npos,
+	      std::logic_error,
+	      "Invalid layout '" << description_ << "', expected 'name:calo_mapping_file:tracker_mapping_file' !");
+
+  mapping_layout layout;
+  layout.name = description_.substr(0, first_colon);
+  layout.calo_mapping_config = description_.substr(first_colon + 1, second_colon - first_colon - 1);
+  layout.tracker_mapping_config = description_.substr(second_colon + 1);
+  DT_THROW_IF(layout.name.empty(), std::logic_error, "Missing layout name in '" << description_ << "' !");
+  DT_THROW_IF(layout.name.find('/') != std::string::npos, std::logic_error, "Layout name '" << layout.name << "' is used in file names !");
+  return layout;
+}
+
+void mapping_layout::initialize(const geomtools::id_mgr & id_mgr_,
+				mapping_snapshot * snapshot_)
+{
+  if (snapshot_ != nullptr) {
+    snapshot_->initialize_selector(calo_selector, calo_mapping_config, id_mgr_, compiled_id_selector::calo_category());
+    snapshot_->initialize_selector(geiger_selector, tracker_mapping_config, id_mgr_, compiled_id_selector::geiger_category());
+    return;
+  }
+  calo_selector.initialize(calo_mapping_config, id_mgr_, compiled_id_selector::calo_category());
+  geiger_selector.initialize(tracker_mapping_config, id_mgr_, compiled_id_selector::geiger_category());
+  return;
+}
+
+void mapping_layout::dump(std::ostream & out_, const std::string & title_) const
+{
+  if (!title_.empty()) out_ << title_ << std::endl;
+  out_ << "|-- Name            : '" << name << "'" << std::endl;
+  out_ << "|-- Calo mapping    : '" << calo_mapping_config << "'" << std::endl;
+  out_ << "`-- Tracker mapping : '" << tracker_mapping_config << "'" << std::endl;
+  calo_selector.dump(out_, "Half commissioning calo selector: ");
+  geiger_selector.dump(out_, "Half commissioning Geiger selector: ");
+  return;
+}
@@ -0,0 +1,54 @@
+//! \file mapping_layout.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Named half commissioning mapping layout : a pair of calo and tracker
+// mapping rules (see resources/commissioning_mapping_example)
+//
+
+#ifndef MAPPING_LAYOUT_HPP
+#define MAPPING_LAYOUT_HPP
+
+// Standard library:
+#include <iostream>
+#include <string>
+
+// Third party:
+// - Bayeux/geomtools:
+#include <bayeux/geomtools/id_mgr.h>
+
+// This project :
+#include "compiled_id_selector.hpp"
+#include "mapping_snapshot.hpp"
+
+//! \brief Calo and tracker selectors of a named mapping layout
+struct mapping_layout
+{
+  /// Default name, gives the historical output_sorted*.brio file names
+  static const std::string & default_name();
+
+  /// Parse a "name:calo_mapping_file:tracker_mapping_file" layout description
+  static mapping_layout parse(const std::string & description_);
+
+  /// Compile the calo and tracker mapping rules, or take them from a snapshot if any
+  void initialize(const geomtools::id_mgr & id_mgr_,
+		  mapping_snapshot * snapshot_ = nullptr);
+
+  /// Print the layout and its selectors
+  void dump(std::ostream & out_, const std::string & title_ = "") const;
+
+  std::string name;
+  std::string calo_mapping_config;
+  std::string tracker_mapping_config;
+  compiled_id_selector calo_selector;
+  compiled_id_selector geiger_selector;
+
+};
+
+#endif // MAPPING_LAYOUT_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
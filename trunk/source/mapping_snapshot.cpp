@@ -0,0 +1,121 @@
+//! \file mapping_snapshot.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+
+// Ourselves:
+#include <mapping_snapshot.hpp>
+
+namespace {
+  const std::string SNAPSHOT_MAGIC = "#@hc_mapping_snapshot";
+  const int SNAPSHOT_VERSION = 1;
+}
+
+mapping_snapshot::mapping_snapshot()
+{
+}
+
+void mapping_snapshot::load(const std::string & filename_)
+{
+  _entries_.clear();
+  _modified_ = false;
+  std::ifstream in(filename_.c_str(), std::ios::binary);
+  if (!in) return;
+
+  std::string magic;
+  int version = 0;
+  in >> magic >> version;
+  DT_THROW_IF(magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION, std::logic_error,
+	      "File '" << filename_ << "' is not a mapping snapshot (version " << SNAPSHOT_VERSION << ") !");
+  std::size_t number_of_entries = 0;
+  in >> number_of_entries;
+  for (std::size_t ientry = 0; ientry < number_of_entries; ientry++) {
+    entry an_entry;
+    std::size_t rules_size = 0;
+    in >> an_entry.category >> rules_size;
+    in.get();
+    an_entry.rules.resize(rules_size);
+    if (rules_size > 0) in.read(&an_entry.rules[0], rules_size);
+    DT_THROW_IF(!in, std::logic_error, "Truncated mapping snapshot '" << filename_ << "' !");
+    an_entry.selector.load(in);
+    _entries_.push_back(an_entry);
+  }
+  return;
+}
+
+void mapping_snapshot::store(const std::string & filename_) const
+{
+  // Written aside then renamed, a concurrent run never reads a partial file :
+  const std::string tmp_filename = filename_ + ".tmp";
+  {
+    std::ofstream out(tmp_filename.c_str(), std::ios::binary);
+    DT_THROW_IF(!out, std::runtime_error, "Cannot create mapping snapshot '" << tmp_filename << "' !");
+    out << SNAPSHOT_MAGIC << ' ' << SNAPSHOT_VERSION << std::endl;
+    out << _entries_.size() << std::endl;
+    for (std::size_t ientry = 0; ientry < _entries_.size(); ientry++) {
+      const entry & an_entry = _entries_[ientry];
+      out << an_entry.category << ' ' << an_entry.rules.size() << std::endl;
+      out.write(an_entry.rules.data(), an_entry.rules.size());
+      out << std::endl;
+      an_entry.selector.store(out);
+    }
+    DT_THROW_IF(!out, std::runtime_error, "Cannot write mapping snapshot '" << tmp_filename << "' !");
+  }
+  DT_THROW_IF(std::rename(tmp_filename.c_str(), filename_.c_str()) != 0, std::runtime_error,
+	      "Cannot rename mapping snapshot '" << tmp_filename << "' !");
+  _modified_ = false;
+  return;
+}
+
+bool mapping_snapshot::is_modified() const
+{
+  return _modified_;
+}
+
+std::size_t mapping_snapshot::size() const
+{
+  return _entries_.size();
+}
+
+void mapping_snapshot::initialize_selector(compiled_id_selector & selector_,
+					   const std::string & mapping_config_,
+					   const geomtools::id_mgr & id_mgr_,
+					   const std::string & category_)
+{
+  // No mapping configuration : no selector to compile
+  selector_.reset();
+  if (mapping_config_.empty()) return;
+  std::ifstream ifile(mapping_config_.c_str(), std::ios::binary);
+  DT_THROW_IF(!ifile, std::logic_error, "Cannot open mapping configuration file '" << mapping_config_ << "' !");
+  std::ostringstream rules;
+  rules << ifile.rdbuf();
+  if (rules.str().empty()) return;
+
+  const uint32_t type = id_mgr_.get_category_info(category_).get_type();
+  for (std::size_t ientry = 0; ientry < _entries_.size(); ientry++) {
+    const entry & an_entry = _entries_[ientry];
+    if (an_entry.category != category_ || an_entry.rules != rules.str() || an_entry.selector.get_type() != type) continue;
+    selector_ = an_entry.selector;
+    return;
+  }
+
+  selector_.initialize(mapping_config_, id_mgr_, category_);
+  if (!selector_.is_initialized()) return;
+  entry an_entry;
+  an_entry.category = category_;
+  an_entry.rules = rules.str();
+  an_entry.selector = selector_;
+  _entries_.push_back(an_entry);
+  _modified_ = true;
+  return;
+}
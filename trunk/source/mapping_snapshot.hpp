@@ -0,0 +1,74 @@
+//! \file mapping_snapshot.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Compiled mapping rules cached in a file, reloaded by the next runs
+// instead of compiling the rules again
+//
+
+#ifndef MAPPING_SNAPSHOT_HPP
+#define MAPPING_SNAPSHOT_HPP
+
+// Standard library:
+#include <string>
+#include <vector>
+
+// Third party:
+// - Bayeux/geomtools:
+#include <bayeux/geomtools/id_mgr.h>
+
+// This project :
+#include "compiled_id_selector.hpp"
+
+//! \brief Cache of compiled selectors
+//
+// A selector is reused when the category, its geom ID type and the
+// text of the mapping configuration file are the same, so editing a
+// mapping file or changing the geometry compiles the rules again.
+class mapping_snapshot
+{
+public :
+
+  /// Default constructor
+  mapping_snapshot();
+
+  /// Load the selectors of a cache file, a missing file gives an empty cache
+  void load(const std::string & filename_);
+
+  /// Store the selectors in a cache file
+  void store(const std::string & filename_) const;
+
+  /// Check if selectors were compiled since the last load or store
+  bool is_modified() const;
+
+  /// Return the number of cached selectors
+  std::size_t size() const;
+
+  /// Initialize a selector from the cache, or compile it and add it to the cache
+  void initialize_selector(compiled_id_selector & selector_,
+			   const std::string & mapping_config_,
+			   const geomtools::id_mgr & id_mgr_,
+			   const std::string & category_);
+
+private :
+
+  /// Selector compiled from a mapping configuration
+  struct entry
+  {
+    std::string category;
+    std::string rules; ///< Text of the mapping configuration file
+    compiled_id_selector selector;
+  };
+
+  std::vector<entry> _entries_;
+  mutable bool _modified_ = false;
+
+};
+
+#endif // MAPPING_SNAPSHOT_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
@@ -0,0 +1,175 @@
+//! \file ordered_event_pipeline.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Parallel event loop : one reader thread, a pool of worker threads
+// and results committed in the input order by the calling thread
+//
+
+#ifndef ORDERED_EVENT_PIPELINE_HPP
+#define ORDERED_EVENT_PIPELINE_HPP
+
+// Standard library:
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/things.h>
+
+// This project :
+#include "bounded_queue.hpp"
+
+//! \brief Order preserving parallel event loop
+//
+// Event records are taken from a fixed pool of slots, so the number of
+// records in flight (and the memory) is bounded by the queue capacity.
+// The commit function is always called from the thread calling run(),
+// with the records in the order they were read : output modules are
+// not shared between threads and outputs are identical to a serial loop.
+// The read and commit functions may exchange the record of a slot with
+// another one (ex: prefetched records, background writer). The read
+// function gets the default result of the slot, where it can leave data
+// for the worker (ex: the position of a record the worker decodes).
+template <class Result>
+class ordered_event_pipeline
+{
+public :
+
+  /// Read the next record, return false when there is no more record
+  typedef std::function<bool(std::unique_ptr<datatools::things> & record_, Result & result_)> read_function_type;
+
+  /// Process a record in a worker thread
+  typedef std::function<void(std::size_t worker_, datatools::things & record_, Result & result_)> process_function_type;
+
+  /// Commit a processed record, in the input order
+  typedef std::function<void(std::unique_ptr<datatools::things> & record_, const Result & result_)> commit_function_type;
+
+  /// Constructor
+  ordered_event_pipeline(std::size_t number_of_workers_, std::size_t capacity_)
+    : _number_of_workers_(number_of_workers_ == 0 ? 1 : number_of_workers_),
+      _capacity_(capacity_ < _number_of_workers_ + 1 ? _number_of_workers_ + 1 : capacity_)
+  {
+  }
+
+  /// Return the number of worker threads
+  std::size_t get_number_of_workers() const
+  {
+    return _number_of_workers_;
+  }
+
+  /// Run the event loop until the read function returns false
+  void run(const read_function_type & read_,
+	   const process_function_type & process_,
+	   const commit_function_type & commit_)
+  {
+    std::vector<_slot_> slots(_capacity_);
+    bounded_queue<_slot_ *> free_slots(_capacity_);
+    bounded_queue<_slot_ *> work_queue(_capacity_);
+    bounded_queue<_slot_ *> done_queue(_capacity_);
+    for (std::size_t islot = 0; islot < slots.size(); islot++) {
+      slots[islot].record.reset(new datatools::things);
+      free_slots.push(&slots[islot]);
+    }
+
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto abort = [&] (std::exception_ptr error_) {
+      {
+	std::lock_guard<std::mutex> lock(error_mutex);
+	if (!error) error = error_;
+      }
+      free_slots.close();
+      work_queue.close();
+      done_queue.close();
+    };
+
+    std::thread reader([&] {
+	try {
+	  std::size_t sequence = 0;
+	  _slot_ * slot = nullptr;
+	  while (free_slots.pop(slot)) {
+	    if (!read_(slot->record, slot->result)) break;
+	    slot->sequence = sequence++;
+	    if (!work_queue.push(slot)) break;
+	  }
+	}
+	catch (...) {
+	  abort(std::current_exception());
+	}
+	work_queue.close();
+      });
+
+    std::atomic<std::size_t> running_workers(_number_of_workers_);
+    std::vector<std::thread> workers;
+    for (std::size_t iworker = 0; iworker < _number_of_workers_; iworker++) {
+      workers.push_back(std::thread([&, iworker] {
+	    try {
+	      _slot_ * slot = nullptr;
+	      while (work_queue.pop(slot)) {
+		process_(iworker, *slot->record, slot->result);
+		if (!done_queue.push(slot)) break;
+	      }
+	    }
+	    catch (...) {
+	      abort(std::current_exception());
+	    }
+	    if (--running_workers == 0) done_queue.close();
+	  }));
+    }
+
+    // Commit in the input order, records processed in advance wait in the pending map :
+    try {
+      std::map<std::size_t, _slot_ *> pending;
+      std::size_t next_sequence = 0;
+      _slot_ * slot = nullptr;
+      while (done_queue.pop(slot)) {
+	pending[slot->sequence] = slot;
+	for (typename std::map<std::size_t, _slot_ *>::iterator it = pending.begin();
+	     it != pending.end() && it->first == next_sequence;
+	     it = pending.erase(it)) {
+	  commit_(it->second->record, it->second->result);
+	  it->second->record->clear();
+	  it->second->result = Result();
+	  free_slots.push(it->second);
+	  next_sequence++;
+	}
+      }
+    }
+    catch (...) {
+      abort(std::current_exception());
+    }
+
+    reader.join();
+    for (std::size_t iworker = 0; iworker < workers.size(); iworker++) workers[iworker].join();
+    if (error) std::rethrow_exception(error);
+    return;
+  }
+
+private :
+
+  struct _slot_
+  {
+    std::size_t sequence = 0;
+    std::unique_ptr<datatools::things> record;
+    Result result;
+  };
+
+  const std::size_t _number_of_workers_;
+  const std::size_t _capacity_;
+
+};
+
+#endif // ORDERED_EVENT_PIPELINE_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
@@ -0,0 +1,180 @@
+//! \file process_scheduler.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <stdexcept>
+
+// POSIX :
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+
+// Ourselves:
+#include <process_scheduler.hpp>
+
+// This project :
+#include "processing_statistics.hpp"
+
+process_scheduler::process_scheduler()
+{
+}
+
+void process_scheduler::set_max_retries(std::size_t max_retries_)
+{
+  _max_retries_ = max_retries_;
+  return;
+}
+
+void process_scheduler::set_status_label(const std::string & label_)
+{
+  _status_label_ = label_;
+  return;
+}
+
+std::size_t process_scheduler::add_task(const task & task_)
+{
+  DT_THROW_IF(task_.arguments.empty(), std::logic_error, "Task '" << task_.name << "' has no program !");
+  _tasks_.push_back(task_);
+  return _tasks_.size() - 1;
+}
+
+const std::vector<process_scheduler::task> & process_scheduler::get_tasks() const
+{
+  return _tasks_;
+}
+
+std::size_t process_scheduler::run(std::size_t number_of_processes_)
+{
+  DT_THROW_IF(number_of_processes_ == 0, std::logic_error, "No process to run the tasks !");
+  const uint64_t run_start_ns = processing_statistics::wall_clock_ns();
+
+  // Largest tasks first, in the order they were added for the same cost :
+  std::vector<std::size_t> order(_tasks_.size());
+  for (std::size_t itask = 0; itask < order.size(); itask++) order[itask] = itask;
+  std::stable_sort(order.begin(), order.end(),
+		   [this] (std::size_t a_, std::size_t b_) { return _tasks_[a_].cost > _tasks_[b_].cost; });
+  std::deque<std::size_t> pending(order.begin(), order.end());
+
+  // Task and start time of each running process :
+  std::map<int, std::pair<std::size_t, uint64_t> > running;
+  std::size_t number_of_finished_tasks = 0;
+  while (!pending.empty() || !running.empty())
+    {
+      while (running.size() < number_of_processes_ && !pending.empty()) {
+	const std::size_t itask = pending.front();
+	pending.pop_front();
+	const int pid = _start_(_tasks_[itask]);
+	running[pid] = std::make_pair(itask, processing_statistics::wall_clock_ns());
+      }
+
+      int status = 0;
+      const int pid = ::waitpid(-1, &status, 0);
+      if (pid < 0) {
+	DT_THROW_IF(errno != EINTR, std::runtime_error, "Cannot wait for the worker processes : " << std::strerror(errno) << " !");
+	continue;
+      }
+      std::map<int, std::pair<std::size_t, uint64_t> >::iterator found = running.find(pid);
+      if (found == running.end()) continue;
+      const std::size_t itask = found->second.first;
+      task & a_task = _tasks_[itask];
+      a_task.wall_ns += processing_statistics::wall_clock_ns() - found->second.second;
+      running.erase(found);
+
+      if (WIFEXITED(status)) a_task.exit_status = WEXITSTATUS(status);
+      else if (WIFSIGNALED(status)) a_task.exit_status = -WTERMSIG(status);
+      else a_task.exit_status = -1;
+      a_task.success = a_task.exit_status == EXIT_SUCCESS;
+      _log_(a_task, _status_label_ + (a_task.success ? ":SUCCESS" : ":FAILED"));
+
+      if (!a_task.success && a_task.attempts <= _max_retries_) {
+	std::clog << "WARNING : Task '" << a_task.name << "' failed with status " << a_task.exit_status
+		  << ", retry " << a_task.attempts << "/" << _max_retries_ << std::endl;
+	pending.push_back(itask);
+	continue;
+      }
+      number_of_finished_tasks++;
+      std::clog << "INFO : [" << number_of_finished_tasks << "/" << _tasks_.size() << "] Task '" << a_task.name << "' "
+		<< (a_task.success ? "done" : "FAILED") << " in " << a_task.wall_ns * 1e-9 << " s" << std::endl;
+    }
+
+  _run_wall_ns_ = processing_statistics::wall_clock_ns() - run_start_ns;
+  std::size_t number_of_failed_tasks = 0;
+  for (std::size_t itask = 0; itask < _tasks_.size(); itask++) {
+    if (!_tasks_[itask].success) number_of_failed_tasks++;
+  }
+  return number_of_failed_tasks;
+}
+
+void process_scheduler::print_summary(std::ostream & out_) const
+{
+  std::size_t number_of_failed_tasks = 0;
+  uint64_t tasks_wall_ns = 0;
+  out_ << "Tasks :" << std::endl;
+  for (std::size_t itask = 0; itask < _tasks_.size(); itask++) {
+    const task & a_task = _tasks_[itask];
+    out_ << "  " << std::left << std::setw(40) << a_task.name << std::right << ' '
+	 << _status_label_ << (a_task.success ? ":SUCCESS" : ":FAILED")
+	 << " (" << a_task.attempts << (a_task.attempts > 1 ? " attempts, " : " attempt, ")
+	 << a_task.wall_ns * 1e-9 << " s)" << std::endl;
+    if (!a_task.success) number_of_failed_tasks++;
+    tasks_wall_ns += a_task.wall_ns;
+  }
+  out_ << "  Succeeded : " << _tasks_.size() - number_of_failed_tasks << " / " << _tasks_.size() << std::endl;
+  out_ << "  Wall time : " << _run_wall_ns_ * 1e-9 << " s";
+  // Average number of busy processes over the run :
+  if (_run_wall_ns_ > 0) out_ << ", " << static_cast<double>(tasks_wall_ns) / _run_wall_ns_ << " processes busy on average";
+  out_ << std::endl;
+  return;
+}
+
+int process_scheduler::_start_(task & task_)
+{
+  // Everything the child needs is prepared before the fork :
+  std::vector<char *> argv;
+  for (std::size_t iarg = 0; iarg < task_.arguments.size(); iarg++) argv.push_back(const_cast<char *>(task_.arguments[iarg].c_str()));
+  argv.push_back(nullptr);
+  task_.attempts++;
+  // The log of a previous run is replaced by the first attempt :
+  _log_(task_, "Attempt " + std::to_string(task_.attempts) + " : " + task_.arguments[0], task_.attempts == 1);
+  std::clog.flush();
+  std::cout.flush();
+
+  const int pid = ::fork();
+  DT_THROW_IF(pid < 0, std::runtime_error, "Cannot start task '" << task_.name << "' : " << std::strerror(errno) << " !");
+  if (pid == 0) {
+    const int log_fd = ::open(task_.log_filename.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (log_fd >= 0) {
+      ::dup2(log_fd, STDOUT_FILENO);
+      ::dup2(log_fd, STDERR_FILENO);
+      ::close(log_fd);
+    }
+    ::execvp(argv[0], argv.data());
+    // Only reached if the program could not be run :
+    const char message[] = "ERROR : Cannot run the program of the task !\n";
+    if (::write(STDERR_FILENO, message, sizeof(message) - 1) < 0) {}
+    ::_exit(127);
+  }
+  return pid;
+}
+
+void process_scheduler::_log_(const task & task_, const std::string & line_, bool truncate_) const
+{
+  std::ofstream log(task_.log_filename.c_str(), truncate_ ? std::ios::trunc : std::ios::app);
+  DT_THROW_IF(!log, std::runtime_error, "Cannot write the log file '" << task_.log_filename << "' of task '" << task_.name << "' !");
+  log << line_ << std::endl;
+  return;
+}
@@ -0,0 +1,87 @@
+//! \file process_scheduler.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Local pool of worker processes taking the files or shards of a run
+// from a shared queue, with retry of the failed tasks
+//
+
+#ifndef PROCESS_SCHEDULER_HPP
+#define PROCESS_SCHEDULER_HPP
+
+// Standard library:
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//! \brief Scheduler of tasks run as local processes
+//
+// Tasks are started largest cost first, and a process slot which
+// becomes free takes the next pending task : no slot is idle while
+// work remains, and the small tasks fill the tail of the run. A failed
+// task (non zero exit code or signal) goes back at the end of the queue
+// until its number of retries is exhausted.
+//
+// The standard outputs of a task are appended to its log file, which
+// ends with one 'LABEL:SUCCESS' or 'LABEL:FAILED' line per attempt.
+class process_scheduler
+{
+public :
+
+  /// Command run in its own process
+  struct task
+  {
+    std::string name;                   ///< Name in the reports
+    std::vector<std::string> arguments; ///< Program and its arguments
+    std::string log_filename;           ///< Standard outputs of the process
+    uint64_t cost = 0;                  ///< Scheduling weight (ex: input bytes), the largest tasks start first
+    std::size_t attempts = 0;           ///< Number of processes started
+    bool success = false;               ///< Last attempt succeeded
+    int exit_status = 0;                ///< Exit code of the last attempt, or -signal
+    uint64_t wall_ns = 0;               ///< Wall time of all attempts
+  };
+
+  /// Default constructor
+  process_scheduler();
+
+  /// Set the number of retries of a failed task
+  void set_max_retries(std::size_t max_retries_);
+
+  /// Set the label of the status lines (ex: FILE_ANALYZING)
+  void set_status_label(const std::string & label_);
+
+  /// Add a task, return its index
+  std::size_t add_task(const task & task_);
+
+  /// Return the tasks
+  const std::vector<task> & get_tasks() const;
+
+  /// Run all tasks with at most this number of processes at once, return the number of failed tasks
+  std::size_t run(std::size_t number_of_processes_);
+
+  /// Print the status of each task and the totals
+  void print_summary(std::ostream & out_) const;
+
+private :
+
+  /// Start a process for a task, return its pid
+  int _start_(task & task_);
+
+  /// Append a line to the log of a task, or replace the log with it
+  void _log_(const task & task_, const std::string & line_, bool truncate_ = false) const;
+
+  std::vector<task> _tasks_;
+  std::size_t _max_retries_ = 2;
+  std::string _status_label_ = "FILE_ANALYZING";
+  uint64_t _run_wall_ns_ = 0;
+
+};
+
+#endif // PROCESS_SCHEDULER_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --
@@ -0,0 +1,213 @@
+//! \file processing_statistics.cpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+
+// Standard library:
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+// System:
+#include <sys/resource.h>
+#include <time.h>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+
+// Ourselves:
+#include <processing_statistics.hpp>
+
+namespace {
+  double to_seconds(uint64_t ns_)
+  {
+    return ns_ * 1e-9;
+  }
+
+  std::string json_string(const std::string & value_)
+  {
+    std::string quoted = "\"";
+    for (std::size_t i = 0; i < value_.size(); i++) {
+      if (value_[i] == '"' || value_[i] == '\\') quoted += '\\';
+      quoted += value_[i];
+    }
+    quoted += '"';
+    return quoted;
+  }
+}
+
+processing_statistics::scoped_timer::scoped_timer(processing_statistics * statistics_, stage_type stage_)
+  : _statistics_(statistics_),
+    _stage_(stage_)
+{
+  if (_statistics_ == nullptr) return;
+  _wall_start_ns_ = wall_clock_ns();
+  _cpu_start_ns_ = thread_cpu_clock_ns();
+}
+
+processing_statistics::scoped_timer::~scoped_timer()
+{
+  if (_statistics_ == nullptr) return;
+  const uint64_t cpu_stop_ns = thread_cpu_clock_ns();
+  const uint64_t wall_stop_ns = wall_clock_ns();
+  _statistics_->add_time(_stage_, wall_stop_ns - _wall_start_ns_, cpu_stop_ns - _cpu_start_ns_);
+}
+
+const char * processing_statistics::stage_name(stage_type stage_)
+{
+  switch (stage_) {
+  case STAGE_READ           : return "read";
+  case STAGE_BANK_ACCESS    : return "bank_access";
+  case STAGE_CALO_MERGE     : return "calo_merge";
+  case STAGE_GEIGER_FLAG    : return "geiger_flag";
+  case STAGE_HISTOGRAM_FILL : return "histogram_fill";
+  case STAGE_BRIO_WRITE     : return "brio_write";
+  default : break;
+  }
+  return "unknown";
+}
+
+uint64_t processing_statistics::wall_clock_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t processing_statistics::thread_cpu_clock_ns()
+{
+  struct timespec now;
+  if (::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0) return 0;
+  return uint64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+uint64_t processing_statistics::peak_rss_kb()
+{
+  struct rusage usage;
+  if (::getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  // Linux reports the maximum resident set size in kB :
+  return usage.ru_maxrss;
+}
+
+void processing_statistics::reset()
+{
+  stages.fill(stage_timer());
+  run_wall_ns = 0;
+  number_of_events = 0;
+  number_of_calo_step_hits = 0;
+  number_of_geiger_step_hits = 0;
+  selections.clear();
+  return;
+}
+
+std::size_t processing_statistics::add_selection(const std::string & name_)
+{
+  for (std::size_t i = 0; i < selections.size(); i++) {
+    if (selections[i].name == name_) return i;
+  }
+  selection_counter selection;
+  selection.name = name_;
+  selections.push_back(selection);
+  return selections.size() - 1;
+}
+
+void processing_statistics::merge(const processing_statistics & other_)
+{
+  for (std::size_t i = 0; i < stages.size(); i++) {
+    stages[i].calls += other_.stages[i].calls;
+    stages[i].wall_ns += other_.stages[i].wall_ns;
+    stages[i].cpu_ns += other_.stages[i].cpu_ns;
+  }
+  // Threads of the same event loop run at the same time :
+  if (other_.run_wall_ns > run_wall_ns) run_wall_ns = other_.run_wall_ns;
+  number_of_events += other_.number_of_events;
+  number_of_calo_step_hits += other_.number_of_calo_step_hits;
+  number_of_geiger_step_hits += other_.number_of_geiger_step_hits;
+  for (std::size_t i = 0; i < other_.selections.size(); i++) {
+    selection_counter & selection = selections[add_selection(other_.selections[i].name)];
+    selection.accepted += other_.selections[i].accepted;
+    selection.rejected += other_.selections[i].rejected;
+  }
+  return;
+}
+
+void processing_statistics::merge_job(const processing_statistics & other_)
+{
+  // Jobs may have run one after the other, the events/s stay the ones of a single job :
+  const uint64_t jobs_run_wall_ns = run_wall_ns + other_.run_wall_ns;
+  merge(other_);
+  run_wall_ns = jobs_run_wall_ns;
+  return;
+}
+
+void processing_statistics::print(std::ostream & out_) const
+{
+  const double run_wall_s = to_seconds(run_wall_ns);
+  out_ << "Processing statistics :" << std::endl;
+  out_ << "  Events            : " << number_of_events << std::endl;
+  out_ << "  Calo step hits    : " << number_of_calo_step_hits << std::endl;
+  out_ << "  Geiger step hits  : " << number_of_geiger_step_hits << std::endl;
+  out_ << "  Event loop        : " << run_wall_s << " s";
+  if (run_wall_s > 0) out_ << ", " << number_of_events / run_wall_s << " events/s";
+  out_ << std::endl;
+  out_ << "  Peak RSS          : " << peak_rss_kb() << " kB" << std::endl;
+
+  // Stages of all threads, the sum can exceed the event loop time :
+  out_ << "  Stages (all threads) :" << std::endl;
+  out_ << "    " << std::left << std::setw(16) << "stage"
+       << std::right << std::setw(12) << "calls"
+       << std::setw(14) << "wall [s]"
+       << std::setw(14) << "cpu [s]"
+       << std::setw(16) << "wall/call [us]" << std::endl;
+  for (std::size_t i = 0; i < stages.size(); i++) {
+    const stage_timer & timer = stages[i];
+    out_ << "    " << std::left << std::setw(16) << stage_name(static_cast<stage_type>(i))
+	 << std::right << std::setw(12) << timer.calls
+	 << std::setw(14) << to_seconds(timer.wall_ns)
+	 << std::setw(14) << to_seconds(timer.cpu_ns)
+	 << std::setw(16) << (timer.calls > 0 ? timer.wall_ns * 1e-3 / timer.calls : 0.) << std::endl;
+  }
+
+  if (!selections.empty()) out_ << "  Selections (accepted / rejected events) :" << std::endl;
+  for (std::size_t i = 0; i < selections.size(); i++) {
+    out_ << "    " << std::left << std::setw(28) << selections[i].name << std::right
+	 << selections[i].accepted << " / " << selections[i].rejected << std::endl;
+  }
+  return;
+}
+
+void processing_statistics::store_json(const std::string & filename_) const
+{
+  std::ofstream out(filename_.c_str());
+  DT_THROW_IF(!out, std::runtime_error, "Cannot create processing statistics file '" << filename_ << "' !");
+  const double run_wall_s = to_seconds(run_wall_ns);
+  out << std::setprecision(9);
+  out << "{" << std::endl;
+  out << "  \"events\": " << number_of_events << "," << std::endl;
+  out << "  \"calo_step_hits\": " << number_of_calo_step_hits << "," << std::endl;
+  out << "  \"geiger_step_hits\": " << number_of_geiger_step_hits << "," << std::endl;
+  out << "  \"event_loop_wall_time_s\": " << run_wall_s << "," << std::endl;
+  out << "  \"events_per_second\": " << (run_wall_s > 0 ? number_of_events / run_wall_s : 0.) << "," << std::endl;
+  out << "  \"peak_rss_kb\": " << peak_rss_kb() << "," << std::endl;
+  out << "  \"stages\": {" << std::endl;
+  for (std::size_t i = 0; i < stages.size(); i++) {
+    const stage_timer & timer = stages[i];
+    out << "    " << json_string(stage_name(static_cast<stage_type>(i)))
+	<< ": {\"calls\": " << timer.calls
+	<< ", \"wall_time_s\": " << to_seconds(timer.wall_ns)
+	<< ", \"cpu_time_s\": " << to_seconds(timer.cpu_ns) << "}"
+	<< (i + 1 < stages.size() ? "," : "") << std::endl;
+  }
+  out << "  }," << std::endl;
+  out << "  \"selections\": {" << std::endl;
+  for (std::size_t i = 0; i < selections.size(); i++) {
+    out << "    " << json_string(selections[i].name)
+	<< ": {\"accepted\": " << selections[i].accepted
+	<< ", \"rejected\": " << selections[i].rejected << "}"
+	<< (i + 1 < selections.size() ? "," : "") << std::endl;
+  }
+  out << "  }" << std::endl;
+  out << "}" << std::endl;
+  DT_THROW_IF(!out, std::runtime_error, "Cannot write processing statistics file '" << filename_ << "' !");
+  return;
+}
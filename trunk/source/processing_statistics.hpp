@@ -0,0 +1,130 @@
+//! \file processing_statistics.hpp
+//
+// Copyright (c) 2017 by Guillaume Oliviéro <goliviero@lpccaen.in2p3.fr>
+//
+// Wall and CPU time of the event loop stages, event and step hit
+// counters and selection counters, reported at the end of a run
+//
+
+#ifndef PROCESSING_STATISTICS_HPP
+#define PROCESSING_STATISTICS_HPP
+
+// Standard library:
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//! \brief Timers and counters of the event loop
+//
+// One instance per thread, merged at the end of the run : no lock and
+// no atomic in the event loop. A timed stage costs two reads of the
+// monotonic clock and two of the thread CPU clock.
+struct processing_statistics
+{
+  /// Timed stages of the event loop
+  enum stage_type {
+    STAGE_READ           = 0, ///< Read an event record from the input files
+    STAGE_BANK_ACCESS    = 1, ///< Access to the SD bank of the record
+    STAGE_CALO_MERGE     = 2, ///< Merge the calo step hits by OM
+    STAGE_GEIGER_FLAG    = 3, ///< Flag the fired Geiger cells
+    STAGE_HISTOGRAM_FILL = 4, ///< Fill the histograms
+    STAGE_BRIO_WRITE     = 5, ///< Write the selected records in the brio files
+    NUMBER_OF_STAGES     = 6
+  };
+
+  /// Accumulated time of a stage
+  struct stage_timer
+  {
+    uint64_t calls = 0;
+    uint64_t wall_ns = 0;
+    uint64_t cpu_ns = 0;
+  };
+
+  /// Events accepted and rejected by a selection
+  struct selection_counter
+  {
+    std::string name;
+    uint64_t accepted = 0;
+    uint64_t rejected = 0;
+  };
+
+  //! \brief Time the scope as a stage, nothing is done without statistics
+  class scoped_timer
+  {
+  public :
+    scoped_timer(processing_statistics * statistics_, stage_type stage_);
+    ~scoped_timer();
+  private :
+    processing_statistics * _statistics_;
+    stage_type _stage_;
+    uint64_t _wall_start_ns_ = 0;
+    uint64_t _cpu_start_ns_ = 0;
+  };
+
+  /// Return the name of a stage
+  static const char * stage_name(stage_type stage_);
+
+  /// Return the monotonic clock in ns
+  static uint64_t wall_clock_ns();
+
+  /// Return the CPU time of the calling thread in ns
+  static uint64_t thread_cpu_clock_ns();
+
+  /// Return the peak resident set size of the process in kB
+  static uint64_t peak_rss_kb();
+
+  /// Reset
+  void reset();
+
+  /// Add a time to a stage
+  void add_time(stage_type stage_, uint64_t wall_ns_, uint64_t cpu_ns_)
+  {
+    stage_timer & timer = stages[stage_];
+    timer.calls++;
+    timer.wall_ns += wall_ns_;
+    timer.cpu_ns += cpu_ns_;
+  }
+
+  /// Return the index of a selection, added if needed
+  std::size_t add_selection(const std::string & name_);
+
+  /// Count an event accepted or rejected by a selection
+  void count_selection(std::size_t selection_, bool accepted_)
+  {
+    if (accepted_) selections[selection_].accepted++;
+    else selections[selection_].rejected++;
+  }
+
+  /// Add the timers and counters of another thread of the same run, the event loop time is the longest one
+  void merge(const processing_statistics & other_);
+
+  /// Add the timers and counters of another job (ex: another input file), the event loop times are added
+  void merge_job(const processing_statistics & other_);
+
+  /// Print a text report
+  void print(std::ostream & out_) const;
+
+  /// Store a JSON report
+  void store_json(const std::string & filename_) const;
+
+  // Timers :
+  std::array<stage_timer, NUMBER_OF_STAGES> stages;
+  uint64_t run_wall_ns = 0; ///< Wall time of the whole event loop, set by the program (sum of the merged jobs)
+
+  // Counters :
+  uint64_t number_of_events = 0;
+  uint64_t number_of_calo_step_hits = 0;
+  uint64_t number_of_geiger_step_hits = 0;
+  std::vector<selection_counter> selections;
+
+};
+
+#endif // PROCESSING_STATISTICS_HPP
+
+// Local Variables: --
+// Mode: c++ --
+// c-file-style: "gnu" --
+// tab-width: 2 --
+// End: --